@@ -35,8 +35,8 @@ uint16_t  gu16AdcSample;
 stAdcSnsrData_t stAdcChA4 =
 {
      .ubyChNum     = ADC_CHA4,
-     .u16AdcChVal  = NULL,
-     .fAdcXformVal = NULL,
+     .u16AdcChVal  = 0,
+     .fAdcXformVal = 0,
      .ubyPwmNum    = 4,             // RTD4 controls fan driven by CCR2
      .ubyFanIndex  = 1,
      .bSelfTemp    = false
@@ -45,8 +45,8 @@ stAdcSnsrData_t stAdcChA4 =
 stAdcSnsrData_t stAdcChA5 =
 {
      .ubyChNum     = ADC_CHA5,
-     .u16AdcChVal  = NULL,
-     .fAdcXformVal = NULL,
+     .u16AdcChVal  = 0,
+     .fAdcXformVal = 0,
      .ubyPwmNum    = 5,             // RTD5 controls fan driven by CCR1
      .ubyFanIndex  = 0,
      .bSelfTemp    = false
@@ -55,8 +55,8 @@ stAdcSnsrData_t stAdcChA5 =
 stAdcSnsrData_t stAdcChA8 =
 {
      .ubyChNum     = ADC_CHA8,
-     .u16AdcChVal  = NULL,
-     .fAdcXformVal = NULL,
+     .u16AdcChVal  = 0,
+     .fAdcXformVal = 0,
      .ubyPwmNum    = 0,
      .bSelfTemp    = false
 };
@@ -64,8 +64,8 @@ stAdcSnsrData_t stAdcChA8 =
 stAdcSnsrData_t stAdcChA9 =
 {
      .ubyChNum     = ADC_CHA9,
-     .u16AdcChVal  = NULL,
-     .fAdcXformVal = NULL,
+     .u16AdcChVal  = 0,
+     .fAdcXformVal = 0,
      .ubyPwmNum    = 1,
      .bSelfTemp    = false
 };
@@ -73,8 +73,8 @@ stAdcSnsrData_t stAdcChA9 =
 stAdcSnsrData_t stAdcChA10 =
 {
      .ubyChNum     = ADC_CHA10,
-     .u16AdcChVal  = NULL,
-     .fAdcXformVal = NULL,
+     .u16AdcChVal  = 0,
+     .fAdcXformVal = 0,
      .ubyPwmNum    = 2,
      .bSelfTemp    = false
 };
@@ -82,8 +82,8 @@ stAdcSnsrData_t stAdcChA10 =
 stAdcSnsrData_t stAdcChA11 =
 {
      .ubyChNum     = ADC_CHA11,
-     .u16AdcChVal  = NULL,
-     .fAdcXformVal = NULL,
+     .u16AdcChVal  = 0,
+     .fAdcXformVal = 0,
      .ubyPwmNum    = 3,
      .bSelfTemp    = false
 };
@@ -91,8 +91,8 @@ stAdcSnsrData_t stAdcChA11 =
 stAdcSnsrData_t stAdcChA12 =
 {
      .ubyChNum     = ADC_ON_CHIP_TMP_SNSR,
-     .u16AdcChVal  = NULL,
-     .fAdcXformVal = NULL
+     .u16AdcChVal  = 0,
+     .fAdcXformVal = 0
 };
 
 
@@ -100,8 +100,8 @@ stAdcSnsrData_t stAdcChA12 =
 stAdcSnsrData_t gstAdcChAx =
 {
      .ubyChNum     = 0,
-     .u16AdcChVal  = NULL,
-     .fAdcXformVal = NULL
+     .u16AdcChVal  = 0,
+     .fAdcXformVal = 0
 };
 
 // make sure ADC_NUM_OF_CHS_ENABLED is equal to the initialization elements.
@@ -125,6 +125,7 @@ stAdcSnsrData_t* gastAdcChServiceTbl[ADC_NUM_OF_CHS_ENABLED] =
                             {&stAdcChA12, &stAdcChA5, &stAdcChA4};
 
 stAdcSnsrData_t* pgstAdcChActive;
+uint8_t          gubyAdcChActiveIndx;   // index of pgstAdcChActive in gastAdcChServiceTbl[]
 
 stTimerStruct_t stAdcAcquistionTmr =
 {
@@ -647,7 +648,8 @@ uint16_t adcReadFromChsCb(stTimerStruct_t* myTimer)
     ADC_enableDisableConversion(ADC_CONVERSION_DISABLE);     // ADCCTL0:ADCENC;
 
     // get pointer for next adc channel parameter from the table
-    pgstAdcChActive = gastAdcChServiceTbl[ubyIndex++];
+    gubyAdcChActiveIndx = ubyIndex;
+    pgstAdcChActive     = gastAdcChServiceTbl[ubyIndex++];
 
     /*
      * On-chip temp sensor is required to use one of the available Internal
@@ -722,9 +724,9 @@ void deInitAdc()
     ADC_moduleEnableDisable(ADC_MODULE_DISABLE);
 
     // configure port for gpio usage
-    // CH[7:0]
-    P1SEL0 &= ~0xFF;
-    P1SEL1 &= ~0xFF;
+    // CH[7:0]; the whole port
+    P1SEL0 = 0x00;
+    P1SEL1 = 0x00;
 
     // CH[11:8]
     P5SEL0 &= ~0x0F;
@@ -86,8 +86,11 @@ typedef struct ADC_CH_DATA
 
 // on-chip temperature calibration data
 // see section 1.13.3.3 of user's manual, slau445i.pdf
+// the host simulator (sim/) supplies its own calibration
+#ifndef ADC_30C_AT_1_5V_REF
 #define ADC_30C_AT_1_5V_REF             *((unsigned int *)0x1A1A)
 #define ADC_105C_AT_1_5V_REF            *((unsigned int *)0x1A1C)
+#endif
 
 /*
  * we will need to use these two formulas to generate a transformation
@@ -189,6 +192,8 @@ extern uint16_t  gau16TempVal[];
 extern stTimerStruct_t stAdcAcquistionTmr;
 extern stAdcSnsrData_t* gastAdcChServiceTbl[];
 extern stAdcSnsrData_t* pgstAdcChActive;
+extern uint8_t          gubyAdcChActiveIndx;
+
 extern stAdcSnsrData_t gstAdcChAx;
 
 extern stAdcSnsrData_t stAdcChA4;
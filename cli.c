@@ -8,7 +8,6 @@
 #include <msp430.h>
 #include <stdint.h>
 #include <stdlib.h>
-#include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdbool.h>
@@ -23,7 +22,12 @@
 #include "rtd.h"
 #include "thermalcontrol.h"
 #include "fans.h"
+#include "fanhealth.h"
+#include "telemetry.h"
+#include "power.h"
+#include "selftest.h"
 #include "bsl.h"
+#include "fmt.h"
 
 
 #define DIAG_TMR_TO_VAL         10      // default timeout val
@@ -35,54 +39,96 @@
 //#define DIAG_DISPLAY_INTERVAL_PERIOD  1000    // timeout val when diag's running
 
 char achCmdLineBuff[SERIAL_BUFFER_SZ];
-static uint8_t ubyCmdLineBuffIndx;
 bool gbDiagTimeoutChanged;
 bool gbResetDiagTmr = false;
 bool bIsDiagActive = false;
 
 eDiagTmrState_t geDiagTmrUpdateState;
 
-float    fDummyTestNum1    = 25.6;
-float    fDummyTestNum2    = 0.5;
-uint16_t ui16DummyTestNum1 = 29;
-
-int16_t  getFract(float fNum);
-uint16_t getInt(float fNum);
-int16_t  i16NumOfZeros;
-
-stTimerStruct_t gstCopySeralCmdToCmdBuffTmr =
+stDiagSub_t gstDiagSub =
 {
-    .prevTimer  = NULL,
-    .timeoutTickCnt  = 5,
-    .counter    = 0,
-    .recurrence = TIMER_SINGLE,
-    .status     = TIMER_DISABLED,
-    .callback   = cpySerialCmd2CmdBuf,
-    .nextTimer  = NULL
+    .u32Mask     = DIAG_ALL_MASK,
+    .u16PeriodMs = DIAG_DISPLAY_INTERVAL_PERIOD,
+    .bDeltaOnly  = false,
+    .bFull       = true
 };
 
-stTimerStruct_t stSerialCmdMakeTokensTmr =
+/*
+ * the diag frame, in eDiagElement_t order; a field is a row here and its
+ *  enum entry. a label row starts a group that runs to the next label.
+ *  fan values are indexed by fan; a row left out (pvData NULL) is not sent.
+ */
+const stDiagDesc_t gastDiagDesc[DIAG_ELEMENT_COUNT] =
 {
-    .prevTimer  = NULL,
-    .timeoutTickCnt  = 10,
-    .counter    = 0,
-    .recurrence = TIMER_SINGLE,
-    .status     = TIMER_DISABLED,
-    .callback   = makeTokens,
-    .nextTimer  = NULL
+    [DIAG_PWM_0TO5_TEXT]            = {"PwmCpuGpu: ",          NULL,                                      DIAG_TEXT_TYPE,  0},
+    [DIAG_PWM5]                     = {NULL,                   &gastFanPwm[0].u16OutPm,                   DIAG_UINT_TYPE,  1},  // PWM5 TB3.1, P6.0, Ch5
+#if NUM_FANS > 1
+    [DIAG_PWM4]                     = {NULL,                   &gastFanPwm[1].u16OutPm,                   DIAG_UINT_TYPE,  1},  // PWM4 TB3.2, P6.1, Ch4
+#endif
+
+    [DIAG_FTACH_5and4_TEXT]         = {"FtachPrt4_0,1: ",      NULL,                                      DIAG_TEXT_TYPE,  0},
+    [DIAG_CPU_FTACH5_RPM5]          = {NULL,                   &stFanTach[0].u16RpmPrevious,              DIAG_UINT_TYPE,  0},
+#if NUM_FANS > 1
+    [DIAG_GPU_FTACH4_RPM4]          = {NULL,                   &stFanTach[1].u16RpmPrevious,              DIAG_UINT_TYPE,  0},
+#endif
+
+    [DIAG_TEMP_RTD_TEXT]            = {"RtdAvgIntCpuGpu: ",    NULL,                                      DIAG_TEXT_TYPE,  0},
+    [DIAG_RTD_TEMP_AVG]             = {NULL,                   &gfRtdTempAvg,                             DIAG_FLOAT_TYPE, 2},
+    [DIAG_ON_CHIP_CH12]             = {NULL,                   &stAdcChA12.fAdcXformVal,                  DIAG_FLOAT_TYPE, 2},
+    [DIAG_RTD_CH5]                  = {NULL,                   &stAdcChA5.fAdcXformVal,                   DIAG_FLOAT_TYPE, 2},
+    [DIAG_RTD_CH4]                  = {NULL,                   &stAdcChA4.fAdcXformVal,                   DIAG_FLOAT_TYPE, 2},
+
+    [DIAG_TEMP_ZONE_TEXT]           = {"PwmActiveZn#CpuGpu: ", NULL,                                      DIAG_TEXT_TYPE,  0},
+    [DIAG_PWM5_ZONE_NUM]            = {NULL,                   &gubyCurrentTz[0],                         DIAG_UINT8_TYPE, 0},
+#if NUM_FANS > 1
+    [DIAG_PWM4_ZONE_NUM]            = {NULL,                   &gubyCurrentTz[1],                         DIAG_UINT8_TYPE, 0},
+#endif
+
+    [DIAG_TEMP_RTD_ADC_TEXT]        = {"RtdAdcIntCpuGpu: ",    NULL,                                      DIAG_TEXT_TYPE,  0},
+    [DIAG_ON_CHIP_ADC_CH12]         = {NULL,                   &stAdcChA12.u16AdcChVal,                   DIAG_UINT_TYPE,  0},
+    [DIAG_RTD_ADC_CH5]              = {NULL,                   &stAdcChA5.u16AdcChVal,                    DIAG_UINT_TYPE,  0},
+    [DIAG_RTD_ADC_CH4]              = {NULL,                   &stAdcChA4.u16AdcChVal,                    DIAG_UINT_TYPE,  0},
+
+    [DIAG_2RTD_ADC_SELF_CPY_TMP_TEXT] = {"TempSelfCpyCpuGpu: ", NULL,                                     DIAG_TEXT_TYPE,  0},
+    [DIAG_RTD_TEMP_CH4_0_CPU_SELF]  = {NULL,                   &stAdcChA5.bSelfTemp,                      DIAG_BOOL_TYPE,  0},
+    [DIAG_RTD_TEMP_CH4_1_GPU_SELF]  = {NULL,                   &stAdcChA4.bSelfTemp,                      DIAG_BOOL_TYPE,  0}
 };
 
-stTimerStruct_t stSerialCmdTokenExecuteTmr =
+// float scale per ubyPlaces
+static const uint16_t au16DiagPow10[] = {1, 10, 100, 1000, 10000};
+
+// set diag fields names; fanN is the values of one fan and its sensor
+typedef struct DIAG_SEL
 {
-    .prevTimer  = NULL,
-    .timeoutTickCnt  = 10,
-    .counter    = 0,
-    .recurrence = TIMER_SINGLE,
-    .status     = TIMER_DISABLED,
-    .callback   = executeUartCmd,
-    .nextTimer  = NULL
+    const char* pchName;
+    uint32_t    u32Mask;
+}stDiagSel_t;
+
+static const stDiagSel_t astDiagSel[] =
+{
+    {"all",  DIAG_ALL_MASK},
+    {"pwm",  DIAG_BIT(DIAG_PWM5) | DIAG_BIT(DIAG_PWM4)},
+    {"rpm",  DIAG_BIT(DIAG_CPU_FTACH5_RPM5) | DIAG_BIT(DIAG_GPU_FTACH4_RPM4)},
+    {"temp", DIAG_BIT(DIAG_RTD_TEMP_AVG) | DIAG_BIT(DIAG_ON_CHIP_CH12) |
+             DIAG_BIT(DIAG_RTD_CH5) | DIAG_BIT(DIAG_RTD_CH4)},
+    {"zone", DIAG_BIT(DIAG_PWM5_ZONE_NUM) | DIAG_BIT(DIAG_PWM4_ZONE_NUM)},
+    {"adc",  DIAG_BIT(DIAG_ON_CHIP_ADC_CH12) | DIAG_BIT(DIAG_RTD_ADC_CH5) | DIAG_BIT(DIAG_RTD_ADC_CH4)},
+    {"self", DIAG_BIT(DIAG_RTD_TEMP_CH4_0_CPU_SELF) | DIAG_BIT(DIAG_RTD_TEMP_CH4_1_GPU_SELF)},
+    {"fan0", DIAG_BIT(DIAG_PWM5) | DIAG_BIT(DIAG_CPU_FTACH5_RPM5) | DIAG_BIT(DIAG_RTD_CH5) |
+             DIAG_BIT(DIAG_PWM5_ZONE_NUM) | DIAG_BIT(DIAG_RTD_ADC_CH5) | DIAG_BIT(DIAG_RTD_TEMP_CH4_0_CPU_SELF)},
+    {"fan1", DIAG_BIT(DIAG_PWM4) | DIAG_BIT(DIAG_GPU_FTACH4_RPM4) | DIAG_BIT(DIAG_RTD_CH4) |
+             DIAG_BIT(DIAG_PWM4_ZONE_NUM) | DIAG_BIT(DIAG_RTD_ADC_CH4) | DIAG_BIT(DIAG_RTD_TEMP_CH4_1_GPU_SELF)}
 };
+#define NUM_DIAG_SELS   (sizeof(astDiagSel) / sizeof(astDiagSel[0]))
 
+// last value sent per element, as displayed; for delta only
+static uint32_t au32DiagLast[DIAG_ELEMENT_COUNT];
+
+float    fDummyTestNum1    = 25.6;
+float    fDummyTestNum2    = 0.5;
+uint16_t ui16DummyTestNum1 = 29;
+
+static void diagSetPeriod(uint16_t u16PeriodMs);
 
 stTimerStruct_t stDiagnosticsDataTmr =
 {
@@ -118,12 +164,48 @@ stTimerStruct_t stBslLaunchTmr =
     .nextTimer        = NULL
 };
 
+// set baud; the new rate is taken once the reply is out and kept once a line comes in at it
+static uint32_t u32CliBaudNew;
+static uint32_t u32CliBaudPrev;
+
+stTimerStruct_t stBaudConfirmTmr =
+{
+    .prevTimer        = NULL,
+    .timeoutTickCnt   = UART_BAUD_CONFIRM_MS,
+    .counter          = 0,
+    .recurrence       = TIMER_SINGLE,
+    .status           = TIMER_DISABLED,
+    .callback         = baudConfirmCb,
+    .nextTimer        = NULL
+};
+
+// no line at the new rate; back to the previous one
+uint16_t baudConfirmCb(stTimerStruct_t* myTimer)
+{
+    UART_SetBaud(UART_CLI, u32CliBaudPrev);
+    UART_putStringSerial("\r\nbaud not confirmed; reverted");
+    UART_printNewLineAndPrompt();
+
+    return 0;
+}
+
+// the reply went out at the old rate
+static void cliBaudApply(void)
+{
+    u32CliBaudPrev = UART_getBaud(UART_CLI);
+    UART_SetBaud(UART_CLI, u32CliBaudNew);
+    enableDisableTimer(&stBaudConfirmTmr, TMR_ENABLE);
+    UART_printNewLineAndPrompt();
+}
+
 uint16_t updateCmdCb(stTimerStruct_t* myTimer)
 {
+    char achAnswer[4];
     char c;
 
-    while(gstMainEvts.bits.svcUartRx == false);
-    c= achUartInputBuffer[0];
+    while(UART_rxLineReady(UART_CLI) == false);
+    UART_getLine(UART_CLI, achAnswer, sizeof(achAnswer));
+    c= achAnswer[0];
     c = tolower(c);
 
     if (c == 'y')
@@ -149,25 +231,44 @@ typedef struct CLI_CMDS
 }stCliCmds_t;
 
 stCliCmds_t astCliCmds[NUM_CMDS];
-char* achTokenArray[MAX_CMD_LENGTH];
+char* achTokenArray[MAX_CMD_LENGTH + 1];    // last entry is the NULL marker
 uint8_t ubyTokenIndex;
 
-uint16_t cpySerialCmd2CmdBuf(stTimerStruct_t* myTimer)
+/*
+ * cliSvcCmdLine(): a line is complete (svcUartRx). it is taken out of the
+ *  uart input ring, tokenized and dispatched in this one event; the rx isr
+ *  keeps filling the ring meanwhile. one line per event, the rest are
+ *  left for the next pass of main_events().
+ */
+void cliSvcCmdLine(void)
 {
-    ubyCmdLineBuffIndx = 0;
+    gstMainEvts.bits.svcUartRx = false;
 
-    do
+    if (UART_getLine(UART_CLI, achCmdLineBuff, sizeof(achCmdLineBuff)))
     {
-        achCmdLineBuff[ubyCmdLineBuffIndx++] = achUartInputBuffer[ubyUrtInBuffUnLdIndx];
-    }while(achUartInputBuffer[ubyUrtInBuffUnLdIndx++] != NULL);
-
-    ubyUrtInBuffUnLdIndx = 0;
-    ubyUrtInBuffLdrIndx  = 0;
+        // a line came in at the new rate
+        if (stBaudConfirmTmr.status == TIMER_RUNNING)
+        {
+            enableDisableTimer(&stBaudConfirmTmr, TMR_DISABLE);
+        }
 
-    UART_EnableDisableRxInt(UART_ENABLE_RXINT);
-    enableDisableTimer(&stSerialCmdMakeTokensTmr, TMR_ENABLE);
+        CYCLE_BENCH_START(BENCH_CLI_CMD);
+        if (makeTokens() != 0)
+        {
+            executeUartCmd();
+        }
+        else
+        {
+            UART_putStringSerial("Unrecognized Command!");
+            UART_printNewLineAndPrompt();
+        }
+        CYCLE_BENCH_STOP(BENCH_CLI_CMD);
+    }
 
-    return 0;
+    if (UART_rxLineReady(UART_CLI))
+    {
+        gstMainEvts.bits.svcUartRx = true;
+    }
 }
 
 
@@ -181,14 +282,12 @@ uint16_t cpySerialCmd2CmdBuf(stTimerStruct_t* myTimer)
  *       etc
  *  what is loadded in cliCMDS table is the main command.
  *
- *  lineBuff[] buffer can be considered as a command line buffer.
- *  characters stored @ InBuff by UART-RxISR, are copied in lineBuff
- *   array. The length of characters copied is upto reaching a <CR>
- *   control character.
+ *  achCmdLineBuff[] buffer can be considered as a command line buffer.
+ *  complete lines stored @ the UART_CLI input ring by UART-RxISR are moved
+ *   into achCmdLineBuff, one line per svcUartRx event.
  *
- *  cliStat and prevCliState are states used by processCli() function
- *   to copy chars from InBuff to lineBuff, parse command line and
- *   launch a callback function for execution.
+ *  cliSvcCmdLine() moves the line, parses it into tokens and launches
+ *   the command callback for execution.
  *
  *  eUSCI0 is the UART used for this comms and it's baud rate is
  *   configured for 115,200 baud with no parity, 8-bits data,
@@ -202,14 +301,11 @@ void initCli()
     astCliCmds[2].pchCmdString = "update"   ; astCliCmds[2].pCbUartCmdHdlr = updateCMD;
     astCliCmds[3].pchCmdString = "man"      ; astCliCmds[3].pCbUartCmdHdlr = manCMD;
 
-
-    registerTimer(&gstCopySeralCmdToCmdBuffTmr);
-    registerTimer(&stSerialCmdMakeTokensTmr);
-    registerTimer(&stSerialCmdTokenExecuteTmr);
+    registerTimer(&stBaudConfirmTmr);
 }
 
 
-uint16_t executeUartCmd(stTimerStruct_t* myTimer)
+uint16_t executeUartCmd(void)
 {
     uint16_t i;
 
@@ -228,30 +324,36 @@ uint16_t executeUartCmd(stTimerStruct_t* myTimer)
 
 void getCMD()
 {
-    char    achStringBuff[256];
     bool    bIsCmdGood = false;
     volatile uint8_t ubyIndexFan;
     volatile uint8_t ubyIndexZone;
 
-    // %f has been deprecated from sprinf()
+    // replies are formatted in the output ring (fmt.c); no sprintf
     if((strcmp((const char*)achTokenArray[1],"pwm") == 0) && (ubyTokenIndex == 2))
     {
-        UART_putStringSerial("\r\nCurrent Temp Zone & PWM settings\r\nFan#   TZ   PWM%");
-
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nCurrent Temp Zone & PWM settings\r\nFan#   TZ   PWM%");
         for(ubyIndexFan=0; ubyIndexFan<NUM_FANS; ubyIndexFan++)
         {
-            sprintf (achStringBuff, "\r\n %d      %d     %d",ubyIndexFan, gubyCurrentTz[ubyIndexFan], fFanPwm[ubyIndexFan][gubyCurrentTz[ubyIndexFan]]);
-            UART_putStringSerial(achStringBuff);
+            fmtStr("\r\n ");
+            fmtUint(ubyIndexFan, 0);
+            fmtStr("      ");
+            fmtUint(gubyCurrentTz[ubyIndexFan], 0);
+            fmtStr("     ");
+            fmtUint(fFanPwm[ubyIndexFan][gubyCurrentTz[ubyIndexFan]], 0);
         }
-        sprintf (achStringBuff, "\r\n");
-        UART_putStringSerial(achStringBuff);
+        fmtStr("\r\n");
+        fmtEnd(UART_STREAM_CLI, false);
         UART_printNewLineAndPrompt();
         bIsCmdGood = true;
     }
     else if((strcmp((const char*)achTokenArray[1],"hyst") == 0)&& (ubyTokenIndex == 2))
     {
-        sprintf(achStringBuff, "current set temperature hysteresis = %d, ", ubyTempHysteresis);
-        UART_putStringSerial(achStringBuff);
+        fmtBegin(UART_CLI);
+        fmtStr("current set temperature hysteresis = ");
+        fmtUint(ubyTempHysteresis, 0);
+        fmtStr(", ");
+        fmtEnd(UART_STREAM_CLI, false);
         UART_printNewLineAndPrompt();
         bIsCmdGood = true;
     }
@@ -260,120 +362,434 @@ void getCMD()
     // set pwm pwm# zone# val
     else if((strcmp((const char*)achTokenArray[1],"pwms") == 0) && (ubyTokenIndex == 2))
     {
-        sprintf (achStringBuff, "Fan# Zones [0-%d]\r\n", NUM_TZONES-1);
-        UART_putStringSerial(achStringBuff);
+        fmtBegin(UART_CLI);
+        fmtStr("Fan# Zones [0-");
+        fmtUint(NUM_TZONES-1, 0);
+        fmtStr("]\r\n");
         for(ubyIndexFan=0; ubyIndexFan<NUM_FANS; ubyIndexFan++)
         {
-            sprintf (achStringBuff, "  %d:[", ubyIndexFan);
-            UART_putStringSerial(achStringBuff);
+            fmtStr("  ");
+            fmtUint(ubyIndexFan, 0);
+            fmtStr(":[");
             for(ubyIndexZone=0; ubyIndexZone<NUM_TZONES; ubyIndexZone++)
             {
-                if(ubyIndexZone == NUM_TZONES-1)
+                fmtUint(fFanPwm[ubyIndexFan][ubyIndexZone], 0);
+                if(ubyIndexZone != NUM_TZONES-1)
                 {
-                    sprintf (achStringBuff, "%d",fFanPwm[ubyIndexFan][ubyIndexZone]);
+                    fmtChar(',');
                 }
-                else
-                {
-                    sprintf (achStringBuff, "%d,",fFanPwm[ubyIndexFan][ubyIndexZone]);
-                }
-                UART_putStringSerial(achStringBuff);
             }
-            sprintf (achStringBuff, "]\r\n");
-            UART_putStringSerial(achStringBuff);
+            fmtStr("]\r\n");
         }
+        fmtEnd(UART_STREAM_CLI, false);
         UART_printNewLineAndPrompt();
         bIsCmdGood = true;
     }
     // Example: 'get thresholds'
     else if((strcmp((const char*)achTokenArray[1],"tempthresh") == 0)&& (ubyTokenIndex == 2))
     {
-
-        sprintf (achStringBuff, "Z#0 L=%d  H=%d \r\n", getInt(fTz[0][0]), getInt(fTz[0][1]));    // cold zone
-        UART_putStringSerial(achStringBuff);
-        sprintf (achStringBuff, "Z#1 L=%d  H=%d \r\n", getInt(fTz[1][0]), getInt(fTz[1][1]));    // normal zone 1
-        UART_putStringSerial(achStringBuff);
-        sprintf (achStringBuff, "Z#2 L=%d   H=%d \r\n", getInt(fTz[2][0]), getInt(fTz[2][1]));    // normal zone 2
-        UART_putStringSerial(achStringBuff);
-        sprintf (achStringBuff, "Z#3 L=%d   H=%d \r\n", getInt(fTz[3][0]), getInt(fTz[3][1]));    // normal zone 2
-        UART_putStringSerial(achStringBuff);
-        sprintf (achStringBuff, "Z#4 L=%d   H=%d \r\n", getInt(fTz[4][0]), getInt(fTz[4][1]));    // normal zone 2
-        UART_putStringSerial(achStringBuff);
-        sprintf (achStringBuff, "Z#5 L=%d   H=%d \r\n", getInt(fTz[5][0]), getInt(fTz[5][1]));    // normal zone 2
-        UART_putStringSerial(achStringBuff);
-        sprintf (achStringBuff, "Z#6 L=%d   H=%d \r\n", getInt(fTz[6][0]), getInt(fTz[6][1]));    // high zone
-        UART_putStringSerial(achStringBuff);
-        sprintf (achStringBuff, "Z#7 L=%d   H=%d \r\n\n", getInt(fTz[7][0]), getInt(fTz[7][1]));    // extreme/max zone
-        UART_putStringSerial(achStringBuff);
-        sprintf(achStringBuff, "hysteresis = %d, ", ubyTempHysteresis);
-        UART_putStringSerial(achStringBuff);
+        // zone 0 cold, 1-5 normal, 6 high, 7 extreme/max
+        fmtBegin(UART_CLI);
+        for(ubyIndexZone=0; ubyIndexZone<NUM_TZONES; ubyIndexZone++)
+        {
+            fmtStr("Z#");
+            fmtUint(ubyIndexZone, 0);
+            fmtStr(" L=");
+            fmtInt((int16_t)fTz[ubyIndexZone][0], 3 | FMT_LEFT);
+            fmtStr(" H=");
+            fmtInt((int16_t)fTz[ubyIndexZone][1], 0);
+            fmtStr(" \r\n");
+        }
+        fmtStr("\nhysteresis = ");
+        fmtUint(ubyTempHysteresis, 0);
+        fmtStr(", ");
+        fmtEnd(UART_STREAM_CLI, false);
         UART_printNewLineAndPrompt();
         bIsCmdGood = true;
     }
     else if((strcmp((const char*)achTokenArray[1],"range") == 0) && (ubyTokenIndex == 3))
     {
+        fmtBegin(UART_CLI);
         if(strcmp((const char*)achTokenArray[2],"max") == 0)
         {
-            sprintf (achStringBuff, "Max Temperature Range is: %d", gbyTmpRangeMax);
+            fmtStr("Max Temperature Range is: ");
+            fmtInt(gbyTmpRangeMax, 0);
+            bIsCmdGood = true;
         }
         else if(strcmp((const char*)achTokenArray[2],"min") == 0)
         {
-            sprintf (achStringBuff, "Min Temperature Range is: %d", gbyTmpRangeMin);
+            fmtStr("Min Temperature Range is: ");
+            fmtInt(gbyTmpRangeMin, 0);
+            bIsCmdGood = true;
+        }
+        fmtEnd(UART_STREAM_CLI, false);
+        if(bIsCmdGood)
+        {
+            UART_printNewLineAndPrompt();
+        }
+    }
+    // get map
+    else if((strcmp((const char*)achTokenArray[1],"map") == 0) && (ubyTokenIndex == 2))
+    {
+        const char* apchMethod[NUM_FAN_DEMAND_METHODS] = {"max", "wmean", "prio"};
+        uint8_t ubySnsrIndx;
+
+        fmtBegin(UART_CLI);
+        fmtStr("Fan# Method Snsr:Weight/Rank (Snsrs 0-");
+        fmtUint(NUM_TEMP_SNSRS-1, 0);
+        fmtStr(": Int,Rtd5,Rtd4,Tmp1075_0-3)\r\n");
+        for(ubyIndexFan=0; ubyIndexFan<NUM_FANS; ubyIndexFan++)
+        {
+            fmtStr("  ");
+            fmtUint(ubyIndexFan, 0);
+            fmtStr(": ");
+            fmtStr(apchMethod[astFanSnsrMap[ubyIndexFan].ubyMethod % NUM_FAN_DEMAND_METHODS]);
+            fmtChar(' ');
+            for(ubySnsrIndx=0; ubySnsrIndx<NUM_TEMP_SNSRS; ubySnsrIndx++)
+            {
+                if(astFanSnsrMap[ubyIndexFan].ubySnsrMask & SNSR_MASK(ubySnsrIndx))
+                {
+                    fmtUint(ubySnsrIndx, 0);
+                    fmtChar(':');
+                    fmtUint(astFanSnsrMap[ubyIndexFan].aubyWeight[ubySnsrIndx], 0);
+                    fmtChar(' ');
+                }
+            }
+            fmtStr(" Demand=");
+            fmtInt((int16_t)gafFanDemandTemp[ubyIndexFan], 0);
+            fmtStr("\r\n");
         }
-        UART_putStringSerial(achStringBuff);
+        fmtEnd(UART_STREAM_CLI, false);
         UART_printNewLineAndPrompt();
         bIsCmdGood = true;
     }
-    else if ((strcmp((const char*)achTokenArray[1],"version") == 0) && (ubyTokenIndex == 2))
+    // get duty; duty cycle programmed on each fan pwm (TB3.1 to TB3.6)
+    else if((strcmp((const char*)achTokenArray[1],"duty") == 0) && (ubyTokenIndex == 2))
     {
-        stTimerStruct_t dummyTimerStructure;
-        displayBannerCb(&dummyTimerStructure);
+        uint8_t ubyCcrIndx;
+
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nCCR#  Duty%  (Prd=");
+        fmtUint(TMR_PwmGetPrdCnt(tb3), 0);
+        fmtStr(" cnts)\r\n");
+        for(ubyCcrIndx=ccr1; ubyCcrIndx<=ccr6; ubyCcrIndx++)
+        {
+            fmtChar(' ');
+            fmtUint(ubyCcrIndx, 0);
+            fmtStr("    ");
+            fmtFix(TMR_PwmGetDcPerMille(tb3, ubyCcrIndx), 1, 0);
+            fmtStr("\r\n");
+        }
+        fmtEnd(UART_STREAM_CLI, false);
+        UART_printNewLineAndPrompt();
         bIsCmdGood = true;
     }
+    // get fanhealth; health of each fan against its expected rpm
+    else if((strcmp((const char*)achTokenArray[1],"fanhealth") == 0) && (ubyTokenIndex == 2))
+    {
+        uint8_t ubyIndexFan;
+        uint8_t ubyPtIndx;
 
-    if (bIsCmdGood == false)
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nFan# State       Rpm   Exp   Avg%  Kicks Wear  RpmMap(0-100%)\r\n");
+        for(ubyIndexFan=0; ubyIndexFan<NUM_FANS; ubyIndexFan++)
+        {
+            fmtChar(' ');
+            fmtUint(ubyIndexFan, 0);
+            fmtStr("   ");
+            fmtStrW(gapchFanHealthName[gastFanHealth[ubyIndexFan].ubyState], 11 | FMT_LEFT);
+            fmtChar(' ');
+            fmtUint(stFanTach[ubyIndexFan].u16Rpm, 5 | FMT_LEFT);
+            fmtChar(' ');
+            fmtUint(gastFanHealth[ubyIndexFan].u16ExpectedRpm, 5 | FMT_LEFT);
+            fmtChar(' ');
+            fmtInt((gastFanHealth[ubyIndexFan].i32RatioAvg >> 8) / 10, 5 | FMT_LEFT);
+            fmtChar(' ');
+            fmtUint(gastFanHealth[ubyIndexFan].ubyKickCnt, 5 | FMT_LEFT);
+            fmtChar(' ');
+            fmtStrW(gastFanHealth[ubyIndexFan].bWear ? "yes" : "no", 5 | FMT_LEFT);
+            for(ubyPtIndx=0; ubyPtIndx<FAN_RPM_MAP_PTS; ubyPtIndx++)
+            {
+                fmtChar(' ');
+                fmtUint(au16FanRpmMap[ubyIndexFan][ubyPtIndx], 0);
+            }
+            fmtStr("\r\n");
+        }
+        fmtEnd(UART_STREAM_CLI, false);
+        UART_printNewLineAndPrompt();
+        bIsCmdGood = true;
+    }
+    // get power; supply budget and the current of each load (mA)
+    else if((strcmp((const char*)achTokenArray[1],"power") == 0) && (ubyTokenIndex == 2))
     {
-        UART_putStringSerial("Unrecognized Command!");
+        uint8_t ubyLoadIndx;
+
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nBudget=");
+        fmtUint(PWR_BUDGET_MA, 0);
+        fmtStr(" Used=");
+        fmtUint(pwrGetUsedMa(), 0);
+        fmtStr(" (mA)\r\nHtr#:");
+        for(ubyLoadIndx=PWR_LOAD_HTR0; ubyLoadIndx<PWR_LOAD_FAN0; ubyLoadIndx++)
+        {
+            fmtChar(' ');
+            fmtUint(gau16PwrLoadMa[ubyLoadIndx], 0);
+        }
+        fmtStr("\r\nFan#:");
+        for(ubyLoadIndx=PWR_LOAD_FAN0; ubyLoadIndx<NUM_PWR_LOADS; ubyLoadIndx++)
+        {
+            fmtChar(' ');
+            fmtUint(gau16PwrLoadMa[ubyLoadIndx], 0);
+        }
+        fmtEnd(UART_STREAM_CLI, false);
         UART_printNewLineAndPrompt();
+        bIsCmdGood = true;
     }
-}
-
-
-uint16_t getInt(float fNum)
-{
-    return (int)fNum;
-}
-
-int16_t getFract(float fNum)
-{
-    int16_t i16fNum;
-    float fFrac;
-
-    i16fNum = (int)fNum;
-    fFrac = (fNum - i16fNum)*100;
+    // get uart; per instance: output buffer use and bytes dropped per stream, input ring and rx errors
+    else if((strcmp((const char*)achTokenArray[1],"uart") == 0) && (ubyTokenIndex == 2))
+    {
+        const stUartTxStats_t* pstTx;
+        const stUartRxStats_t* pstRx;
+        uint8_t ubyUart;
 
-    if(fFrac < 0)
+        fmtBegin(UART_CLI);
+        for(ubyUart=0; ubyUart<NUM_UARTS; ubyUart++)
+        {
+            // room is taken before this reply is staged
+            pstTx = UART_getTxStats(ubyUart);
+            pstRx = UART_getRxStats(ubyUart);
+            fmtStr("\r\nA");
+            fmtUint(ubyUart, 0);
+            fmtStr(" Baud=");
+            fmtUint(UART_getBaud(ubyUart), 0);
+            fmtStr(" TxBuf=");
+            fmtUint(UART_txBuffSz(ubyUart), 0);
+            fmtStr(" Room=");
+            fmtUint(UART_txRoom(ubyUart), 0);
+            fmtStr(" Hwm=");
+            fmtUint(pstTx->u16HighWater, 0);
+            fmtStr(" Drops Cli=");
+            fmtUint(pstTx->au32Drops[UART_STREAM_CLI], 0);
+            fmtStr(" Echo=");
+            fmtUint(pstTx->au32Drops[UART_STREAM_ECHO], 0);
+            fmtStr(" Diag=");
+            fmtUint(pstTx->au32Drops[UART_STREAM_DIAG], 0);
+            fmtStr(" Tlm=");
+            fmtUint(pstTx->au32Drops[UART_STREAM_TLM], 0);
+            fmtStr("\r\n   RxBuf=");
+            fmtUint(UART_rxBuffSz(ubyUart), 0);
+            fmtStr(" Hwm=");
+            fmtUint(pstRx->u16HighWater, 0);
+            fmtStr(" Lines=");
+            fmtUint(pstRx->u32Lines, 0);
+            fmtStr(" Overrun=");
+            fmtUint(pstRx->u16Overrun, 0);
+            fmtStr(" Framing=");
+            fmtUint(pstRx->u16Framing, 0);
+            fmtStr(" Parity=");
+            fmtUint(pstRx->u16Parity, 0);
+            fmtStr(" Dropped=");
+            fmtUint(pstRx->u16Dropped, 0);
+        }
+        fmtEnd(UART_STREAM_CLI, false);
+        UART_printNewLineAndPrompt();
+        bIsCmdGood = true;
+    }
+    // get baud; rate in use and its baud rate generator settings
+    else if((strcmp((const char*)achTokenArray[1],"baud") == 0) && (ubyTokenIndex == 2))
     {
-        fFrac *= -1;    // remove the sign
+        stUartBaudCfg_t stBaudCfg = {0};
+
+        UART_CalcBaudInUse(UART_CLI, UART_getBaud(UART_CLI), &stBaudCfg);
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nBaud=");
+        fmtUint(UART_getBaud(UART_CLI), 0);
+        fmtStr(" UCBRx=");
+        fmtUint(stBaudCfg.u16Brw, 0);
+        fmtStr(" UCAxMCTLW=0x");
+        fmtHex(stBaudCfg.u16Mctlw, 4);
+        fmtStr(" BitErr=");
+        if(stBaudCfg.i16ErrCentiPct >= 0)
+        {
+            fmtChar('+');
+        }
+        fmtFix(stBaudCfg.i16ErrCentiPct, 2, 0);
+        fmtChar('%');
+        fmtEnd(UART_STREAM_CLI, false);
+        UART_printNewLineAndPrompt();
+        bIsCmdGood = true;
     }
-    i16NumOfZeros = (int)fFrac;
-    if(i16NumOfZeros)
+    // get diag; the diag subscription and the field names of set diag fields
+    else if((strcmp((const char*)achTokenArray[1],"diag") == 0) && (ubyTokenIndex == 2))
     {
-        if(i16NumOfZeros < 9)
+        uint8_t ubySelIndx;
+
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nDiag ");
+        fmtStr(bIsDiagActive ? "on" : "off");
+        fmtStr(" Period=");
+        fmtUint(gstDiagSub.u16PeriodMs, 0);
+        fmtStr(" ms Delta=");
+        fmtStr(gstDiagSub.bDeltaOnly ? "on" : "off");
+        fmtStr(" Fields=0x");
+        fmtHex(gstDiagSub.u32Mask, 6);
+        fmtStr("\r\nNames:");
+        for(ubySelIndx=0; ubySelIndx<NUM_DIAG_SELS; ubySelIndx++)
         {
-            i16NumOfZeros = 1;
+            fmtChar(' ');
+            fmtStr(astDiagSel[ubySelIndx].pchName);
         }
-        else
+        fmtEnd(UART_STREAM_CLI, false);
+        UART_printNewLineAndPrompt();
+        bIsCmdGood = true;
+    }
+    // get tlm; binary telemetry state
+    else if((strcmp((const char*)achTokenArray[1],"tlm") == 0) && (ubyTokenIndex == 2))
+    {
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nTlm A");
+        fmtUint(gstTlm.eUart, 0);
+        fmtStr(" Period=");
+        fmtUint(gstTlm.u16PeriodMs, 0);
+        fmtStr(" ms Seq=");
+        fmtUint(gstTlm.u16Seq, 0);
+        fmtStr(" Frames=");
+        fmtUint(gstTlm.u32Frames, 0);
+        fmtStr(" Dropped=");
+        fmtUint(gstTlm.u32Dropped, 0);
+        fmtStr(" FrameLen=");
+        fmtUint(TLM_WIRE_MAX(TLM_STATUS_LEN), 0);
+        fmtEnd(UART_STREAM_CLI, false);
+        UART_printNewLineAndPrompt();
+        bIsCmdGood = true;
+    }
+    // get selftest; profiles, state and the records (Seg* => a check failed)
+    else if((strcmp((const char*)achTokenArray[1],"selftest") == 0) && (ubyTokenIndex == 2))
+    {
+        uint8_t ubyIndx;
+
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nProfiles:");
+        for(ubyIndx=0; ubyIndx<gubyNumSelfTestProfiles; ubyIndx++)
+        {
+            fmtChar(' ');
+            fmtUint(ubyIndx, 0);
+            fmtChar('=');
+            fmtStr(gastSelfTestProfile[ubyIndx].pchName);
+        }
+        if (gstSelfTest.ubyProfile < gubyNumSelfTestProfiles)
+        {
+            fmtStr("\r\n");
+            fmtStr(gastSelfTestProfile[gstSelfTest.ubyProfile].pchName);
+            fmtChar(' ');
+            fmtStr(gapchSelfTestStateName[gstSelfTest.ubyState]);
+            fmtStr(" Seg=");
+            fmtUint(gstSelfTest.ubySeg, 0);
+            fmtStr(" Step=");
+            fmtUint(gstSelfTest.u16Step, 0);
+            fmtStr(" Fails=");
+            fmtUint(gstSelfTest.ubyFailCnt, 0);
+            fmtStr(" Recs=");
+            fmtUint(gstSelfTest.ubyRecCnt, 0);
+            fmtStr(" Lost=");
+            fmtUint(gstSelfTest.ubyRecLost, 0);
+            fmtStr("\r\nSeg Fan Tz Duty Rpm\r\n");
+            for(ubyIndx=0; ubyIndx<gstSelfTest.ubyRecCnt; ubyIndx++)
+            {
+                stSelfTestRec_t* pstRec = &gastSelfTestRec[ubyIndx];
+
+                fmtUint(pstRec->ubySeg & ~SELFTEST_REC_FAIL, 2 | FMT_LEFT);
+                fmtChar((pstRec->ubySeg & SELFTEST_REC_FAIL) ? '*' : ' ');
+                fmtChar(' ');
+                fmtUint(pstRec->ubyFanTz >> 4, 3 | FMT_LEFT);
+                fmtChar(' ');
+                fmtUint(pstRec->ubyFanTz & 0x0F, 2 | FMT_LEFT);
+                fmtChar(' ');
+                fmtUint(pstRec->ubyDutyPct, 4 | FMT_LEFT);
+                fmtChar(' ');
+                fmtUint((uint16_t)pstRec->ubyRpmDiv32 << 5, 0);
+                fmtStr("\r\n");
+            }
+        }
+        fmtEnd(UART_STREAM_CLI, false);
+        UART_printNewLineAndPrompt();
+        bIsCmdGood = true;
+    }
+    // get heater; set point, temperature (0.01C), PI duty (0.1%) and heaters on
+    else if((strcmp((const char*)achTokenArray[1],"heater") == 0) && (ubyTokenIndex == 2))
+    {
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nHtrOn=");
+        fmtUint(gbIsHtrOn, 0);
+        fmtStr(" SetPt=");
+        fmtInt(gbyHtrOnSetPt * 100, 0);
+        fmtStr(" Temp=");
+        fmtInt((int16_t)(gfRtdTempAvg * 100), 0);
+        fmtStr(" Duty=");
+        fmtUint(gu16HtrDutyPm, 0);
+        fmtStr(" On=0x");
+        fmtHex(gubyHtrOnMask, 2);
+        fmtEnd(UART_STREAM_CLI, false);
+        UART_printNewLineAndPrompt();
+        bIsCmdGood = true;
+    }
+#if CYCLE_BENCH_ENABLED
+    // get bench; cpu cycles (SMCLK counts) of the instrumented sections
+    else if((strcmp((const char*)achTokenArray[1],"bench") == 0) && (ubyTokenIndex == 2))
+    {
+        const char* apchBenchName[NUM_CYCLE_BENCHES] = {"ctrl path", "pwm commit", "diag frame", "cli cmd"};
+        stCycleBench_t* pstBench;
+        uint32_t u32Scale;
+        uint8_t  ubyBenchIndx;
+
+        fmtBegin(UART_CLI);
+        fmtStr("\r\nBench      Cnt   Last    Min     Avg     Max (cycles)\r\n");
+        for(ubyBenchIndx=0; ubyBenchIndx<(CYCLE_BENCH_LONG_ENABLED ? NUM_CYCLE_BENCHES : BENCH_LONG_FIRST); ubyBenchIndx++)
         {
-            i16NumOfZeros = 0;
+            // long sections count free running timer clocks
+            pstBench = &gastCycleBench[ubyBenchIndx];
+            u32Scale = (ubyBenchIndx >= BENCH_LONG_FIRST) ? TMR_FREE_RUN_CLK_DIV : 1;
+            fmtStrW(apchBenchName[ubyBenchIndx], 10 | FMT_LEFT);
+            fmtChar(' ');
+            fmtUint(pstBench->u16Cnt, 5 | FMT_LEFT);
+            fmtChar(' ');
+            fmtUint(pstBench->u16Last * u32Scale, 7 | FMT_LEFT);
+            fmtChar(' ');
+            fmtUint(pstBench->u16Min * u32Scale, 7 | FMT_LEFT);
+            fmtChar(' ');
+            fmtUint(pstBench->u16Cnt ? (pstBench->u32Sum / pstBench->u16Cnt) * u32Scale : 0, 7 | FMT_LEFT);
+            fmtChar(' ');
+            fmtUint(pstBench->u16Max * u32Scale, 7 | FMT_LEFT);
+            fmtStr("\r\n");
         }
+        // main loop wake ups; each costs the isr exit to main and back to sleep
+        fmtStr("Wakeups=");
+        fmtUint(gu32BenchWakeCnt, 0);
+        fmtStr(" in ");
+        fmtUint(TMR_GetUptimeMs() - gu32BenchResetMs, 0);
+        fmtStr(" ms");
+        fmtEnd(UART_STREAM_CLI, false);
+        UART_printNewLineAndPrompt();
+        bIsCmdGood = true;
+    }
+#endif
+    else if ((strcmp((const char*)achTokenArray[1],"version") == 0) && (ubyTokenIndex == 2))
+    {
+        stTimerStruct_t dummyTimerStructure;
+        displayBannerCb(&dummyTimerStructure);
+        bIsCmdGood = true;
+    }
+
+    if (bIsCmdGood == false)
+    {
+        UART_putStringSerial("Unrecognized Command!");
+        UART_printNewLineAndPrompt();
     }
-    return (int)fFrac;
 }
 
 
 void setCMD()
 {
-    char    achStringBuff[256];
 //    float   fTempZone;
     uint8_t ubyPwmNum;
     uint8_t ubyZoneNum;
@@ -426,6 +842,78 @@ void setCMD()
             bIsCmdGood = true;
         }
     }
+    // set diag fields Name/Mask ... / period Ms / delta on/off; the diag subscription
+    //  e.g. set diag fields fan0 adc
+    else if((strcmp((const char*)achTokenArray[1],"diag") == 0) && (ubyTokenIndex >= 4))
+    {
+        if (strcmp((const char*)achTokenArray[2],"fields") == 0)
+        {
+            uint32_t u32Mask = 0;
+            uint8_t  ubyTokIndx;
+            uint8_t  ubySelIndx;
+            char*    pchEnd;
+
+            bIsCmdGood = true;
+            for(ubyTokIndx=3; bIsCmdGood && (ubyTokIndx<ubyTokenIndex); ubyTokIndx++)
+            {
+                for(ubySelIndx=0; ubySelIndx<NUM_DIAG_SELS; ubySelIndx++)
+                {
+                    if (strcmp((const char*)achTokenArray[ubyTokIndx], astDiagSel[ubySelIndx].pchName) == 0)
+                    {
+                        u32Mask |= astDiagSel[ubySelIndx].u32Mask;
+                        break;
+                    }
+                }
+                // or a mask of elements; labels are not taken
+                if (ubySelIndx == NUM_DIAG_SELS)
+                {
+                    u32Mask |= strtoul(achTokenArray[ubyTokIndx], &pchEnd, 0) & DIAG_ALL_MASK;
+                    bIsCmdGood = (*pchEnd == '\0');
+                }
+            }
+
+            if (bIsCmdGood && u32Mask)
+            {
+                gstDiagSub.u32Mask = u32Mask;
+                gstDiagSub.bFull   = true;
+                fmtBegin(UART_CLI);
+                fmtStr("diag fields 0x");
+                fmtHex(u32Mask, 6);
+                fmtStr("\r\n");
+                fmtEnd(UART_STREAM_CLI, false);
+            }
+            else
+            {
+                bIsCmdGood = false;
+            }
+        }
+        else if ((strcmp((const char*)achTokenArray[2],"period") == 0) && (ubyTokenIndex == 4))
+        {
+            uint16_t u16PeriodMs = atoi(achTokenArray[3]);
+
+            if (u16PeriodMs >= DIAG_PERIOD_MIN_MS)
+            {
+                diagSetPeriod(u16PeriodMs);
+                fmtBegin(UART_CLI);
+                fmtStr("diag every ");
+                fmtUint(u16PeriodMs, 0);
+                fmtStr(" ms\r\n");
+                fmtEnd(UART_STREAM_CLI, false);
+                bIsCmdGood = true;
+            }
+        }
+        else if ((strcmp((const char*)achTokenArray[2],"delta") == 0) && (ubyTokenIndex == 4))
+        {
+            if ((strcmp((const char*)achTokenArray[3],"on") == 0) ||
+                (strcmp((const char*)achTokenArray[3],"off") == 0))
+            {
+                gstDiagSub.bDeltaOnly = (achTokenArray[3][1] == 'n');
+                gstDiagSub.bFull      = true;
+                UART_putStringSerial(gstDiagSub.bDeltaOnly ? "diag sends changes only\r\n" : "diag sends all fields\r\n");
+                bIsCmdGood = true;
+            }
+        }
+    }
     // set pwm pwm# zone# val
     else if((strcmp((const char*)achTokenArray[1],"pwm") == 0)  && (ubyTokenIndex == 5))
     {
@@ -438,8 +926,15 @@ void setCMD()
             if((ubyPwmNum < 6) && (ubyZoneNum < 8) && (ubyPwmPercentage < 101))
             {
                 fFanPwm[ubyPwmNum][ubyZoneNum] = ubyPwmPercentage;
-                sprintf (achStringBuff, "Changed Zone#%d Duty Cycle for PWM%d to %d%%",ubyZoneNum, ubyPwmNum, ubyPwmPercentage);
-                UART_putStringSerial(achStringBuff);
+                fmtBegin(UART_CLI);
+                fmtStr("Changed Zone#");
+                fmtUint(ubyZoneNum, 0);
+                fmtStr(" Duty Cycle for PWM");
+                fmtUint(ubyPwmNum, 0);
+                fmtStr(" to ");
+                fmtUint(ubyPwmPercentage, 0);
+                fmtChar('%');
+                fmtEnd(UART_STREAM_CLI, false);
                 UART_printNewLineAndPrompt();
                 setPwmFromTz();
                 bIsCmdGood = true;
@@ -514,8 +1009,11 @@ void setCMD()
         {
             fTz[ubyZoneNum][0] = byTempLowVal;
             fTz[ubyZoneNum][1] = byTempHighVal;
-            sprintf (achStringBuff, "Changed zone %d Low and High temperature ranges", ubyZoneNum);
-            UART_putStringSerial(achStringBuff);
+            fmtBegin(UART_CLI);
+            fmtStr("Changed zone ");
+            fmtUint(ubyZoneNum, 0);
+            fmtStr(" Low and High temperature ranges");
+            fmtEnd(UART_STREAM_CLI, false);
             UART_putStringSerial("\tCheck new ranges by invoking 'get tempthresh' command\n\r");
             UART_putStringSerial("\tif ok with entries invoke 'set tempupdate' command\n\r");
             UART_putStringSerial("\tit is user's responsibility to insure temp ranges are continuous\n\r");
@@ -527,6 +1025,120 @@ void setCMD()
             bIsCmdGood = false;
         }
     }
+    // set duty ccr# val pm/cnt; overrides a fan pwm in 0.1% or raw timer counts
+    //  while thermal controlled, the zone pwm is re-applied on the next sensor sample
+    //  e.g. set duty 1 455 pm => TB3.1 at 45.5%
+    else if((strcmp((const char*)achTokenArray[1],"duty") == 0) && (ubyTokenIndex == 5))
+    {
+        uint8_t  ubyCcrIndx = (uint8_t)atoi(achTokenArray[2]);
+        uint16_t u16DutyVal = (uint16_t)atoi(achTokenArray[3]);
+
+        if(strcmp((const char*)achTokenArray[4],"pm") == 0)
+        {
+            bIsCmdGood = (TMR_PwmSetPerMille(tb3, ubyCcrIndx, u16DutyVal) == 0);
+        }
+        else if(strcmp((const char*)achTokenArray[4],"cnt") == 0)
+        {
+            bIsCmdGood = (TMR_PwmSetDutyCnt(tb3, ubyCcrIndx, u16DutyVal) == 0);
+        }
+
+        if(bIsCmdGood)
+        {
+            UART_putStringSerial("updated duty cycle; use get duty cmd to see update");
+            UART_printNewLineAndPrompt();
+        }
+    }
+    // set rpmmap fan# rpm0 rpm25 rpm50 rpm75 rpm100; expected rpm at 0-100% duty
+    //  e.g. set rpmmap 0 0 1800 3200 4600 6000
+    else if((strcmp((const char*)achTokenArray[1],"rpmmap") == 0) && (ubyTokenIndex == (3 + FAN_RPM_MAP_PTS)))
+    {
+        uint8_t ubyIndexFan = (uint8_t)atoi(achTokenArray[2]);
+        uint8_t ubyPtIndx;
+
+        if(ubyIndexFan < NUM_FANS)
+        {
+            for(ubyPtIndx=0; ubyPtIndx<FAN_RPM_MAP_PTS; ubyPtIndx++)
+            {
+                au16FanRpmMap[ubyIndexFan][ubyPtIndx] = (uint16_t)atoi(achTokenArray[3 + ubyPtIndx]);
+            }
+            UART_putStringSerial("updated rpm map; use get fanhealth cmd to see update");
+            UART_printNewLineAndPrompt();
+            bIsCmdGood = true;
+        }
+    }
+#if CYCLE_BENCH_ENABLED
+    // set bench clr; restart the cycle benchmark statistics
+    else if((strcmp((const char*)achTokenArray[1],"bench") == 0) && (ubyTokenIndex == 3) &&
+            (strcmp((const char*)achTokenArray[2],"clr") == 0))
+    {
+        TMR_BenchReset();
+        UART_putStringSerial("Cycle benchmarks cleared");
+        UART_printNewLineAndPrompt();
+
+        bIsCmdGood = true;
+    }
+#endif
+    // set map fan# max/wmean/prio snsr#[:weight] [snsr#[:weight] ...]
+    //  e.g. set map 0 wmean 1:3 2:1 => Fan0 = (3*Rtd5 + 1*Rtd4)/4
+    //       set map 1 max 1 2       => Fan1 = hottest of Rtd5, Rtd4
+    //       set map 1 prio 2:0 0:1  => Fan1 = Rtd4, Int Snsr if Rtd4 is out of range
+    else if((strcmp((const char*)achTokenArray[1],"map") == 0) && (ubyTokenIndex >= 5))
+    {
+        stFanSnsrMap_t stNewMap;
+        uint8_t ubyTokenIndx;
+        uint8_t ubySnsrIndx;
+        char*   pchWeight;
+
+        ubyPwmNum = (uint8_t)atoi(achTokenArray[2]);
+        memset(&stNewMap, 0, sizeof(stNewMap));
+        bIsCmdGood = (ubyPwmNum < NUM_FANS);
+
+        if(strcmp((const char*)achTokenArray[3],"max") == 0)
+        {
+            stNewMap.ubyMethod = FAN_DEMAND_MAX;
+        }
+        else if(strcmp((const char*)achTokenArray[3],"wmean") == 0)
+        {
+            stNewMap.ubyMethod = FAN_DEMAND_WEIGHTED_MEAN;
+        }
+        else if(strcmp((const char*)achTokenArray[3],"prio") == 0)
+        {
+            stNewMap.ubyMethod = FAN_DEMAND_PRIORITY;
+        }
+        else
+        {
+            bIsCmdGood = false;
+        }
+
+        for(ubyTokenIndx=4; bIsCmdGood && (ubyTokenIndx<ubyTokenIndex); ubyTokenIndx++)
+        {
+            ubySnsrIndx = (uint8_t)atoi(achTokenArray[ubyTokenIndx]);
+            // a TMP1075 without a message never becomes valid; I2C not running
+            if((ubySnsrIndx >= NUM_TEMP_SNSRS) ||
+               ((ubySnsrIndx >= SNSR_TMP1075_FIRST) && !isSnsrValid(ubySnsrIndx)))
+            {
+                bIsCmdGood = false;
+                break;
+            }
+            stNewMap.ubySnsrMask |= SNSR_MASK(ubySnsrIndx);
+            // weight defaults to 1 when not entered
+            pchWeight = strchr(achTokenArray[ubyTokenIndx], ':');
+            stNewMap.aubyWeight[ubySnsrIndx] = (pchWeight != NULL) ? (uint8_t)atoi(pchWeight+1) : 1;
+        }
+
+        if(bIsCmdGood)
+        {
+            astFanSnsrMap[ubyPwmNum] = stNewMap;
+            findTz();
+            setPwmFromTz();
+            fmtBegin(UART_CLI);
+            fmtStr("Changed Fan");
+            fmtUint(ubyPwmNum, 0);
+            fmtStr(" sensor map; use get map cmd to see update");
+            fmtEnd(UART_STREAM_CLI, false);
+            UART_printNewLineAndPrompt();
+        }
+    }
     else if((strcmp((const char*)achTokenArray[1],"hyst") == 0) && (ubyTokenIndex == 3))
     {
         ubyTempHysteresis = atof(achTokenArray[2]);
@@ -542,24 +1154,106 @@ void setCMD()
         UART_printNewLineAndPrompt();
         bIsCmdGood = true;
     }
-    else if ((strcmp((const char*)achTokenArray[1],"tempcycle") == 0) && (ubyTokenIndex == 3))
+    // set baud rate; taken once this reply is out, reverts unless a line comes in at it
+    //  e.g. set baud 460800
+    else if ((strcmp((const char*)achTokenArray[1],"baud") == 0) && (ubyTokenIndex == 3))
     {
-        bIsCmdGood = true;
-        if (strcmp((const char*)achTokenArray[2],"on") == 0)
+        stUartBaudCfg_t stBaudCfg;
+        uint32_t        u32Baud = strtoul(achTokenArray[2], NULL, 10);
+
+        if (UART_CalcBaudInUse(UART_CLI, u32Baud, &stBaudCfg))
         {
-            gbEnableTempCycleTest = true;
-            sprintf (achStringBuff, "temp cycling for debugging enabled\r\n");
-            UART_putStringSerial(achStringBuff);
+            fmtBegin(UART_CLI);
+            fmtStr("baud ");
+            fmtUint(u32Baud, 0);
+            fmtStr(": UCBRx=");
+            fmtUint(stBaudCfg.u16Brw, 0);
+            fmtStr(" UCAxMCTLW=0x");
+            fmtHex(stBaudCfg.u16Mctlw, 4);
+            fmtStr(" BitErr=");
+            if (stBaudCfg.i16ErrCentiPct >= 0)
+            {
+                fmtChar('+');
+            }
+            fmtFix(stBaudCfg.i16ErrCentiPct, 2, 0);
+            fmtChar('%');
+            fmtEnd(UART_STREAM_CLI, false);
+
+            if (abs(stBaudCfg.i16ErrCentiPct) > UART_BAUD_ERR_MAX)
+            {
+                UART_putStringSerial("; error too large, not changed");
+            }
+            else if (stBaudConfirmTmr.status == TIMER_RUNNING)
+            {
+                UART_putStringSerial("; last change not confirmed yet");
+            }
+            else if (UART_txRoomPending(UART_CLI))
+            {
+                UART_putStringSerial("; output busy, not changed");
+            }
+            else
+            {
+                fmtBegin(UART_CLI);
+                fmtStr("; send a line at the new rate within ");
+                fmtUint(UART_BAUD_CONFIRM_MS / 1000, 0);
+                fmtStr(" s\r\n");
+                fmtEnd(UART_STREAM_CLI, false);
+                u32CliBaudNew = u32Baud;
+                UART_notifyTxRoom(UART_CLI, UART_TX_ALL_SENT, cliBaudApply);
+            }
+            bIsCmdGood = true;
         }
-        else if (strcmp((const char*)achTokenArray[2],"off") == 0)
+    }
+    // set tlm PeriodMs [a0/a1] / off; binary status frames, on the uart in use unless named
+    //  (UART_TLM; UART_CLI if UART_TLM is not enabled). an unconfigured uart is refused
+    else if ((strcmp((const char*)achTokenArray[1],"tlm") == 0) && ((ubyTokenIndex == 3) || (ubyTokenIndex == 4)))
+    {
+        eUartNum_t eUart = gstTlm.eUart;
+        uint32_t   u32PeriodMs = strtoul(achTokenArray[2], NULL, 10);
+
+        if (ubyTokenIndex == 4)
         {
-            gbEnableTempCycleTest = false;
-            sprintf (achStringBuff, "temp cycling for debugging disabled\r\n");
-            UART_putStringSerial(achStringBuff);
+            eUart = (strcmp((const char*)achTokenArray[3],"a0") == 0) ? UART_A0 :
+                    (strcmp((const char*)achTokenArray[3],"a1") == 0) ? UART_A1 : NUM_UARTS;
         }
-        else
+
+        if (strcmp((const char*)achTokenArray[2],"off") == 0)
         {
-            bIsCmdGood = false;
+            tlmStop();
+            UART_putStringSerial("telemetry stopped\r\n");
+            bIsCmdGood = true;
+        }
+        else if ((u32PeriodMs <= UINT16_MAX) && tlmStart(eUart, (uint16_t)u32PeriodMs))
+        {
+            fmtBegin(UART_CLI);
+            fmtStr("telemetry on A");
+            fmtUint(gstTlm.eUart, 0);
+            fmtStr(" every ");
+            fmtUint(gstTlm.u16PeriodMs, 0);
+            fmtStr(" ms\r\n");
+            fmtEnd(UART_STREAM_CLI, false);
+            bIsCmdGood = true;
+        }
+    }
+    // set selftest Prof# [StepMs] / off; result is reported when done, records on get selftest
+    else if ((strcmp((const char*)achTokenArray[1],"selftest") == 0) && ((ubyTokenIndex == 3) || (ubyTokenIndex == 4)))
+    {
+        if (strcmp((const char*)achTokenArray[2],"off") == 0)
+        {
+            selfTestStop();
+            UART_putStringSerial("self test stopped\r\n");
+            bIsCmdGood = true;
+        }
+        else if (selfTestStart(atoi(achTokenArray[2]), (ubyTokenIndex == 4) ? atoi(achTokenArray[3]) : 0))
+        {
+            fmtBegin(UART_CLI);
+            fmtStr("self test ");
+            fmtStr(gastSelfTestProfile[gstSelfTest.ubyProfile].pchName);
+            fmtStr(" started; step ");
+            fmtUint(gstSelfTest.u16StepMs, 0);
+            fmtStr(" ms\r\n");
+            fmtEnd(UART_STREAM_CLI, false);
+            bIsCmdGood = true;
         }
     }
     else if((strcmp((const char*)achTokenArray[1],"defaults") == 0) && (ubyTokenIndex == 2))
@@ -585,15 +1279,19 @@ void setCMD()
             else
             {
                 gbyTmpRangeMax = byTempRangeval;
-                sprintf (achStringBuff, "Max temperature range has changed to: %d", gbyTmpRangeMax);
-                UART_putStringSerial(achStringBuff);
+                fmtBegin(UART_CLI);
+                fmtStr("Max temperature range has changed to: ");
+                fmtInt(gbyTmpRangeMax, 0);
+                fmtEnd(UART_STREAM_CLI, false);
             }
         }
         else if (strcmp((const char*)achTokenArray[2],"min") == 0)
         {
             gbyTmpRangeMin = (int8_t)(int16_t)(atof(achTokenArray[3]));
-            sprintf (achStringBuff, "Min temperature range has changed to: %d", gbyTmpRangeMin);
-            UART_putStringSerial(achStringBuff);
+            fmtBegin(UART_CLI);
+            fmtStr("Min temperature range has changed to: ");
+            fmtInt(gbyTmpRangeMin, 0);
+            fmtEnd(UART_STREAM_CLI, false);
         }
         else
         {
@@ -618,20 +1316,67 @@ void setCMD()
     return;
 }
 
-void manCMD()
+static const char* const apchManLines[] =
+{
+    "get diag; set diag on/off\r\n",
+    "set diag fields Name/Mask ...; set diag period Ms; set diag delta on/off\r\n",
+    "get pwm(s)/hyst (for set hyst cmd: enter val\r\n",
+    "set pwm#:0-1 Zn#:0-7 Pwm%:0-100>\r\n",
+    "get/set tempthresh (for set cmd: Zn#:0-7 HVal LVal)\r\n",
+    "get/set range max/min\r\n",
+    "get map; set map Fan#:0-1 max/wmean/prio Snsr#[:Weight] ...\r\n",
+    "get duty; set duty Ccr#:1-6 Val pm/cnt (0.1% or timer counts)\r\n",
+    "get fanhealth; set rpmmap Fan#:0-1 Rpm0 Rpm25 Rpm50 Rpm75 Rpm100\r\n",
+    "get power\r\n",
+    "get heater\r\n",
+    "get selftest; set selftest Prof# [StepMs]/off\r\n",
+    "get uart\r\n",
+    "get baud; set baud Rate\r\n",
+    "get tlm; set tlm PeriodMs [a0/a1]/off\r\n",
+#if CYCLE_BENCH_ENABLED
+    "get bench; set bench clr\r\n",
+#endif
+    "set tempupdate\r\n",
+    "set defaults\r\n",
+    "get version\r\n",
+    "update\r\n"
+};
+#define NUM_MAN_LINES   (sizeof(apchManLines) / sizeof(apchManLines[0]))
+
+static uint8_t ubyManLineIndx;
+
+// help is longer than the uart output buffer; continues as room frees up
+static void manPrintLines(void)
 {
-    UART_putStringSerial("set diag/tempcycle on/off\r\n");
-    UART_putStringSerial("get pwm(s)/hyst (for set hyst cmd: enter val\r\n");
-    UART_putStringSerial("set pwm#:0-1 Zn#:0-7 Pwm%:0-100>\r\n");
-    UART_putStringSerial("get/set tempthresh (for set cmd: Zn#:0-7 HVal LVal)\r\n");
-    UART_putStringSerial("get/set range max/min\r\n");
-    UART_putStringSerial("set tempupdate\r\n");
-    UART_putStringSerial("set defaults\r\n");
-    UART_putStringSerial("get version\r\n");
-    UART_putStringSerial("update\r\n");
+    uint16_t u16Len;
+
+    while (ubyManLineIndx < NUM_MAN_LINES)
+    {
+        u16Len = strlen(apchManLines[ubyManLineIndx]);
+        if (UART_txRoom(UART_CLI) < u16Len)
+        {
+            UART_notifyTxRoom(UART_CLI, u16Len, manPrintLines);
+            return;
+        }
+        UART_write(UART_CLI, UART_STREAM_CLI, apchManLines[ubyManLineIndx++], u16Len, true);
+    }
     UART_printNewLineAndPrompt();
 }
 
+
+void manCMD()
+{
+    // help or a baud change still waiting for the output to drain
+    if (UART_txRoomPending(UART_CLI))
+    {
+        UART_putStringSerial("output busy; try again");
+        UART_printNewLineAndPrompt();
+        return;
+    }
+    ubyManLineIndx = 0;
+    manPrintLines();
+}
+
 void updateCMD()
 {
     UART_putStringSerial("About to update Firmware\n\r");
@@ -643,8 +1388,8 @@ void updateCMD()
 
 // parse string from the supplied parameters into tokens and store token
 //  addresses into a global table tokenArray[].
-/* Divide input line into tokens */
-uint16_t makeTokens(stTimerStruct_t* myTimer)
+/* Divide input line into tokens; returns the token count */
+uint8_t makeTokens(void)
 {
 static char *chToken;
 static char *chTokenChar;
@@ -694,17 +1439,7 @@ static char *chTokenChar;
     // indicate last tokenArray[] table entry as a NULL
     achTokenArray[ubyTokenIndex] = NULL;
 
-    if(ubyTokenIndex != 0)
-    {
-        enableDisableTimer(&stSerialCmdTokenExecuteTmr, TMR_ENABLE);
-    }
-    else
-    {
-        UART_putStringSerial("Unrecognized Command!");
-        UART_printNewLineAndPrompt();
-    }
-
-    return 0;
+    return ubyTokenIndex;
 }
 
 
@@ -713,6 +1448,42 @@ void enableDiagnostics(void)
     registerTimer(&stDiagnosticsDataTmr);
     enableDisableTimer(&stDiagnosticsDataTmr, TMR_ENABLE);
     gbDiagTimeoutChanged = false;
+    gstDiagSub.bFull     = true;
+}
+
+
+/*
+ * diagValChanged(): tells if an element changed as displayed (to its
+ *  ubyPlaces) since it was last checked; keeps the new value.
+ */
+static bool diagValChanged(eDiagElement_t eDiagElement)
+{
+    uint32_t u32Val = (uint32_t)getDiagVal(eDiagElement);
+
+    if (u32Val == au32DiagLast[eDiagElement])
+    {
+        return false;
+    }
+    au32DiagLast[eDiagElement] = u32Val;
+
+    return true;
+}
+
+
+/*
+ * diagSetPeriod(): takes effect at once if diag is running; otherwise when
+ *  it is started.
+ */
+static void diagSetPeriod(uint16_t u16PeriodMs)
+{
+    gstDiagSub.u16PeriodMs = u16PeriodMs;
+
+    if (bIsDiagActive)
+    {
+        enableDisableTimer(&stDiagnosticsDataTmr, TMR_DISABLE);
+        updateDiagTimeout(u16PeriodMs);
+        enableDisableTimer(&stDiagnosticsDataTmr, TMR_ENABLE);
+    }
 }
 
 
@@ -727,7 +1498,12 @@ void disableDiagnostics(void)
 
 uint16_t outputDiagData(stTimerStruct_t* myTimer)
 {
+    eDiagElement_t eDiagLabel = DIAG_START;
+    eDiagElement_t eDiagNextLabel;
     eDiagElement_t eDiagElement;
+    uint32_t       u32GrpMask;
+    bool           bSendGrp;
+    bool           bSent = false;
 
     if(!gbDiagTimeoutChanged)
     {
@@ -739,12 +1515,56 @@ uint16_t outputDiagData(stTimerStruct_t* myTimer)
         gstMainEvts.bits.svcDiag = true;
     }
 
-    for(eDiagElement = DIAG_START; eDiagElement < DIAG_STOP; eDiagElement++)
+    CYCLE_BENCH_START(BENCH_DIAG_FRAME);
+
+    // per group; its label, then the selected values up to the next label.
+    //  the frame is formatted in the output ring and sent whole or dropped
+    fmtBegin(UART_CLI);
+    while(eDiagLabel < DIAG_STOP)
+    {
+        u32GrpMask = 0;
+        bSendGrp   = gstDiagSub.bFull || !gstDiagSub.bDeltaOnly;
+
+        for(eDiagElement = eDiagLabel + 1;
+            (eDiagElement < DIAG_STOP) && (gastDiagDesc[eDiagElement].ubyType != DIAG_TEXT_TYPE);
+            eDiagElement++)
+        {
+            if((gstDiagSub.u32Mask & DIAG_BIT(eDiagElement)) && (gastDiagDesc[eDiagElement].pvData != NULL))
+            {
+                u32GrpMask |= DIAG_BIT(eDiagElement);
+                if(gstDiagSub.bDeltaOnly)
+                {
+                    bSendGrp |= diagValChanged(eDiagElement);
+                }
+            }
+        }
+        eDiagNextLabel = eDiagElement;
+
+        if(u32GrpMask && bSendGrp)
+        {
+            printDiagElement(eDiagLabel);
+            for(eDiagElement = eDiagLabel + 1; u32GrpMask; eDiagElement++)
+            {
+                if(u32GrpMask & DIAG_BIT(eDiagElement))
+                {
+                    printDiagElement(eDiagElement);
+                    u32GrpMask &= ~DIAG_BIT(eDiagElement);
+                }
+            }
+            bSent = true;
+        }
+
+        eDiagLabel = eDiagNextLabel;
+    }
+    gstDiagSub.bFull = false;
+
+    if(bSent)
     {
-        printDiagElement(eDiagElement);
+        fmtStr("\n\r");
     }
+    fmtEnd(UART_STREAM_DIAG, true);
 
-    UART_printNewLine();
+    CYCLE_BENCH_STOP(BENCH_DIAG_FRAME);
 
     return 0;
 }
@@ -792,7 +1612,7 @@ uint16_t updateDiagTimer(stTimerStruct_t* myTimer)
 {
     if (geDiagTmrUpdateState == DIAG_ENABLE_UPDATE_TMR)
     {
-        updateDiagTimeout(DIAG_DISPLAY_INTERVAL_PERIOD);
+        updateDiagTimeout(gstDiagSub.u16PeriodMs);
         geDiagTmrUpdateState = DIAG_UPDATE_NONE;
         bIsDiagActive        = true;        // indicate that diag is in process
         enableDisableTimer(&stDiagnosticsDataTmr, TMR_ENABLE);
@@ -849,184 +1669,62 @@ void resetDiagTimeout()
 }
 
 
+// adds the element to the diag frame open in fmt.c
 uint16_t printDiagElement(eDiagElement_t eDiagElement)
 {
-    stDiagDataStruc_t stDiagVal;
-    char    achDiagBuff[TEXT_STR_SZ];
-    int16_t i16WholePart;
-    int16_t i16FracPart;
+    const stDiagDesc_t* pstDesc = &gastDiagDesc[eDiagElement];
 
-    /*
-     * number of diag elements displayed depends on the enum type eDiagElement_t.
-     * for each element of type eDiagElement_t defined, there should be a corresponding
-     *  handler, case statement, within getDiagVal() function.
-     */
-    stDiagVal = getDiagVal(eDiagElement);
-
-    switch(stDiagVal.eDataTypeVal)
+    if(pstDesc->ubyType == DIAG_TEXT_TYPE)
     {
-    case DIAG_FLOAT_TYPE:
-        i16WholePart = getInt(stDiagVal.fDataVal);
-        i16FracPart  = getFract(stDiagVal.fDataVal);
-        switch(i16NumOfZeros)
-        {
-            default:
-            case 0:
-                sprintf(achDiagBuff, "%d.%d, ", i16WholePart, i16FracPart);
-                break;
-
-            case 1:
-                sprintf(achDiagBuff, "%d.0%d, ", i16WholePart, i16FracPart);
-                break;
-        }
-//        sprintf(achDiagBuff, "%d.%d, ", getInt(stDiagVal.fDataVal), getFract(stDiagVal.fDataVal));
-        break;
-
-    case DIAG_CHAR_TYPE:
-        sprintf(achDiagBuff, "%d, ", stDiagVal.byDataVal);
-        break;
-
-    case DIAG_UINT8_TYPE:
-        sprintf(achDiagBuff, "%d, ", stDiagVal.ubyDataVal);
-        break;
-
-    case DIAG_UINT_TYPE:
-        sprintf(achDiagBuff, "%d, ", stDiagVal.u16DataVal);
-        break;
-
-    case DIAG_INT_TYPE:
-        sprintf(achDiagBuff, "%d, ", stDiagVal.i16DataVal);
-        break;
-
-    case DIAG_BOOL_TYPE:
-        sprintf(achDiagBuff, "%d, ", stDiagVal.bDataVal);
-        break;
-
-    case DIAG_TEXT_TYPE:
-        sprintf(achDiagBuff, "%s, ", stDiagVal.chStrVal);
-        break;
+        fmtStr(pstDesc->pchLabel);
+    }
+    else
+    {
+        fmtFix(getDiagVal(eDiagElement), pstDesc->ubyPlaces, 0);
     }
+    fmtStr(", ");
 
-    UART_putStringSerial(achDiagBuff);
     return 0;
 }
 
 
 /*
- * an enum data type, eDiagElement_t, holds all the diagnostics elements.
+ * getDiagVal(): the value of a gastDiagDesc[] row as displayed, in units of
+ *  10^-ubyPlaces; 0 for a label or a row left out.
  */
-stDiagDataStruc_t getDiagVal(eDiagElement_t eDiagElement)
+int32_t getDiagVal(eDiagElement_t eDiagElement)
 {
-    stDiagDataStruc_t stDiagVal;
+    const stDiagDesc_t* pstDesc = &gastDiagDesc[eDiagElement];
 
-    switch(eDiagElement)
+    if(pstDesc->pvData == NULL)
     {
-    case DIAG_PWM_0TO5_TEXT:
-        strcpy(stDiagVal.chStrVal, "PwmCpuGpu: ");                        // sz<=TEXT_STR_SZ
-        stDiagVal.eDataTypeVal = DIAG_TEXT_TYPE;
-        break;
-
-    case DIAG_PWM5:             // CPU fan
-        stDiagVal.byDataVal    = TMR_PwmGetDcPercenatage(tb3, ccr1);    // PWM5 TB3.1, P6.0, Ch5
-        stDiagVal.eDataTypeVal = DIAG_CHAR_TYPE;
-        break;
-
-    case DIAG_PWM4:             // GPU fan
-        stDiagVal.byDataVal    = TMR_PwmGetDcPercenatage(tb3, ccr2);    // PWM4 TB3.2, P6.1, Ch4
-        stDiagVal.eDataTypeVal = DIAG_CHAR_TYPE;
-        break;
-
-    case DIAG_FTACH_5and4_TEXT:
-        strcpy(stDiagVal.chStrVal, "FtachPrt4_0,1: ");                        // sz<=TEXT_STR_SZ
-        stDiagVal.eDataTypeVal = DIAG_TEXT_TYPE;
-        break;
-
-    case DIAG_CPU_FTACH5_RPM5:
-        stDiagVal.u16DataVal = stFanTach[FAN_TACH5_P4_0].u16RpmPrevious;    // RPM0(TACH0)
-        stDiagVal.eDataTypeVal = DIAG_UINT_TYPE;
-        break;
-
-    case DIAG_GPU_FTACH4_RPM4:
-        stDiagVal.u16DataVal = stFanTach[FAN_TACH4_P4_1].u16RpmPrevious;    // RPM1(TACH1)
-        stDiagVal.eDataTypeVal = DIAG_UINT_TYPE;
-        break;
-
-    case DIAG_TEMP_RTD_TEXT:
-        strcpy(stDiagVal.chStrVal, "RtdAvgIntCpuGpu: ");      // sz<=TEXT_STR_SZ
-        stDiagVal.eDataTypeVal = DIAG_TEXT_TYPE;
-        break;
-
-    case DIAG_RTD_TEMP_AVG:
-        stDiagVal.fDataVal     = gfRtdTempAvg;
-        stDiagVal.eDataTypeVal = DIAG_FLOAT_TYPE;
-        break;
-
-    case DIAG_ON_CHIP_CH12:
-        stDiagVal.fDataVal     = stAdcChA12.fAdcXformVal;
-        stDiagVal.eDataTypeVal = DIAG_FLOAT_TYPE;
-        break;
-
-    case DIAG_RTD_CH5:
-        stDiagVal.fDataVal     = stAdcChA5.fAdcXformVal;    // PWM5 TB3.1, P6.0, Ch5
-        stDiagVal.eDataTypeVal = DIAG_FLOAT_TYPE;
-        break;
-
-    case DIAG_RTD_CH4:
-        stDiagVal.fDataVal     = stAdcChA4.fAdcXformVal;    // PWM4 TB3.2, P6.1, Ch4
-        stDiagVal.eDataTypeVal = DIAG_FLOAT_TYPE;
-        break;
-
-    case DIAG_TEMP_ZONE_TEXT:
-        strcpy(stDiagVal.chStrVal, "PwmActiveZn#CpuGpu: ");     // sz<=TEXT_STR_SZ
-        stDiagVal.eDataTypeVal = DIAG_TEXT_TYPE;
-        break;
-
-    case DIAG_PWM5_ZONE_NUM:
-        stDiagVal.ubyDataVal   = gubyCurrentTz[0];          // PWM5/CPU Fan
-        stDiagVal.eDataTypeVal = DIAG_UINT8_TYPE;
-        break;
-
-    case DIAG_PWM4_ZONE_NUM:
-        stDiagVal.ubyDataVal   = gubyCurrentTz[1];          // PWM4/GPU Fan
-        stDiagVal.eDataTypeVal = DIAG_UINT8_TYPE;
-        break;
-
-    case DIAG_TEMP_RTD_ADC_TEXT:
-        strcpy(stDiagVal.chStrVal, "RtdAdcIntCpuGpu: ");      // sz<=TEXT_STR_SZ
-        stDiagVal.eDataTypeVal = DIAG_TEXT_TYPE;
-        break;
+        return 0;
+    }
 
-    case DIAG_ON_CHIP_ADC_CH12:
-        stDiagVal.u16DataVal   = stAdcChA12.u16AdcChVal;
-        stDiagVal.eDataTypeVal = DIAG_UINT_TYPE;
-        break;
+    switch(pstDesc->ubyType)
+    {
+    case DIAG_FLOAT_TYPE:
+        return (int32_t)(*(const float*)pstDesc->pvData * au16DiagPow10[pstDesc->ubyPlaces]);
 
-    case DIAG_RTD_ADC_CH5:                                  // PWM5 TB3.1, P6.0, Ch5
-        stDiagVal.u16DataVal   = stAdcChA5.u16AdcChVal;
-        stDiagVal.eDataTypeVal = DIAG_UINT_TYPE;
-        break;
+    case DIAG_CHAR_TYPE:
+        return *(const int8_t*)pstDesc->pvData;
 
-    case DIAG_RTD_ADC_CH4:                                  // PWM4 TB3.2, P6.1, Ch4
-        stDiagVal.u16DataVal   = stAdcChA4.u16AdcChVal;
-        stDiagVal.eDataTypeVal = DIAG_UINT_TYPE;
-        break;
+    case DIAG_UINT8_TYPE:
+        return *(const uint8_t*)pstDesc->pvData;
 
-    case DIAG_2RTD_ADC_SELF_CPY_TMP_TEXT:
-        strcpy(stDiagVal.chStrVal, "TempSelfCpyCpuGpu: ");    // sz<=TEXT_STR_SZ
-        stDiagVal.eDataTypeVal = DIAG_TEXT_TYPE;
-        break;
+    case DIAG_UINT_TYPE:
+        return *(const uint16_t*)pstDesc->pvData;
 
-    case DIAG_RTD_TEMP_CH4_0_CPU_SELF:
-        stDiagVal.bDataVal     = stAdcChA5.bSelfTemp;
-        stDiagVal.eDataTypeVal = DIAG_BOOL_TYPE;
-        break;
+    case DIAG_INT_TYPE:
+        return *(const int16_t*)pstDesc->pvData;
 
-    case DIAG_RTD_TEMP_CH4_1_GPU_SELF:
-        stDiagVal.bDataVal     = stAdcChA4.bSelfTemp;
-        stDiagVal.eDataTypeVal = DIAG_BOOL_TYPE;
-        break;
+    case DIAG_LONG_INT_TYPE:
+        return *(const int32_t*)pstDesc->pvData;
 
+    case DIAG_BOOL_TYPE:
+        return *(const bool*)pstDesc->pvData;
     }
-    return stDiagVal;
+
+    return 0;
 }
 
@@ -11,8 +11,7 @@
 
 #define SERIAL_BUFFER_SZ        256
 #define NUM_CMDS                4
-#define MAX_CMD_LENGTH          10   // total # of tokens making a command
-#define TEXT_STR_SZ             25
+#define MAX_CMD_LENGTH          12   // total # of tokens making a command
 
 
 typedef enum DIAG_ELEMENT
@@ -48,6 +47,11 @@ typedef enum DIAG_ELEMENT
     DIAG_STOP = DIAG_ELEMENT_COUNT
 }eDiagElement_t;
 
+// DIAG_ELEMENT_COUNT <= 32; a bit per element in stDiagSub_t.u32Mask
+#define DIAG_BIT(elem)          (1UL << (elem))
+// label bits are ignored; a label goes with its group
+#define DIAG_ALL_MASK           (DIAG_BIT(DIAG_ELEMENT_COUNT) - 1)
+
 
 typedef enum DIAG_DATA_TYPE
 {
@@ -64,6 +68,21 @@ typedef enum DIAG_DATA_TYPE
 }eDiagDataType_t;
 
 
+/*
+ * a row of gastDiagDesc[] per eDiagElement_t; a DIAG_TEXT_TYPE row is a
+ *  group label (pchLabel), the others point at the value. ubyPlaces: shown
+ *  with that many decimals; a float is scaled by 10^ubyPlaces, an integer
+ *  is taken as already in those units (e.g. per mille, 1 => 45.5)
+ */
+typedef struct DIAG_DESC
+{
+    const char*     pchLabel;
+    const void*     pvData;
+    uint8_t         ubyType;        // eDiagDataType_t
+    uint8_t         ubyPlaces;
+}stDiagDesc_t;
+
+
 typedef enum DIAG_TMR_STATE
 {
     DIAG_UPDATE_NONE,
@@ -75,29 +94,25 @@ typedef enum DIAG_TMR_STATE
 }eDiagTmrState_t;
 
 
-
-typedef struct DIAG_DATA_STRUC
+/*
+ * diag subscription; the values of u32Mask every u16PeriodMs. a label is
+ *  sent ahead of the selected values of its group (the values up to the
+ *  next label). delta only sends a group when one of its selected values
+ *  changed as displayed.
+ */
+typedef struct DIAG_SUB
 {
-    bool            bDataVal;
-    char            byDataVal;
-    uint8_t         ubyDataVal;
-    uint16_t        u16DataVal;
-    uint32_t        u32DataVal;
-    int16_t         i16DataVal;
-    float           fDataVal;
-    // short 2 string response; eg HON
-    char            chStrVal[TEXT_STR_SZ];
-    eDiagDataType_t eDataTypeVal;
-
-}stDiagDataStruc_t;
+    uint32_t u32Mask;           // DIAG_BIT(value element)
+    uint16_t u16PeriodMs;
+    bool     bDeltaOnly;
+    bool     bFull;             // next frame whole; diag started or subscription changed
+}stDiagSub_t;
 
 
 extern bool gbDiagTimeoutChanged;;
+extern stDiagSub_t gstDiagSub;
+extern const stDiagDesc_t gastDiagDesc[DIAG_ELEMENT_COUNT];
 extern eDiagTmrState_t geDiagTmrUpdateState;
-extern stTimerStruct_t gstCopySeralCmdToCmdBuffTmr;
-//extern stTimerStruct_t stSerialCmdMakeTokensTmr;
-//extern stTimerStruct_t stSerialCmdTokenExecuteTmr;
-//extern stTimerStruct_t stSerialCmdTokenExecuteTmr;
 //extern stTimerStruct_t stDiagnosticsDataTmr;
 
 void getCMD();
@@ -106,9 +121,9 @@ void updateCMD();
 void manCMD();
 
 void initCli();
-uint16_t cpySerialCmd2CmdBuf(stTimerStruct_t* myTimer);
-uint16_t executeUartCmd(stTimerStruct_t* myTimer);
-uint16_t makeTokens(stTimerStruct_t* myTimer);
+void cliSvcCmdLine(void);
+uint16_t executeUartCmd(void);
+uint8_t makeTokens(void);
 uint16_t outputDiagData(stTimerStruct_t* myTimer);
 uint16_t updateDiagTimer(stTimerStruct_t* myTimer);
 
@@ -116,7 +131,7 @@ uint16_t updateDiagTimer(stTimerStruct_t* myTimer);
 void enableDiagnostics(void);
 void disableDiagnostics(void);
 uint16_t printDiagElement(eDiagElement_t eDiagElement);
-stDiagDataStruc_t getDiagVal(eDiagElement_t eDiagElement);
+int32_t getDiagVal(eDiagElement_t eDiagElement);
 void resetDiagTimeout();
 void updateDiagTimeout(uint16_t u16Val);
 
@@ -124,5 +139,6 @@ void updateDiagTimeout(uint16_t u16Val);
 void disableDiagUpdateTimer(void);
 void maintainDiagMsgDisplay(void);
 uint16_t updateCmdCb(stTimerStruct_t* myTimer);
+uint16_t baudConfirmCb(stTimerStruct_t* myTimer);
 
 #endif /* CLI_H_ */
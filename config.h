@@ -108,14 +108,40 @@
         UART Baud Rate
  *****************************************************************************
  */
+// UART_CLI: interactive cli and diag; UART_TLM: binary telemetry
+#define UART_CLI                        UART_A0
+#define UART_TLM                        UART_A1
 #define UART_BAUD_IN_USE                UART_BAUD_115200
+// P4.2/P4.3 are not bonded out on the MSP430FR2355 Launchboard; they are
+//  also the TACH3/TACH2 pins of fans 2/3 (gastFanDesc[]), so A1 needs NUM_FANS <= 2
+#define UART_TLM_ENABLED                (1)
+#define UART_TLM_BAUD                   UART_BAUD_460800
+
+// set baud; highest rate taken and largest bit error of a frame (0.01% of a bit)
+#define UART_BAUD_MAX                   (1000000)
+#define UART_BAUD_ERR_MAX               (500)
+// set baud; reverts unless a line is received at the new rate by then (ms)
+#define UART_BAUD_CONFIRM_MS            (10000)
+
+// output buffers; writes never block, what does not fit is dropped and counted
+#define UART_A0_TX_BUFF_SZ              (512)
+#define UART_A1_TX_BUFF_SZ              (512)
+
+// input rings; filled by the rx isr, emptied a line (cli) or bytes at a time by main
+#define UART_A0_RX_BUFF_SZ              (256)
+#define UART_A1_RX_BUFF_SZ              (32)
+// longer lines are cut; keep two of them in the input ring
+#define UART_RX_LINE_MAX                (120)
+// echo the rx isr could not send at once; power of 2
+#define UART_ECHO_BUFF_SZ               (8)
 
 
 /*****************************************************************************
         CLI
  *****************************************************************************
  */
-#define DIAG_DISPLAY_INTERVAL_PERIOD    (900)
+#define DIAG_DISPLAY_INTERVAL_PERIOD    (900)   // default diag period
+#define DIAG_PERIOD_MIN_MS              (100)
 
 
 /*****************************************************************************
@@ -130,7 +156,57 @@
         HEATER
  *****************************************************************************
  */
-#define HEATER_ON_INTERVAL_MS           (2000)
+#define NUM_HEATERS                     (6)     // HTR_CTRL0 to HTR_CTRL5
+
+/*
+ * board has the heaters; their pins are driven and the heater drive runs.
+ *  DEMEC7040SYS-02 has none (P2.1 is the simulation voltage divider): 0
+ */
+#ifndef HTR_ENABLED
+#define HTR_ENABLED                     (0)
+#endif
+
+/*
+ * time proportional heater drive; window = HTR_TP_SLOTS * HTR_TP_TICK_MS
+ *  a PI loop on gfRtdTempAvg sets the heater duty once per window; each
+ *  heater is on for duty * window, the heater on times are interleaved.
+ *  heaters on at once <= HTR_CURRENT_LIMIT_MA / PWR_HTR_MA and what the
+ *  power budget leaves. HTR_TP_SLOTS must be a multiple of NUM_HEATERS.
+ */
+#define HTR_TP_TICK_MS                  (100)
+#define HTR_TP_SLOTS                    (30)    // 3 sec window
+#define HTR_CURRENT_LIMIT_MA            (3200)
+#define HTR_PI_KP_PM                    (250)   // 25% duty per C below set point
+#define HTR_PI_KI_PM                    (20)    // 2% duty per C per window
+
+
+/*****************************************************************************
+        POWER
+ *****************************************************************************
+ */
+// min time between two load steps (heater on, fan kick/ramp start)
+#define PWR_INRUSH_SETTLE_MS            (250)
+
+/*
+ * supply budget; a heater is turned on only when the loads already on,
+ *  plus the fans counted at their target duty, leave room for it.
+ *  fans are never refused; cooling comes first.
+ * fan current = PWR_FAN_MIN_MA + (PWR_FAN_MAX_MA - PWR_FAN_MIN_MA) * duty^3
+ *  (fan power goes with the cube of the speed); 0 when the duty is 0
+ */
+#define PWR_BUDGET_MA                   (6000)
+#define PWR_HTR_MA                      (800)   // each heater
+#define PWR_FAN_MIN_MA                  (40)
+#define PWR_FAN_MAX_MA                  (600)
+
+/*
+ * PWR_USE_INA219 1 => budget headroom uses the larger of the modelled
+ *  total and the supply current measured by an INA219, given through
+ *  pwrSetMeasuredMa(). the measurement is ignored once older than
+ *  PWR_MEASURED_MAX_AGE_MS; the model alone is used then.
+ */
+#define PWR_USE_INA219                  (0)
+#define PWR_MEASURED_MAX_AGE_MS         (1000)
 
 
 /*****************************************************************************
@@ -145,10 +221,156 @@
 //#define TMR_PWM_PRD_FREQ_IN_USE         TMR_TBCCRx_PWM_FREQ_5000
 //#define TMR_PWM_PRD_FREQ_IN_USE         TMR_TBCCRx_PWM_FREQ_1500
 
-//# of sec = FAN_RPM_CALC_COUNT_TICK * TICK_PRD; e.g. (2000 * 0.001 = 2sec)
-#define FAN_RPM_CALC_COUNT_TICK         (2000)
+/*
+ * # of PWM timers that get a percent to CCR count look up table built when
+ *  the period is configured (101 words each). Only TB3 drives fans, so 1.
+ *  Set to 0 to fall back to computing the count on every duty change.
+ */
+#define TMR_PWM_NUM_PCT_TABLES          (1)
+
+/*
+ * # of fans controlled; 1 to FAN_MAX_NUM (6, all TB3 pwms)
+ *  fan n uses the n-th entry of gastFanDesc[] (fans.c); pwm, tach pin
+ *  and default sensors of each fan are set there.
+ *  DEMEC7040SYS-02: 2 (PWM5 CPU, PWM4 GPU); Hawk Strike: 6
+ */
+#define NUM_FANS                        (2)
+
+#if UART_TLM_ENABLED && (NUM_FANS > 2)
+#error UART A1 (P4.2/P4.3) shares the fan 2/3 tach pins; set UART_TLM_ENABLED to 0
+#endif
+
+/*
+ * count modes rpm window; pulses counted per slot of FAN_RPM_WIN_SLOT_TICK,
+ *  rpm over the last FAN_RPM_WIN_SLOTS slots (sliding); 8 x 250 = 2 sec
+ *  window, refreshed every 250 ms
+ */
+#define FAN_RPM_WIN_SLOT_TICK           (250)
+#define FAN_RPM_WIN_SLOTS               (8)
+
+/*
+ * fan tach measurement mode
+ *  FAN_TACH_MODE_EDGE_COUNT: edges counted over the rpm window;
+ *                            +/-15RPM per count, refreshed every slot.
+ *  FAN_TACH_MODE_PERIOD    : edges time stamped against the free running
+ *                            timer (TB1); RPM from the average of the last
+ *                            FAN_TACH_PERIOD_AVG_CNT edge periods, refreshed
+ *                            every FAN_TACH_PERIOD_CALC_TICK.
+ */
+#define FAN_TACH_MODE_EDGE_COUNT        (0)
+#define FAN_TACH_MODE_PERIOD            (1)
+#define FAN_TACH_MODE_HW_COUNT          (2)
+#define FAN_TACH_MODE                   FAN_TACH_MODE_PERIOD
+
+/*
+ * FAN_TACH_MODE_HW_COUNT: same as FAN_TACH_MODE_EDGE_COUNT except the tach
+ *  of a fan given a counter is routed to that timer clock input (TBxCLK);
+ *  the timer counts the pulses, no interrupt per edge. fanRpmComputeCb()
+ *  reads the count. fans without a counter keep the P4 edge interrupt.
+ *  only TB1 and TB2 are free (TB0 ticker, TB3 pwm) => 2 fans at most.
+ *   TB1CLK = P2.2; shared with heater HTR_CTRL3 on the 810405 board
+ *   TB2CLK = P5.2; shared with ADC A10 (not in use)
+ *  the tach needs to be wired to the TBxCLK pin (board rework on 810405).
+ *  FAN_TACH_NO_HW_CNT => fan keeps its P4 interrupt.
+ */
+#define FAN_TACH_NO_HW_CNT              (0xFF)
+#define FAN_TACH_HW_CNT_TMR_FAN0        (TMR_B2)
+#define FAN_TACH_HW_CNT_TMR_FAN1        (FAN_TACH_NO_HW_CNT)
+
+
+#define FAN_TACH_PULSES_PER_REV         (2)
+#define FAN_TACH_PERIOD_AVG_CNT         (4)     // 2 revolutions
+#define FAN_TACH_PERIOD_CALC_TICK       (100)
+#define FAN_TACH_STALL_MS               (500)   // no edge this long => 0 RPM
+
+/*
+ * fan health (fanhealth.c); evaluated every FAN_HEALTH_PERIOD_TICK
+ *  stall      : no tach edge for FAN_STALL_TIMEOUT_REVS revolutions at the
+ *               rpm expected from the commanded duty, clamped to
+ *               [FAN_STALL_TIMEOUT_MIN_MS, FAN_TACH_STALL_MS]
+ *  under-speed: rpm < FAN_UNDERSPEED_PM of expected for FAN_UNDERSPEED_MS
+ *  wear       : long term average of rpm/expected < FAN_WEAR_PM
+ *  stall is not checked FAN_START_MS after a stopped fan is commanded on,
+ *  under-speed FAN_SPINUP_GRACE_MS after the duty is raised.
+ *  only FAN_TACH_MODE_PERIOD gives the short stall time; the count modes
+ *  see a stall when the rpm window (2 sec) reads 0.
+ */
+#define FAN_HEALTH_PERIOD_TICK          (100)
+#define FAN_STALL_TIMEOUT_REVS          (2)
+#define FAN_STALL_TIMEOUT_MIN_MS        (100)
+#define FAN_UNDERSPEED_PM               (700)   // 70% of expected rpm
+#define FAN_UNDERSPEED_MS               (300)
+#define FAN_WEAR_PM                     (850)
+#define FAN_WEAR_HYST_PM                (20)
+#define FAN_WEAR_EWMA_SHIFT             (8)     // ~25 sec time constant
+#define FAN_START_MS                    (1000)
+#define FAN_SPINUP_GRACE_MS             (3000)
+
+// expected rpm at 0, 25, 50, 75, 100% duty; from the fan data sheet
+#define FAN_RPM_MAP_DEFAULT             {0, 1800, 3200, 4600, 6000}
+
+/*
+ * reaction to a stalled/under-speed fan; FAN_REACT_xxx bits
+ *  FAN_REACT_EVENT: report health changes on the cli
+ *  FAN_REACT_KICK : stalled fan kicked (FAN_PWM_KICK_MS at 100%), up to
+ *                   FAN_KICK_RETRIES times until it recovers
+ *  FAN_REACT_BOOST: the healthy fans run at FAN_BOOST_PM at least
+ */
+#define FAN_REACT_EVENT                 (0x01)
+#define FAN_REACT_KICK                  (0x02)
+#define FAN_REACT_BOOST                 (0x04)
+#define FAN_HEALTH_REACTIONS            (FAN_REACT_EVENT | FAN_REACT_KICK | FAN_REACT_BOOST)
+#define FAN_KICK_RETRIES                (3)
+#define FAN_BOOST_PM                    (1000)
+
 
 #define HEATER_ON_THRESHOLD             (-4)
 #define FAN_HYSTERISIS_TEMP             (2)
 
+/*
+ * fan pwm engine (fans.c); runs every FAN_PWM_ENGINE_TICK
+ *  - a stopped fan given a duty is first kicked at 100% for FAN_PWM_KICK_MS
+ *  - duty moves toward its target by FAN_PWM_SLEW_PM per tick at most
+ *  - one fan ramps up at a time; kicks and ramp starts take the supply
+ *    inrush window (PWR_INRUSH_SETTLE_MS) shared with the heaters
+ *  FAN_PWM_KICK_MS 0 => no kick; FAN_PWM_SLEW_PM 1000 => no slew limit
+ */
+#define FAN_PWM_ENGINE_TICK             (20)
+#define FAN_PWM_SLEW_PM                 (20)    // 2%/tick; 0-100% in 1 sec
+#define FAN_PWM_KICK_MS                 (500)
+
+
+/*****************************************************************************
+        Self Test
+        thermal control self test profiles (selftest.c); 'set selftest' cli cmd
+ *****************************************************************************
+ */
+#define SELFTEST_REC_MAX                (48)    // records of 4 bytes; per fan and record point
+
+
+/*****************************************************************************
+        Telemetry
+        binary status frames (telemetry.c); 'set tlm' cli cmd
+ *****************************************************************************
+ */
+#define TLM_PERIOD_MIN_MS               (5)
+// crc by the CRC module; the host build (sim/) has none
+#ifndef TLM_CRC_HW
+#define TLM_CRC_HW                      (1)
+#endif
+
+
+/*****************************************************************************
+        Cycle Benchmark
+        measures cpu cycles of the control path, the diag frame and the cli
+        commands; see 'get bench' cli cmd
+ *****************************************************************************
+ */
+#ifdef ___DEBUG___
+    #define CYCLE_BENCH_ENABLED         (1)
+#else
+    #define CYCLE_BENCH_ENABLED         (0)
+#endif
+
+
 #endif /* CONFIG_H_ */
@@ -0,0 +1,307 @@
+/*
+ * fanhealth.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <string.h>
+#include "config.h"
+#include "main.h"
+#include "timer.h"
+#include "uart.h"
+#include "fmt.h"
+#include "fans.h"
+#include "thermalcontrol.h"
+#include "fanhealth.h"
+
+/*
+ * fan health; runs every FAN_HEALTH_PERIOD_TICK on top of stFanTach[]
+ *  - the rpm expected from the commanded duty is interpolated from
+ *    au16FanRpmMap[]; expected 0 => fan not checked
+ *  - stall      : no tach edge for FAN_STALL_TIMEOUT_REVS revolutions at
+ *                 the expected rpm; a few 100 ms instead of the 2 sec window
+ *  - under-speed: rpm below FAN_UNDERSPEED_PM of expected, debounced
+ *  - wear       : long term average of rpm/expected, taken while healthy
+ * reactions (FAN_HEALTH_REACTIONS): a kick goes through the fan pwm
+ *  engine (fanPwmKick()), boost through fanHealthDutyOverride() when the
+ *  fan pwm target is set.
+ */
+
+// ---------------------- vars in flash
+// loaded by fanHealthLoadDefaults()
+#pragma PERSISTENT(au16FanRpmMap)
+    uint16_t au16FanRpmMap[NUM_FANS][FAN_RPM_MAP_PTS] = {0};
+// ---------------------- end of vars in flash
+
+stTimerStruct_t stFanHealthTmr =
+{
+    .prevTimer      = NULL,
+    .timeoutTickCnt = FAN_HEALTH_PERIOD_TICK,
+    .counter        = 0,
+    .recurrence     = TIMER_RECURRING,
+    .status         = TIMER_RUNNING,
+    .callback       = fanHealthCb,
+    .nextTimer      = NULL
+};
+
+stFanHealth_t gastFanHealth[NUM_FANS];
+// a fan is stalled/under-speed; the others run at FAN_BOOST_PM at least
+static bool bFanBoost;
+
+// time for new tach edges to show in u16Rpm; a window slot in the count modes
+#if (FAN_TACH_MODE == FAN_TACH_MODE_PERIOD)
+#define FAN_HEALTH_RPM_LAG_MS   (FAN_TACH_PERIOD_CALC_TICK)
+#else
+#define FAN_HEALTH_RPM_LAG_MS   (FAN_RPM_WIN_SLOT_TICK)
+#endif
+
+const char* const gapchFanHealthName[NUM_FAN_HEALTH_STATES] = {"ok", "underspeed", "stalled"};
+
+
+void initFanHealth()
+{
+    uint8_t ubyFanIndx;
+
+    memset(gastFanHealth, 0, sizeof(gastFanHealth));
+    for(ubyFanIndx=0; ubyFanIndx<NUM_FANS; ubyFanIndx++)
+    {
+        gastFanHealth[ubyFanIndx].i32RatioAvg = (int32_t)TMR_PWM_MAX_PER_MILLE << 8;
+    }
+    bFanBoost = false;
+
+    registerTimer(&stFanHealthTmr);
+    enableDisableTimer(&stFanHealthTmr, TMR_ENABLE);
+}
+
+
+// called from initThermalControl() when the persistent memory is (re)initialized
+void fanHealthLoadDefaults()
+{
+    uint16_t au16FanRpmMapInit[FAN_RPM_MAP_PTS] = FAN_RPM_MAP_DEFAULT;
+    uint8_t  ubyFanIndx;
+
+    for(ubyFanIndx=0; ubyFanIndx<NUM_FANS; ubyFanIndx++)
+    {
+        memcpy (&au16FanRpmMap[ubyFanIndx], &au16FanRpmMapInit, sizeof(au16FanRpmMapInit));
+    }
+}
+
+
+// linear interpolation of au16FanRpmMap[] at the duty
+uint16_t fanHealthExpectedRpm(uint8_t ubyFanIndx, uint16_t u16PerMille)
+{
+    uint8_t  ubyPt;
+    uint16_t u16Frac;
+    int32_t  i32Rpm;
+
+    if(u16PerMille >= TMR_PWM_MAX_PER_MILLE)
+    {
+        return au16FanRpmMap[ubyFanIndx][FAN_RPM_MAP_PTS-1];
+    }
+
+    ubyPt   = u16PerMille / FAN_RPM_MAP_STEP_PM;
+    u16Frac = u16PerMille - ubyPt * FAN_RPM_MAP_STEP_PM;
+
+    i32Rpm  = (int32_t)au16FanRpmMap[ubyFanIndx][ubyPt+1] - au16FanRpmMap[ubyFanIndx][ubyPt];
+    i32Rpm  = au16FanRpmMap[ubyFanIndx][ubyPt] + (i32Rpm * u16Frac) / FAN_RPM_MAP_STEP_PM;
+
+    return (uint16_t)i32Rpm;
+}
+
+
+/*
+ * duty to program on a fan given the thermal control duty
+ *  boost => healthy fans at FAN_BOOST_PM at least
+ */
+uint16_t fanHealthDutyOverride(uint8_t ubyFanIndx, uint16_t u16PerMille)
+{
+    if(bFanBoost && (gastFanHealth[ubyFanIndx].ubyState == FAN_HEALTH_OK) && (u16PerMille < FAN_BOOST_PM))
+    {
+        return FAN_BOOST_PM;
+    }
+
+    return u16PerMille;
+}
+
+
+// updates the health of one fan
+static void fanHealthCheck(uint8_t ubyFanIndx)
+{
+    stFanHealth_t* pstHealth = &gastFanHealth[ubyFanIndx];
+    uint16_t u16PerMille;
+    uint16_t u16ExpectedRpm;
+    uint16_t u16Rpm;
+    uint32_t u32StallMs;
+    int32_t  i32Ratio;
+
+    u16PerMille    = (uint16_t)TMR_PwmGetDcPerMille(FAN_PWM_TMR, gastFanDesc[ubyFanIndx].ubyCcrNum);
+    u16ExpectedRpm = fanHealthExpectedRpm(ubyFanIndx, u16PerMille);
+    u16Rpm         = stFanTach[ubyFanIndx].u16Rpm;
+
+    // a stopped fan needs time for its first edges, a faster one to get there
+    if((pstHealth->u16ExpectedRpm == 0) && u16ExpectedRpm)
+    {
+        pstHealth->u16StartMs = FAN_START_MS + FAN_HEALTH_RPM_LAG_MS;
+    }
+    if(u16PerMille > pstHealth->u16PerMille)
+    {
+        pstHealth->u16GraceMs      = FAN_SPINUP_GRACE_MS;
+        pstHealth->u16UnderSpeedMs = 0;
+    }
+    pstHealth->u16PerMille    = u16PerMille;
+    pstHealth->u16ExpectedRpm = u16ExpectedRpm;
+
+    // hold offs only delay a fault; a fan can recover during them
+    pstHealth->u16StartMs = (pstHealth->u16StartMs > FAN_HEALTH_PERIOD_TICK) ?
+                                pstHealth->u16StartMs - FAN_HEALTH_PERIOD_TICK : 0;
+    pstHealth->u16GraceMs = (pstHealth->u16GraceMs > FAN_HEALTH_PERIOD_TICK) ?
+                                pstHealth->u16GraceMs - FAN_HEALTH_PERIOD_TICK : 0;
+
+    if(u16ExpectedRpm == 0)
+    {   // fan commanded off
+        pstHealth->ubyState        = FAN_HEALTH_OK;
+        pstHealth->u16UnderSpeedMs = 0;
+        return;
+    }
+
+    // stall time: FAN_STALL_TIMEOUT_REVS revolutions at the expected rpm
+    u32StallMs = ((uint32_t)FAN_STALL_TIMEOUT_REVS * 60000) / u16ExpectedRpm;
+    if(u32StallMs < FAN_STALL_TIMEOUT_MIN_MS)
+    {
+        u32StallMs = FAN_STALL_TIMEOUT_MIN_MS;
+    }
+    else if(u32StallMs > FAN_TACH_STALL_MS)
+    {
+        u32StallMs = FAN_TACH_STALL_MS;
+    }
+
+    if((pstHealth->u16StartMs == 0) && isFanTachStalled(ubyFanIndx, (uint16_t)u32StallMs))
+    {
+        pstHealth->ubyState = FAN_HEALTH_STALLED;
+
+#if (FAN_HEALTH_REACTIONS & FAN_REACT_KICK)
+        // refused while the supply settles; tried again next period
+        if((pstHealth->ubyKickCnt < FAN_KICK_RETRIES) && fanPwmKick(ubyFanIndx))
+        {
+            pstHealth->ubyKickCnt++;
+            // stall check resumes once the kick shows in the rpm
+            pstHealth->u16StartMs = FAN_PWM_KICK_MS + FAN_HEALTH_RPM_LAG_MS;
+        }
+#endif
+    }
+    else if(((uint32_t)u16Rpm * TMR_PWM_MAX_PER_MILLE) <
+            ((uint32_t)u16ExpectedRpm * FAN_UNDERSPEED_PM))
+    {
+        if((pstHealth->u16GraceMs == 0) && (pstHealth->u16StartMs == 0))
+        {
+            pstHealth->u16UnderSpeedMs += FAN_HEALTH_PERIOD_TICK;
+            if(pstHealth->u16UnderSpeedMs >= FAN_UNDERSPEED_MS)
+            {
+                pstHealth->u16UnderSpeedMs = FAN_UNDERSPEED_MS;
+                pstHealth->ubyState = FAN_HEALTH_UNDERSPEED;
+            }
+        }
+    }
+    else
+    {
+        pstHealth->ubyState        = FAN_HEALTH_OK;
+        pstHealth->u16UnderSpeedMs = 0;
+        pstHealth->ubyKickCnt      = 0;
+
+        // wear trend; rpm/expected once at steady speed
+        if(pstHealth->u16GraceMs == 0)
+        {
+            i32Ratio = ((int32_t)u16Rpm * TMR_PWM_MAX_PER_MILLE) / u16ExpectedRpm;
+            pstHealth->i32RatioAvg += ((i32Ratio << 8) - pstHealth->i32RatioAvg) / (1L << FAN_WEAR_EWMA_SHIFT);
+
+            if((pstHealth->i32RatioAvg >> 8) < FAN_WEAR_PM)
+            {
+                pstHealth->bWear = true;
+            }
+            else if((pstHealth->i32RatioAvg >> 8) > (FAN_WEAR_PM + FAN_WEAR_HYST_PM))
+            {
+                pstHealth->bWear = false;
+            }
+        }
+    }
+}
+
+
+uint16_t fanHealthCb(stTimerStruct_t* myTimer)
+{
+    uint8_t ubyFanIndx;
+    bool    bBoost       = false;
+    bool    bReport      = false;
+
+    for(ubyFanIndx=0; ubyFanIndx<NUM_FANS; ubyFanIndx++)
+    {
+        fanHealthCheck(ubyFanIndx);
+
+        if(gastFanHealth[ubyFanIndx].ubyState != FAN_HEALTH_OK)
+        {
+            bBoost = true;
+        }
+
+        if((gastFanHealth[ubyFanIndx].ubyState != gastFanHealth[ubyFanIndx].ubyStateReported) ||
+           (gastFanHealth[ubyFanIndx].bWear != gastFanHealth[ubyFanIndx].bWearReported))
+        {
+            bReport = true;
+        }
+    }
+
+#if (FAN_HEALTH_REACTIONS & FAN_REACT_BOOST)
+    if(bBoost != bFanBoost)
+    {
+        bFanBoost = bBoost;
+
+        // new fan targets with/without the boost
+        if(bIsThermalControlled)
+        {
+            setPwmFromTz();
+        }
+    }
+#endif
+
+#if (FAN_HEALTH_REACTIONS & FAN_REACT_EVENT)
+    if(bReport)
+    {
+        gstMainEvts.bits.svcFanHealth = true;
+    }
+#endif
+
+    return 0;
+}
+
+
+// main loop; prints the fans whose health changed since the last report
+void fanHealthReport()
+{
+    uint8_t ubyFanIndx;
+
+    gstMainEvts.bits.svcFanHealth = false;
+
+    for(ubyFanIndx=0; ubyFanIndx<NUM_FANS; ubyFanIndx++)
+    {
+        stFanHealth_t* pstHealth = &gastFanHealth[ubyFanIndx];
+
+        if((pstHealth->ubyState != pstHealth->ubyStateReported) ||
+           (pstHealth->bWear != pstHealth->bWearReported))
+        {
+            fmtBegin(UART_CLI);
+            fmtStr("\r\nFan");
+            fmtUint(ubyFanIndx, 0);
+            fmtChar(' ');
+            fmtStr(gapchFanHealthName[pstHealth->ubyState]);
+            fmtStr(pstHealth->bWear ? " wear" : "");
+            fmtStr(" Rpm=");
+            fmtUint(stFanTach[ubyFanIndx].u16Rpm, 0);
+            fmtStr(" Exp=");
+            fmtUint(pstHealth->u16ExpectedRpm, 0);
+            fmtEnd(UART_STREAM_CLI, false);
+
+            pstHealth->ubyStateReported = pstHealth->ubyState;
+            pstHealth->bWearReported    = pstHealth->bWear;
+        }
+    }
+    UART_printNewLineAndPrompt();
+}
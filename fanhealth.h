@@ -0,0 +1,54 @@
+/*
+ * fanhealth.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef FANHEALTH_H_
+#define FANHEALTH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "timer_utilities.h"
+#include "thermalcontrol.h"
+
+// expected rpm map points; duty 0, 25, 50, 75 and 100%
+#define FAN_RPM_MAP_PTS         (5)
+#define FAN_RPM_MAP_STEP_PM     (250)
+
+typedef enum FAN_HEALTH
+{
+    FAN_HEALTH_OK,
+    FAN_HEALTH_UNDERSPEED,
+    FAN_HEALTH_STALLED,
+    NUM_FAN_HEALTH_STATES
+}eFanHealth_t;
+
+typedef struct FAN_HEALTH_STATUS
+{
+    uint8_t  ubyState;              // eFanHealth_t
+    uint8_t  ubyStateReported;      // last state sent on the cli
+    bool     bWear;                 // long term rpm/expected below FAN_WEAR_PM
+    bool     bWearReported;
+    uint8_t  ubyKickCnt;            // kicks since the fan was last healthy
+    uint16_t u16StartMs;            // remaining start time; no stall check
+    uint16_t u16GraceMs;            // remaining spin up time; no under-speed check
+    uint16_t u16UnderSpeedMs;       // time continuously under speed
+    uint16_t u16PerMille;           // commanded duty at the previous check
+    uint16_t u16ExpectedRpm;
+    int32_t  i32RatioAvg;           // rpm/expected in 0.1%, scaled by 2^8
+}stFanHealth_t;
+
+extern stFanHealth_t gastFanHealth[NUM_FANS];
+extern uint16_t      au16FanRpmMap[NUM_FANS][FAN_RPM_MAP_PTS];
+extern const char* const gapchFanHealthName[NUM_FAN_HEALTH_STATES];
+
+void initFanHealth();
+void fanHealthLoadDefaults();
+uint16_t fanHealthCb(stTimerStruct_t* myTimer);
+uint16_t fanHealthExpectedRpm(uint8_t ubyFanIndx, uint16_t u16PerMille);
+uint16_t fanHealthDutyOverride(uint8_t ubyFanIndx, uint16_t u16PerMille);
+void fanHealthReport();
+
+#endif /* FANHEALTH_H_ */
@@ -6,15 +6,21 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 #include "config.h"
 #include "timer.h"
 #include "fans.h"
 #include "thermalcontrol.h"
+#include "power.h"
 
 stTimerStruct_t stFanRpmComputeTmr =
 {
     .prevTimer      = NULL,
-    .timeoutTickCnt = FAN_RPM_CALC_COUNT_TICK,
+#if (FAN_TACH_MODE == FAN_TACH_MODE_PERIOD)
+    .timeoutTickCnt = FAN_TACH_PERIOD_CALC_TICK,
+#else
+    .timeoutTickCnt = FAN_RPM_WIN_SLOT_TICK,
+#endif
     .counter        = 0,
     .recurrence     = TIMER_RECURRING,
     .status         = TIMER_RUNNING,
@@ -23,9 +29,72 @@ stTimerStruct_t stFanRpmComputeTmr =
 };
 
 
-// stFanTach[TACHforCh4, TACHforCh5] = [FAN_TACH5_P4_0, FAN_TACH4_P4_1]
+/*
+ *    FAN Controller Board; 810405; Hawk Strike
+ * fan n <=> TB3.(n+1) <=> TACH(5-n) = P4.n; first NUM_FANS entries are used
+ *  DEMEC7040SYS-02: Fan0 = PWM5 CPU (RTD5), Fan1 = PWM4 GPU (RTD4)
+ *  other fans follow the hotter of the two RTDs by default
+ */
+const stFanDesc_t gastFanDesc[FAN_MAX_NUM] =
+{
+    // PwmNum, CcrNum,    TachPin,        TachHwCntTmr,             DefSnsrMask
+    {5,        PWM5_CCR1, FAN_TACH5_P4_0, FAN_TACH_HW_CNT_TMR_FAN0, SNSR_MASK(SNSR_RTD_CH5_CPU)},
+    {4,        PWM4_CCR2, FAN_TACH4_P4_1, FAN_TACH_HW_CNT_TMR_FAN1, SNSR_MASK(SNSR_RTD_CH4_GPU)},
+    {3,        PWM3_CCR3, FAN_TACH3_P4_2, FAN_TACH_NO_HW_CNT,       SNSR_MASK(SNSR_RTD_CH5_CPU) | SNSR_MASK(SNSR_RTD_CH4_GPU)},
+    {2,        PWM2_CCR4, FAN_TACH2_P4_3, FAN_TACH_NO_HW_CNT,       SNSR_MASK(SNSR_RTD_CH5_CPU) | SNSR_MASK(SNSR_RTD_CH4_GPU)},
+    {1,        PWM1_CCR5, FAN_TACH1_P4_4, FAN_TACH_NO_HW_CNT,       SNSR_MASK(SNSR_RTD_CH5_CPU) | SNSR_MASK(SNSR_RTD_CH4_GPU)},
+    {0,        PWM0_CCR6, FAN_TACH0_P4_5, FAN_TACH_NO_HW_CNT,       SNSR_MASK(SNSR_RTD_CH5_CPU) | SNSR_MASK(SNSR_RTD_CH4_GPU)},
+};
+
+stTimerStruct_t stFanPwmEngineTmr =
+{
+    .prevTimer      = NULL,
+    .timeoutTickCnt = FAN_PWM_ENGINE_TICK,
+    .counter        = 0,
+    .recurrence     = TIMER_RECURRING,
+    .status         = TIMER_RUNNING,
+    .callback       = fanPwmEngineCb,
+    .nextTimer      = NULL
+};
+
+stFanPwmCh_t gastFanPwm[NUM_FANS];
+// fan ramping up; FAN_NONE => none
+static uint8_t ubyFanPwmRamping;
+// fan served first on the next engine tick
+static uint8_t ubyFanPwmNext;
+
 stFanTach_t stFanTach[NUM_FANS];
-uint8_t ubyRpmCalcSecPrd;
+// P4 pin => fan index; FAN_NONE when the pin is not a tach in use
+static uint8_t aubyTachPinToFan[8];
+// P4 pins of the tachs counted by the edge interrupt
+static uint8_t ubyTachIntMask;
+
+#if (FAN_TACH_MODE == FAN_TACH_MODE_PERIOD)
+// RPM = u32TachRpmScaled / average period (free running timer counts)
+static uint32_t u32TachRpmScaled;
+// stall time in free running timer counts; also the longest valid period
+static uint32_t u32TachStallCnt;
+// free running timer counts per ms
+static uint32_t u32TachCntPerMs;
+
+static void fanTachEdge(uint8_t ubyFanIndx);
+#endif
+
+#if (FAN_TACH_MODE != FAN_TACH_MODE_PERIOD)
+// rpm per pulse for a 1 ms window, 16 fraction bits; fits 32 bits
+#define FAN_RPM_PER_PULSE_MS_Q16    ((60000UL * 65536UL) / FAN_TACH_PULSES_PER_REV)
+
+// slot lengths (uptime ms) of the rpm window; shared by all fans
+static uint16_t au16RpmWinMs[FAN_RPM_WIN_SLOTS];
+static uint32_t u32RpmWinMsSum;
+static uint32_t u32RpmWinPrevMs;
+static uint8_t  ubyRpmWinIndx;
+#endif
+
+#if (FAN_TACH_MODE == FAN_TACH_MODE_HW_COUNT)
+// counter value at the previous rpm calculation
+static uint16_t au16FanTachHwCntPrev[NUM_FANS];
+#endif
 
 
 /*
@@ -38,10 +107,7 @@ uint8_t ubyRpmCalcSecPrd;
  */
 void initFans()
 {
-    // in the acquistion table, , if first sensor is the internal sensor, need to skip forcing its value.
-    // => valid gubyPwmInTest values will be [1 - NUM_FANS]
-    gubyPwmInTest = 1;
-    gbyTestTemperatureVal = MIN_TEST_TEMPERATURE;   // init the starting temperature for testing
+    uint8_t ubyIndx;
 
     /*
      * Note: must not interchange the following two functions.
@@ -58,17 +124,84 @@ void initFans()
     //  - PWM Waveform (Output Mode)
     cfgPwmDutyCyclesForFanCtrl(0);  // cfg pinmux, duty cycles(init 0) for TB3.1 (PWM5) to TB3.6 (PWM0)
 
+    // from here on, duty changes are loaded at the start of a pwm period
+    TMR_PwmCfgLatchedUpdates(FAN_PWM_TMR);
+
+    // all fans stopped; engine moves them to the thermal control duty
+    memset(gastFanPwm, 0, sizeof(gastFanPwm));
+    ubyFanPwmRamping = FAN_NONE;
+    ubyFanPwmNext    = 0;
+
+    // tach pin to fan look up for PORT4_ISR
+    memset(aubyTachPinToFan, FAN_NONE, sizeof(aubyTachPinToFan));
+    ubyTachIntMask = 0;
+    for(ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        aubyTachPinToFan[gastFanDesc[ubyIndx].ubyTachPin] = ubyIndx;
+#if (FAN_TACH_MODE == FAN_TACH_MODE_HW_COUNT)
+        // a fan counted by a timer does not need the edge interrupt
+        if(gastFanDesc[ubyIndx].ubyTachHwCntTmr != FAN_TACH_NO_HW_CNT)
+        {
+            continue;
+        }
+#endif
+        ubyTachIntMask |= 1 << gastFanDesc[ubyIndx].ubyTachPin;
+    }
+
+
     // configure ports used for Tachometers for all fans running; set all as input & with int pull-up
     cfgGpio4DirPullRes();
 
     // configure gpio for fan tach interrupt be generated when transition high to low
     cfgGpio4IntTachCount();
 
-    // convert RPM calculate wait period ticks into seconds
-    ubyRpmCalcSecPrd = FAN_RPM_CALC_COUNT_TICK * TMR_TICKER_PERIOD;
+#if (FAN_TACH_MODE != FAN_TACH_MODE_PERIOD)
+    // empty rpm window; the first slot starts now
+    memset(au16RpmWinMs, 0, sizeof(au16RpmWinMs));
+    u32RpmWinMsSum  = 0;
+    u32RpmWinPrevMs = TMR_GetUptimeMs();
+    ubyRpmWinIndx   = 0;
+#endif
+
+#if (FAN_TACH_MODE == FAN_TACH_MODE_HW_COUNT)
+    for(ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        if(gastFanDesc[ubyIndx].ubyTachHwCntTmr != FAN_TACH_NO_HW_CNT)
+        {
+            TMR_CfgExtClkCounter(gastFanDesc[ubyIndx].ubyTachHwCntTmr);
+            au16FanTachHwCntPrev[ubyIndx] = TMR_ReadExtClkCounter(gastFanDesc[ubyIndx].ubyTachHwCntTmr);
+        }
+    }
+#endif
+
+#if (FAN_TACH_MODE == FAN_TACH_MODE_PERIOD)
+    // time base for the tach edges
+    TMR_CfgFreeRunTimer();
+
+    // rev/min = 60 * timer Hz / (pulses/rev * period counts)
+    u32TachRpmScaled = (TMR_GetFreeRunHz() * 60) / FAN_TACH_PULSES_PER_REV;
+
+    u32TachCntPerMs  = TMR_GetFreeRunHz() / 1000;
+
+    // periods are stored in 16 bits; stall time can not exceed that
+    u32TachStallCnt  = (TMR_GetFreeRunHz() * FAN_TACH_STALL_MS) / 1000;
+    if (u32TachStallCnt > 0xFFFF)
+    {
+        u32TachStallCnt = 0xFFFF;
+    }
+
+    // make the 1st edge look like it ends a stall; it only starts the average
+    for(ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        stFanTach[ubyIndx].u32LastEdgeTs = TMR_GetFreeRunTs() - u32TachStallCnt - 1;
+    }
+#endif
 
     registerTimer(&stFanRpmComputeTmr);
     enableDisableTimer(&stFanRpmComputeTmr, TMR_ENABLE);
+
+    registerTimer(&stFanPwmEngineTmr);
+    enableDisableTimer(&stFanPwmEngineTmr, TMR_ENABLE);
 }
 
 
@@ -117,76 +250,357 @@ void cfgGpioP4ForTachCount(uint8_t ubyGp4Num, uint8_t ubyIsOutput, eGpioIntPullR
 
 void cfgPwmDutyCyclesForFanCtrl(uint8_t ubyDCpercentage)
 {
-    // cfg PWM output mode for TimerB3 CCRx with output mode 7
-    TMR_PwmOutModeAndPinMuxforTimberBxAndCcrX(TMR_B3, PWM4_CCR2, CC_CNTL_REG_OUTMOD7);
-    TMR_PwmOutModeAndPinMuxforTimberBxAndCcrX(TMR_B3, PWM5_CCR1, CC_CNTL_REG_OUTMOD7);
+    uint8_t ubyIndx;
+
+    for(ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        // cfg PWM output mode for TimerB3 CCRx with output mode 7
+        TMR_PwmOutModeAndPinMuxforTimberBxAndCcrX(FAN_PWM_TMR, gastFanDesc[ubyIndx].ubyCcrNum, CC_CNTL_REG_OUTMOD7);
 
-    // cfg PWM percentage
-    TMR_PwmSetPercentage(TMR_B3, PWM4_CCR2, ubyDCpercentage);            // P6.1 TMR_CCR2
-    TMR_PwmSetPercentage(TMR_B3, PWM5_CCR1, ubyDCpercentage);            // P6.0 TMR_CCR1
+        // cfg PWM percentage
+        TMR_PwmStagePercentage(FAN_PWM_TMR, gastFanDesc[ubyIndx].ubyCcrNum, ubyDCpercentage);
+    }
+    TMR_PwmCommitStaged(FAN_PWM_TMR);
+}
+
+
+// duty the engine moves the fan to; see fanPwmEngineCb()
+void fanPwmSetTarget(uint8_t ubyFanIndx, uint16_t u16PerMille)
+{
+    if(u16PerMille > TMR_PWM_MAX_PER_MILLE)
+    {
+        u16PerMille = TMR_PWM_MAX_PER_MILLE;
+    }
+    gastFanPwm[ubyFanIndx].u16TargetPm = u16PerMille;
 }
 
 
 /*
- * Calculate RPM periodically
- * Period in ticks is converted into seconds during fan initialization fanInit()
- *  i.e.    ubyRpmCalcSecPrd = FAN_RPM_CALC_COUNT_TICK * TMR_TICKER_PERIOD;
- *
- * 1st det #of revolution per rpm calculating period
- * - knowing that it takes 2 pulses per rev then
- *   # of rev per period = # of pulses counted / 2 = u16TotalRevPerPrd
- *   u16TotalRevPerPrd = stFanTach[ubyIndx].u16TachCount / 2;
- *
- * 2nd det RPM value for one sec
- * - # of rev per period / ubyRpmCalcSecPrd
- *   u16TotalRevPerPrd/ubyRpmCalcSecPrd
- *
- * 3rd det RPM, value for 1 minute == 60 seconds
- * - multiply result from 2nd step by 60
- *   (u16TotalRevPerPrd/ubyRpmCalcSecPrd) * 60
- *
- *   for integer math, it's better to multiply 1st before dividing
- *   (u16TotalRevPerPrd * 60) / ubyRpmCalcSecPrd
+ * fanPwmKick(): drive the fan at 100% for FAN_PWM_KICK_MS, then settle
+ *  back to its target. returns false when the supply inrush window is
+ *  taken; caller retries.
+ */
+bool fanPwmKick(uint8_t ubyFanIndx)
+{
+    stFanPwmCh_t* pstCh = &gastFanPwm[ubyFanIndx];
+
+    if(pstCh->u16KickMs)
+    {
+        return true;
+    }
+
+    if((FAN_PWM_KICK_MS == 0) || !pwrInrushRequest())
+    {
+        return false;
+    }
+
+    pstCh->u16OutPm  = TMR_PWM_MAX_PER_MILLE;
+    pstCh->u16KickMs = FAN_PWM_KICK_MS;
+
+    return true;
+}
+
+
+/*
+ * fan pwm engine; every FAN_PWM_ENGINE_TICK moves each fan duty toward
+ *  its target:
+ *  - slowing down: FAN_PWM_SLEW_PM per tick
+ *  - speeding up : one fan at a time (ubyFanPwmRamping), FAN_PWM_SLEW_PM
+ *    per tick. the ramp starts once the supply inrush window is free;
+ *    a stopped fan starts with a kick at 100%. fans are not held back by
+ *    the power budget, they only reserve their share of it.
+ *  fans are served round robin so the same fan does not always win the
+ *  inrush window. all duty changes of a tick are committed together.
+ */
+uint16_t fanPwmEngineCb(stTimerStruct_t* myTimer)
+{
+    uint8_t  ubyIndx;
+    uint8_t  ubyFanIndx;
+    uint16_t u16Step;
+    stFanPwmCh_t* pstCh;
+
+    ubyFanIndx = ubyFanPwmNext;
+    for(ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        pstCh = &gastFanPwm[ubyFanIndx];
+
+        if(pstCh->u16KickMs)
+        {
+            pstCh->u16KickMs = (pstCh->u16KickMs > FAN_PWM_ENGINE_TICK) ?
+                                    pstCh->u16KickMs - FAN_PWM_ENGINE_TICK : 0;
+        }
+        else if(pstCh->u16OutPm > pstCh->u16TargetPm)
+        {
+            u16Step = pstCh->u16OutPm - pstCh->u16TargetPm;
+            pstCh->u16OutPm -= (u16Step > FAN_PWM_SLEW_PM) ? FAN_PWM_SLEW_PM : u16Step;
+        }
+        else if(pstCh->u16OutPm < pstCh->u16TargetPm)
+        {
+            if((ubyFanPwmRamping == FAN_NONE) && pwrInrushRequest())
+            {
+                ubyFanPwmRamping = ubyFanIndx;
+
+                // a low duty may not start a stopped fan
+                if((pstCh->u16OutPm == 0) && FAN_PWM_KICK_MS)
+                {
+                    pstCh->u16OutPm  = TMR_PWM_MAX_PER_MILLE;
+                    pstCh->u16KickMs = FAN_PWM_KICK_MS;
+                }
+            }
+
+            if((ubyFanPwmRamping == ubyFanIndx) && (pstCh->u16KickMs == 0))
+            {
+                u16Step = pstCh->u16TargetPm - pstCh->u16OutPm;
+                pstCh->u16OutPm += (u16Step > FAN_PWM_SLEW_PM) ? FAN_PWM_SLEW_PM : u16Step;
+            }
+        }
+
+        // ramp done; the next fan may start
+        if((ubyFanPwmRamping == ubyFanIndx) && (pstCh->u16KickMs == 0) &&
+           (pstCh->u16OutPm >= pstCh->u16TargetPm))
+        {
+            ubyFanPwmRamping = FAN_NONE;
+        }
+
+        // unchanged duties are skipped by the timer driver
+        TMR_PwmStagePerMille(FAN_PWM_TMR, gastFanDesc[ubyFanIndx].ubyCcrNum, pstCh->u16OutPm);
+
+        // power budget keeps room for the duty the fan is heading to
+        pwrSetLoadMa(PWR_LOAD_FAN0 + ubyFanIndx,
+                     pwrFanMa((pstCh->u16TargetPm > pstCh->u16OutPm) ? pstCh->u16TargetPm : pstCh->u16OutPm));
+
+        if(++ubyFanIndx >= NUM_FANS)
+        {
+            ubyFanIndx = 0;
+        }
+    }
+
+    if(++ubyFanPwmNext >= NUM_FANS)
+    {
+        ubyFanPwmNext = 0;
+    }
+
+    // apply the fan changes staged above together
+    CYCLE_BENCH_START(BENCH_PWM_COMMIT);
+    TMR_PwmCommitStaged(FAN_PWM_TMR);
+    CYCLE_BENCH_STOP(BENCH_PWM_COMMIT);
+
+    return 0;
+}
+
+
+#if (FAN_TACH_MODE == FAN_TACH_MODE_PERIOD)
+/*
+ * period mode: PORT4_ISR keeps, per fan, the sum of the last
+ *  FAN_TACH_PERIOD_AVG_CNT edge periods (see fanTachEdge()).
+ *  RPM = u32TachRpmScaled * # of periods / sum of periods
+ * a fan with no edge for FAN_TACH_STALL_MS reads 0 RPM.
  */
 uint16_t fanRpmComputeCb(stTimerStruct_t* myTimer)
 {
-    uint8_t ubyIndx;
-    uint16_t u16TotalRevPerPrd;
+    uint8_t  ubyIndx;
+    uint8_t  ubyPeriodCnt;
+    uint32_t u32PeriodSum;
+    uint32_t u32EdgeAge;
+    uint16_t u16IntState;
 
     for(ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
     {
-        // det Rev per Period
-        u16TotalRevPerPrd = stFanTach[ubyIndx].u16TachCount / 2;
+        // snapshot what the ISR updates
+        u16IntState = __get_interrupt_state();
+        __disable_interrupt();
+        u32EdgeAge   = TMR_GetFreeRunTs() - stFanTach[ubyIndx].u32LastEdgeTs;
+        u32PeriodSum = stFanTach[ubyIndx].u32PeriodSum;
+        ubyPeriodCnt = stFanTach[ubyIndx].ubyPeriodCnt;
+        stFanTach[ubyIndx].u16TachCountPrevious = stFanTach[ubyIndx].u16TachCount;
+        stFanTach[ubyIndx].u16TachCount = 0;
+        __set_interrupt_state(u16IntState);
 
-        // transpose rev/period to rev/min = RPM
-        stFanTach[ubyIndx].u16Rpm = (u16TotalRevPerPrd * 60) / ubyRpmCalcSecPrd;
+        if((ubyPeriodCnt == 0) || (u32PeriodSum == 0) || (u32EdgeAge > u32TachStallCnt))
+        {
+            stFanTach[ubyIndx].u16Rpm = 0;
+        }
+        else
+        {
+            stFanTach[ubyIndx].u16Rpm = (uint16_t)((u32TachRpmScaled * ubyPeriodCnt) / u32PeriodSum);
+        }
 
         // store previous RPM value
         stFanTach[ubyIndx].u16RpmPrevious = stFanTach[ubyIndx].u16Rpm;
+    }
 
-        // store tach count before clearing
-        stFanTach[ubyIndx].u16TachCountPrevious = stFanTach[ubyIndx].u16TachCount;
+    return 0;
+}
 
-        stFanTach[ubyIndx].u16TachCount = 0;
+
+/*
+ * fanTachEdge(): called from PORT4_ISR on each tach edge of a fan.
+ *  the period since the previous edge replaces the oldest one of the last
+ *  FAN_TACH_PERIOD_AVG_CNT periods; the running sum is kept so the average
+ *  needs no loop. an edge after a gap longer than the stall time is not a
+ *  tach period; it restarts the average.
+ */
+static void fanTachEdge(uint8_t ubyFanIndx)
+{
+    stFanTach_t* pstTach = &stFanTach[ubyFanIndx];
+    uint32_t u32Ts       = TMR_GetFreeRunTs();
+    uint32_t u32Period   = u32Ts - pstTach->u32LastEdgeTs;
+
+    pstTach->u32LastEdgeTs = u32Ts;
+    pstTach->u16TachCount++;
+
+    if(u32Period > u32TachStallCnt)
+    {
+        pstTach->ubyPeriodCnt  = 0;
+        pstTach->ubyPeriodIndx = 0;
+        pstTach->u32PeriodSum  = 0;
+        return;
+    }
+
+    if(pstTach->ubyPeriodCnt == FAN_TACH_PERIOD_AVG_CNT)
+    {   // drop the oldest period
+        pstTach->u32PeriodSum -= pstTach->au16Period[pstTach->ubyPeriodIndx];
+    }
+    else
+    {
+        pstTach->ubyPeriodCnt++;
+    }
+
+    pstTach->au16Period[pstTach->ubyPeriodIndx] = (uint16_t)u32Period;
+    pstTach->u32PeriodSum += u32Period;
+
+    if(++pstTach->ubyPeriodIndx >= FAN_TACH_PERIOD_AVG_CNT)
+    {
+        pstTach->ubyPeriodIndx = 0;
+    }
+}
+#else
+/*
+ * count modes: tach pulses are counted per FAN_RPM_WIN_SLOT_TICK slot and
+ *  the rpm is over the last FAN_RPM_WIN_SLOTS slots (sliding window).
+ *  slot lengths are read from the uptime clock, so the window needs not be
+ *  whole seconds and the timer overrun is accounted for.
+ *   RPM = pulses * 60000 / (pulses per rev * window ms)
+ *  the rpm of one pulse (Q16) is divided out once per call; each fan is
+ *  then two 16 x 16 => 32 multiplies (MPY32), its whole and fraction
+ *  parts; no 64 bit math. a window not yet full covers the slots so far.
+ */
+uint16_t fanRpmComputeCb(stTimerStruct_t* myTimer)
+{
+    uint8_t      ubyIndx;
+    uint16_t     u16Pulses;
+    uint32_t     u32NowMs;
+    uint32_t     u32RpmPerPulseQ16;
+    uint32_t     u32RpmWhole;
+    uint32_t     u32RpmFrac;
+    uint16_t     u16IntState;
+    stFanTach_t* pstTach;
+#if (FAN_TACH_MODE == FAN_TACH_MODE_HW_COUNT)
+    uint16_t     u16HwCnt;
+#endif
+
+    // slot just ended replaces the oldest one
+    u32NowMs        = TMR_GetUptimeMs();
+    u32RpmWinMsSum -= au16RpmWinMs[ubyRpmWinIndx];
+    au16RpmWinMs[ubyRpmWinIndx] = (uint16_t)(u32NowMs - u32RpmWinPrevMs);
+    u32RpmWinMsSum += au16RpmWinMs[ubyRpmWinIndx];
+    u32RpmWinPrevMs = u32NowMs;
+
+    u32RpmPerPulseQ16 = (u32RpmWinMsSum != 0) ? (FAN_RPM_PER_PULSE_MS_Q16 / u32RpmWinMsSum) : 0;
+
+    for(ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        pstTach = &stFanTach[ubyIndx];
+
+#if (FAN_TACH_MODE == FAN_TACH_MODE_HW_COUNT)
+        if(gastFanDesc[ubyIndx].ubyTachHwCntTmr != FAN_TACH_NO_HW_CNT)
+        {   // pulses counted by the timer since the previous call
+            u16HwCnt  = TMR_ReadExtClkCounter(gastFanDesc[ubyIndx].ubyTachHwCntTmr);
+            u16Pulses = u16HwCnt - au16FanTachHwCntPrev[ubyIndx];
+            au16FanTachHwCntPrev[ubyIndx] = u16HwCnt;
+        }
+        else
+#endif
+        {   // pulses counted by PORT4_ISR
+            u16IntState = __get_interrupt_state();
+            __disable_interrupt();
+            u16Pulses = pstTach->u16TachCount;
+            pstTach->u16TachCount = 0;
+            __set_interrupt_state(u16IntState);
+        }
+
+        pstTach->u16WinPulseSum -= pstTach->au16WinPulses[ubyRpmWinIndx];
+        pstTach->au16WinPulses[ubyRpmWinIndx] = u16Pulses;
+        pstTach->u16WinPulseSum += u16Pulses;
+
+        // (pulses * Q16) >> 12, exact; >= 2^28 (Q4) is far above UINT16_MAX rpm
+        u32RpmWhole = (uint32_t)pstTach->u16WinPulseSum * (uint16_t)(u32RpmPerPulseQ16 >> 16);
+        u32RpmFrac  = (uint32_t)pstTach->u16WinPulseSum * (uint16_t)u32RpmPerPulseQ16;
+        pstTach->u32RpmQ4 = (u32RpmWhole >= (1UL << 24)) ? UINT32_MAX : ((u32RpmWhole << 4) + (u32RpmFrac >> 12));
+        pstTach->u16Rpm   = (pstTach->u32RpmQ4 >= ((uint32_t)UINT16_MAX << 4)) ?
+                                UINT16_MAX : (uint16_t)((pstTach->u32RpmQ4 + 8) >> 4);
+
+        // store previous RPM value
+        pstTach->u16RpmPrevious = pstTach->u16Rpm;
+
+        // pulses of the last slot
+        pstTach->u16TachCountPrevious = u16Pulses;
+    }
+
+    if(++ubyRpmWinIndx >= FAN_RPM_WIN_SLOTS)
+    {
+        ubyRpmWinIndx = 0;
     }
 
     return 0;
 }
+#endif
+
+/*
+ * isFanTachStalled(): true when the fan had no tach edge for u16TimeoutMs
+ *  period mode: age of the last edge time stamp; timeout up to FAN_TACH_STALL_MS
+ *  count modes: no edge in the last rpm window; u16TimeoutMs is not used
+ */
+bool isFanTachStalled(uint8_t ubyFanIndx, uint16_t u16TimeoutMs)
+{
+#if (FAN_TACH_MODE == FAN_TACH_MODE_PERIOD)
+    uint32_t u32EdgeAge;
+    uint16_t u16IntState;
+
+    u16IntState = __get_interrupt_state();
+    __disable_interrupt();
+    u32EdgeAge  = TMR_GetFreeRunTs() - stFanTach[ubyFanIndx].u32LastEdgeTs;
+    __set_interrupt_state(u16IntState);
+
+    return (u32EdgeAge > (uint32_t)u16TimeoutMs * u32TachCntPerMs);
+#else
+    return (stFanTach[ubyFanIndx].u16Rpm == 0);
+#endif
+}
 
 void cfgGpio4DirPullRes()
 {
+    uint8_t ubyIndx;
+
     // ----------------------------- Config GPIO Direction for Tach Count
-    // TACH4=P4.1, TACH5=P4.0
-    cfgGpioP4ForTachCount(FAN_TACH4_P4_1, GPIO_DIR_INPUT, GPIO_INTERNAL_RES_PULLED_UP);
-    cfgGpioP4ForTachCount(FAN_TACH5_P4_0, GPIO_DIR_INPUT, GPIO_INTERNAL_RES_PULLED_UP);
+    for(ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        cfgGpioP4ForTachCount(gastFanDesc[ubyIndx].ubyTachPin, GPIO_DIR_INPUT, GPIO_INTERNAL_RES_PULLED_UP);
+    }
 }
 
 void cfgGpio4IntTachCount()
 {
+    uint8_t ubyIndx;
+
     // ----------------------------- Config GPIO Int Gen Direction & enable Int
-    // TACH4=P4.1, TACH5=P4.0
-    cfgGpioP4Int(GPIO_PORT4_CH1, GPIO_INT_ENABLED, GPIO_INT_GEN_BYHIGH2LOW);
-    cfgGpioP4Int(GPIO_PORT4_CH0, GPIO_INT_ENABLED, GPIO_INT_GEN_BYHIGH2LOW);
+    // ubyTachIntMask leaves out the fans counted by a timer
+    for(ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        cfgGpioP4Int(gastFanDesc[ubyIndx].ubyTachPin,
+                     (ubyTachIntMask >> gastFanDesc[ubyIndx].ubyTachPin) & 1,
+                     GPIO_INT_GEN_BYHIGH2LOW);
+    }
 }
 
 void cfgGpioP4Int(uint8_t ubyGp4Num, uint8_t ubyIsIntEnabled, uint8_t ubyEdgeDir)
@@ -211,7 +625,7 @@ void deInitTachs()
     // tachs are implemented through gpio's configured as inputs
     // high to low transition indicates a pulse start
     // all needed is disable interrupt
-    P4IE  &= ~(BIT1 | BIT0);
+    P4IE  &= ~ubyTachIntMask;
 }
 
 
@@ -224,39 +638,21 @@ void __attribute__ ((interrupt(PORT4_VECTOR))) Port_4 (void)
 #error Compiler not supported!
 #endif
 {
-    switch(__even_in_range(P4IV,P4IV__P4IFG7))
+    uint16_t u16P4Iv;
+    uint8_t  ubyFanIndx;
+
+    // reading P4IV clears the flag it reports; serve all pending edges
+    while((u16P4Iv = P4IV) != P4IV__NONE)
     {
-    case P4IV__P4IFG5:
-        P4IFG &= ~BIT5;
-//        stFanTach[FAN_TACH0_P4_5].u16TachCount++;   // TACH0 <=> PWM0 TB3.6, P6.5, Ch8
-        break;
-
-    case P4IV__P4IFG4:
-        P4IFG &= ~BIT4;
-//        stFanTach[FAN_TACH1_P4_4].u16TachCount++;   // TACH1 <=> PWM1 TB3.5, P6.4, Ch9
-        break;
-
-    case P4IV__P4IFG3:
-        P4IFG &= ~BIT3;
-//        stFanTach[FAN_TACH2_P4_3].u16TachCount++;   // TACH2 <=> PWM2 TB3.4, P6.3, Ch10
-        break;
-
-    case P4IV__P4IFG2:
-        P4IFG &= ~BIT2;
-//        stFanTach[FAN_TACH3_P4_2].u16TachCount++;   // TACH3 <=> PWM3 TB3.3, P6.2, Ch11
-        break;
-
-    case P4IV__P4IFG1:
-        P4IFG &= ~BIT1;
-        stFanTach[FAN_TACH4_P4_1].u16TachCount++;   // TACH4 <=> PWM4 TB3.2, P6.1, Ch4
-        break;
-
-    case P4IV__P4IFG0:
-        P4IFG &= ~BIT0;
-        stFanTach[FAN_TACH5_P4_0].u16TachCount++;   // TACH5 <=> PWM5 TB3.1, P6.0, Ch5
-        break;
-
-    default:
-        break;
+        // P4IV = 2 * (pin + 1)
+        ubyFanIndx = aubyTachPinToFan[(u16P4Iv >> 1) - 1];
+        if(ubyFanIndx != FAN_NONE)
+        {
+#if (FAN_TACH_MODE == FAN_TACH_MODE_PERIOD)
+            fanTachEdge(ubyFanIndx);
+#else
+            stFanTach[ubyFanIndx].u16TachCount++;
+#endif
+        }
     }
 }
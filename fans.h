@@ -9,6 +9,7 @@
 #define FANS_H_
 
 #include <stdio.h>
+#include "config.h"
 #include "timer_utilities.h"
 
 
@@ -50,14 +51,59 @@
 #define GPIO_INT_GEN_BYLOW2HIGH         (0)
 #define GPIO_INT_GEN_BYHIGH2LOW         (1)
 
+#define FAN_MAX_NUM                     (6)     // TB3.1 to TB3.6
+#if (NUM_FANS > FAN_MAX_NUM)
+#error NUM_FANS exceeds the fan pwms of TB3
+#endif
+
+// all fan pwms are on TB3; staged duties are committed together
+#define FAN_PWM_TMR                     (TMR_B3)
+#define FAN_NONE                        (0xFF)
+
+/*
+ * fan descriptor; one entry per fan, fan index = entry index.
+ *  ubyDefSnsrMask is the sensor set of the fan when the persistent
+ *  memory is initialized (see astFanSnsrMap[], 'set map' cmd).
+ */
+typedef struct FAN_DESC
+{
+    uint8_t ubyPwmNum;          // schematic PWM#; not CCR#
+    uint8_t ubyCcrNum;          // FAN_PWM_TMR CCR
+    uint8_t ubyTachPin;         // P4.x
+    uint8_t ubyTachHwCntTmr;    // FAN_TACH_NO_HW_CNT => P4 interrupt
+    uint8_t ubyDefSnsrMask;
+}stFanDesc_t;
+
+// fan pwm engine channel; see fanPwmEngineCb()
+typedef struct FAN_PWM_CH
+{
+    uint16_t    u16TargetPm;        // duty asked by thermal control
+    uint16_t    u16OutPm;           // duty programmed
+    uint16_t    u16KickMs;          // remaining kick time at 100%
+}stFanPwmCh_t;
+
 typedef struct FAN_TACH
 {
     uint16_t    u16TachCount;
     uint16_t    u16TachCountPrevious;
     uint16_t    u16Rpm;
     uint16_t    u16RpmPrevious;
+#if (FAN_TACH_MODE == FAN_TACH_MODE_PERIOD)
+    // written by PORT4_ISR; time stamps/periods in free running timer counts
+    uint32_t    u32LastEdgeTs;
+    uint32_t    u32PeriodSum;                           // sum of au16Period[]
+    uint16_t    au16Period[FAN_TACH_PERIOD_AVG_CNT];
+    uint8_t     ubyPeriodIndx;                          // next slot to write
+    uint8_t     ubyPeriodCnt;                           // valid periods
+#else
+    // pulses of the last FAN_RPM_WIN_SLOTS slots; see fanRpmComputeCb()
+    uint16_t    au16WinPulses[FAN_RPM_WIN_SLOTS];
+    uint16_t    u16WinPulseSum;
+    uint32_t    u32RpmQ4;                               // rpm; 4 fraction bits
+#endif
 }stFanTach_t;
 
+
 typedef enum GPIO_PULL_RES_STATUS
 {
     GPIO_INTERNAL_RES_DISABLED,
@@ -67,11 +113,17 @@ typedef enum GPIO_PULL_RES_STATUS
 
 
 extern stFanTach_t stFanTach[];
+extern const stFanDesc_t gastFanDesc[FAN_MAX_NUM];
+extern stFanPwmCh_t gastFanPwm[];
 
 void initFans();
 void deInitTachs();
 uint16_t fanRpmComputeCb(stTimerStruct_t* myTimer);
+bool isFanTachStalled(uint8_t ubyFanIndx, uint16_t u16TimeoutMs);
 void cfgPwmDutyCyclesForFanCtrl(uint8_t ubyDCpercentage);
+void fanPwmSetTarget(uint8_t ubyFanIndx, uint16_t u16PerMille);
+bool fanPwmKick(uint8_t ubyFanIndx);
+uint16_t fanPwmEngineCb(stTimerStruct_t* myTimer);
 void cfgGpio4DirPullRes();
 void cfgGpioP4ForTachCount(uint8_t ubyGp4Num, uint8_t ubyIsOutput, eGpioIntPullResState_t eResistor);
 void cfgGpio4IntTachCount();
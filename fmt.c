@@ -0,0 +1,198 @@
+/*
+ * fmt.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <string.h>
+#include "uart.h"
+#include "fmt.h"
+
+// longest field: a sign and 10 digits of a uint32_t, or 8 hex digits
+#define FMT_DIGITS_MAX      (11)
+
+static eUartNum_t eFmtUart;
+
+static const char achFmtHex[16] = "0123456789ABCDEF";
+static const char achFmtPad[FMT_WIDTH_MASK] =
+    "                                                               ";
+
+
+void fmtBegin(eUartNum_t eUartNum)
+{
+    eFmtUart = eUartNum;
+    UART_txStageBegin(eUartNum);
+}
+
+
+uint16_t fmtEnd(eUartStream_t eStream, bool bWhole)
+{
+    return UART_txCommit(eFmtUart, eStream, bWhole);
+}
+
+
+void fmtChar(char chVal)
+{
+    UART_txStage(eFmtUart, &chVal, 1);
+}
+
+
+void fmtStr(const char* pchStr)
+{
+    UART_txStage(eFmtUart, pchStr, strlen(pchStr));
+}
+
+
+// u16Len chars in a field of ubyWidth; spaces ahead unless FMT_LEFT
+static void fmtField(const char* pchVal, uint16_t u16Len, uint8_t ubyWidth)
+{
+    uint8_t ubyPad = ubyWidth & FMT_WIDTH_MASK;
+
+    ubyPad = (ubyPad > u16Len) ? (ubyPad - u16Len) : 0;
+
+    if (!(ubyWidth & FMT_LEFT))
+    {
+        UART_txStage(eFmtUart, achFmtPad, ubyPad);
+    }
+    UART_txStage(eFmtUart, pchVal, u16Len);
+    if (ubyWidth & FMT_LEFT)
+    {
+        UART_txStage(eFmtUart, achFmtPad, ubyPad);
+    }
+}
+
+
+void fmtStrW(const char* pchStr, uint8_t ubyWidth)
+{
+    fmtField(pchStr, strlen(pchStr), ubyWidth);
+}
+
+
+/*
+ * fmtDigits(): the decimal digits of u32Val at the end of pchEnd, at least
+ *  ubyMin of them ('0' ahead). returns the first digit. 16 bit values are
+ *  divided in 16 bits; no 32 bit divide call.
+ */
+static char* fmtDigits(char* pchEnd, uint32_t u32Val, uint8_t ubyMin)
+{
+    uint16_t u16Val;
+
+    while (u32Val > 0xFFFF)
+    {
+        *--pchEnd = '0' + (char)(u32Val % 10);
+        u32Val /= 10;
+        if (ubyMin)
+        {
+            ubyMin--;
+        }
+    }
+
+    u16Val = (uint16_t)u32Val;
+    do
+    {
+        *--pchEnd = '0' + (char)(u16Val % 10);
+        u16Val /= 10;
+        if (ubyMin)
+        {
+            ubyMin--;
+        }
+    } while (u16Val || ubyMin);
+
+    return pchEnd;
+}
+
+
+// sign, then FMT_ZERO padding between the sign and the digits
+static void fmtNum(char* pchDigits, char* pchEnd, bool bNeg, uint8_t ubyWidth)
+{
+    uint8_t ubyLen = (uint8_t)(pchEnd - pchDigits) + bNeg;
+
+    if (ubyWidth & FMT_ZERO)
+    {
+        while ((ubyLen < (ubyWidth & FMT_WIDTH_MASK)) && (ubyLen < FMT_DIGITS_MAX))
+        {
+            *--pchDigits = '0';
+            ubyLen++;
+        }
+    }
+    if (bNeg)
+    {
+        *--pchDigits = '-';
+    }
+
+    fmtField(pchDigits, ubyLen, ubyWidth);
+}
+
+
+void fmtUint(uint32_t u32Val, uint8_t ubyWidth)
+{
+    char  achDigits[FMT_DIGITS_MAX];
+    char* pchEnd = &achDigits[FMT_DIGITS_MAX];
+
+    fmtNum(fmtDigits(pchEnd, u32Val, 1), pchEnd, false, ubyWidth);
+}
+
+
+void fmtInt(int32_t i32Val, uint8_t ubyWidth)
+{
+    char     achDigits[FMT_DIGITS_MAX + 1];
+    char*    pchEnd = &achDigits[FMT_DIGITS_MAX + 1];
+    uint32_t u32Mag = (i32Val < 0) ? (0 - (uint32_t)i32Val) : (uint32_t)i32Val;
+
+    fmtNum(fmtDigits(pchEnd, u32Mag, 1), pchEnd, (i32Val < 0), ubyWidth);
+}
+
+
+/*
+ * fmtFix(): fixed point; i32Val in units of 10^-ubyPlaces, e.g.
+ *  fmtFix(-2345, 2, 0) => "-23.45", fmtFix(5, 2, 0) => "0.05"
+ */
+void fmtFix(int32_t i32Val, uint8_t ubyPlaces, uint8_t ubyWidth)
+{
+    char     achDigits[FMT_DIGITS_MAX + 2];
+    char*    pchEnd = &achDigits[FMT_DIGITS_MAX + 2];
+    char*    pchDigits;
+    uint32_t u32Mag = (i32Val < 0) ? (0 - (uint32_t)i32Val) : (uint32_t)i32Val;
+    uint8_t  ubyIndx;
+
+    if (ubyPlaces > FMT_DIGITS_MAX - 2)
+    {
+        ubyPlaces = FMT_DIGITS_MAX - 2;
+    }
+
+    pchDigits = fmtDigits(pchEnd, u32Mag, ubyPlaces + 1);
+    if (ubyPlaces)
+    {
+        // the whole part one to the left; the point ahead of the fraction
+        for (ubyIndx=0; pchDigits + ubyIndx < pchEnd - ubyPlaces; ubyIndx++)
+        {
+            pchDigits[ubyIndx - 1] = pchDigits[ubyIndx];
+        }
+        pchDigits--;
+        pchEnd[-ubyPlaces - 1] = '.';
+    }
+
+    fmtNum(pchDigits, pchEnd, (i32Val < 0), ubyWidth);
+}
+
+
+// hex, upper case, ubyDigits wide with '0' ahead; no 0x
+void fmtHex(uint32_t u32Val, uint8_t ubyDigits)
+{
+    char  achDigits[8];
+    char* pchEnd = &achDigits[8];
+    char* pchDigits = pchEnd;
+
+    if (ubyDigits > 8)
+    {
+        ubyDigits = 8;
+    }
+
+    do
+    {
+        *--pchDigits = achFmtHex[u32Val & 0x0F];
+        u32Val >>= 4;
+    } while (u32Val || (pchEnd - pchDigits < ubyDigits));
+
+    UART_txStage(eFmtUart, pchDigits, (uint16_t)(pchEnd - pchDigits));
+}
@@ -0,0 +1,39 @@
+/*
+ * fmt.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef FMT_H_
+#define FMT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart.h"
+
+/*
+ * integer only formatting straight into a uart output ring; no sprintf and
+ *  no line buffers. fmtBegin() opens a line on a uart, fmtXxx() add to it
+ *  and fmtEnd() sends it; bWhole as UART_write(). main context only, one
+ *  line open at a time.
+ *
+ *  ubyWidth: field width, 0 => as long as needed; or'ed with
+ *   FMT_LEFT   pad after the value (%-5u)
+ *   FMT_ZERO   pad with '0' (%05u); not with FMT_LEFT
+ */
+#define FMT_LEFT                (0x40)
+#define FMT_ZERO                (0x80)
+#define FMT_WIDTH_MASK          (0x3F)
+
+void     fmtBegin(eUartNum_t eUartNum);
+uint16_t fmtEnd(eUartStream_t eStream, bool bWhole);
+
+void fmtChar(char chVal);
+void fmtStr(const char* pchStr);
+void fmtStrW(const char* pchStr, uint8_t ubyWidth);
+void fmtUint(uint32_t u32Val, uint8_t ubyWidth);
+void fmtInt(int32_t i32Val, uint8_t ubyWidth);
+void fmtFix(int32_t i32Val, uint8_t ubyPlaces, uint8_t ubyWidth);
+void fmtHex(uint32_t u32Val, uint8_t ubyDigits);
+
+#endif /* FMT_H_ */
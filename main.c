@@ -19,6 +19,8 @@
 #include "tmp1075.h"
 #include "fans.h"
 #include "thermalcontrol.h"
+#include "fanhealth.h"
+#include "power.h"
 
 volatile stMainEvts_t gstMainEvts;
 
@@ -42,10 +44,8 @@ stTimerStruct_t stDispBannerAtStrtUpTmr =
 
 uint16_t displayBannerCb(stTimerStruct_t* myTimer)
 {
-    char achStringBuff[100];
     UART_printNewLine();
-    sprintf (achStringBuff, ">> *** %s %s %s ***", FIRMWARE_ID, RELEASE_UPDATE, DATE_COMMIT);
-    UART_putStringSerial(achStringBuff);
+    UART_putStringSerial(">> *** " FIRMWARE_ID " " RELEASE_UPDATE " " DATE_COMMIT " ***");
     UART_printNewLineAndPrompt();
     return 0;
 }
@@ -104,11 +104,18 @@ int main(void)
 // ---------------- UART ------------------------------------------
 // can not test UART_A1 because P4.2 and P4.3 are not bonded out
 //  on the MSP430FR2355 Launchboard.
-    UART_CfgUart(UART_A0,
+    UART_CfgUart(UART_CLI,
                  UART_CLK_SMCLK,
                  UART_BAUD_IN_USE,
                  UART_ENABLE_RXINT,
                  UART_ENABLE_TXINT);
+#if UART_TLM_ENABLED
+    UART_CfgUart(UART_TLM,
+                 UART_CLK_SMCLK,
+                 UART_TLM_BAUD,
+                 UART_ENABLE_RXINT,
+                 UART_ENABLE_TXINT);
+#endif
 
 // ----------------------------------------------------------------
     // normally, want to do this after initCli().
@@ -126,10 +133,18 @@ int main(void)
 
 // ---------------- Thermal Control / PWMs / FANs -----------------
 
+    // supply inrush window shared by heaters and fans
+    initPower();
     initThermalControl();
     // selects PWM timer, configures timer, tachs, interrupts,
     //  RPM calc interval & register and enable RPM timer
     initFans();
+#if CYCLE_BENCH_LONG_ENABLED && (FAN_TACH_MODE != FAN_TACH_MODE_PERIOD)
+    // time base of the long cycle benchmarks; fans.c starts it in period mode
+    TMR_CfgFreeRunTimer();
+#endif
+    // stall/under-speed/wear detection on top of the fan tachs
+    initFanHealth();
 // ----------------------------------------------------------------
 
 
@@ -181,6 +196,9 @@ int main(void)
     {
         __bis_SR_register(LPM0_bits | GIE);     // Enter LPM3 w/ ints enabled
 
+#if CYCLE_BENCH_ENABLED
+        gu32BenchWakeCnt++;
+#endif
         main_events();
     }
 }
@@ -25,7 +25,7 @@ typedef union MAIN_EVENTS
         uint16_t bit3:1;
 
         uint16_t svcUartRx:1;       // bit4
-        uint16_t svcUartTx:1;       // bit5
+        uint16_t svcUartTxRoom:1;   // bit5
         uint16_t svcTestUartTx:1;   // bit6
         uint16_t bit7:1;
 
@@ -35,8 +35,8 @@ typedef union MAIN_EVENTS
         uint16_t bit11:1;
 
         uint16_t svcRtdAdc:1;       // bit12;
-        uint16_t svcHtrTmr:1;       // bit13;
-        uint16_t bit14:1;
+        uint16_t svcSelfTest:1;     // bit13;
+        uint16_t svcFanHealth:1;    // bit14;
         uint16_t bit15:1;
 
     }bits;
@@ -13,6 +13,8 @@
 #include "tmp1075.h"
 #include "rtd.h"
 #include "thermalcontrol.h"
+#include "fanhealth.h"
+#include "selftest.h"
 
 void main_events()
 {
@@ -27,12 +29,12 @@ void main_events()
 
         if(gstMainEvts.bits.svcUartRx == true)
         {
-            UART_svcUartRx();
+            cliSvcCmdLine();
         }
 
-        if(gstMainEvts.bits.svcUartTx == true)
+        if(gstMainEvts.bits.svcUartTxRoom == true)
         {
-            UART_svcUartTx();
+            UART_svcUartTxRoom();
         }
 
         if(gstMainEvts.bits.svcTestUartTx == true)
@@ -63,9 +65,14 @@ void main_events()
             transformRtdAdcToTmp();
         }
 
-        if(gstMainEvts.bits.svcHtrTmr == true)
+        if(gstMainEvts.bits.svcFanHealth == true)
         {
-            disableHtrTmr();
+            fanHealthReport();
+        }
+
+        if(gstMainEvts.bits.svcSelfTest == true)
+        {
+            selfTestReport();
         }
     }
 
@@ -0,0 +1,200 @@
+/*
+ * power.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "config.h"
+#include "timer.h"
+#include "power.h"
+
+/*
+ * supply power budget
+ *  - inrush: loads step up one at a time, PWR_INRUSH_SETTLE_MS apart. a
+ *    load asks pwrInrushRequest() (fans) or pwrAdmit() (heaters) before a
+ *    step and retries later when refused.
+ *  - budget: each load reports its current (gau16PwrLoadMa[]); a heater is
+ *    admitted only when the total leaves room for it under PWR_BUDGET_MA.
+ *    fans report the current of their target duty so a heater can not take
+ *    the room a fan is ramping into.
+ */
+stTimerStruct_t stPwrInrushTmr =
+{
+    .prevTimer        = NULL,
+    .timeoutTickCnt   = PWR_INRUSH_SETTLE_MS,
+    .counter          = 0,
+    .recurrence       = TIMER_SINGLE,
+    .status           = TIMER_DISABLED,
+    .callback         = pwrInrushCb,
+    .nextTimer        = NULL
+};
+
+#if PWR_USE_INA219
+// measured supply current goes stale when not refreshed
+stTimerStruct_t stPwrMeasuredAgeTmr =
+{
+    .prevTimer        = NULL,
+    .timeoutTickCnt   = PWR_MEASURED_MAX_AGE_MS,
+    .counter          = 0,
+    .recurrence       = TIMER_SINGLE,
+    .status           = TIMER_DISABLED,
+    .callback         = pwrMeasuredAgeCb,
+    .nextTimer        = NULL
+};
+
+static uint16_t u16PwrMeasuredMa;
+static bool     bPwrMeasuredValid;
+#endif
+
+uint16_t gau16PwrLoadMa[NUM_PWR_LOADS];
+uint16_t gu16PwrTotalMa;                    // sum of gau16PwrLoadMa[]
+static bool bPwrInrushBusy;
+
+
+void initPower()
+{
+    memset(gau16PwrLoadMa, 0, sizeof(gau16PwrLoadMa));
+    gu16PwrTotalMa = 0;
+    bPwrInrushBusy = false;
+    registerTimer(&stPwrInrushTmr);
+
+#if PWR_USE_INA219
+    bPwrMeasuredValid = false;
+    registerTimer(&stPwrMeasuredAgeTmr);
+#endif
+}
+
+
+// true => caller may step its load up now; the window closes for the others
+bool pwrInrushRequest()
+{
+    if(bPwrInrushBusy)
+    {
+        return false;
+    }
+
+    bPwrInrushBusy = true;
+    enableDisableTimer(&stPwrInrushTmr, TMR_ENABLE);
+
+    return true;
+}
+
+
+// supply has settled from the previous step
+uint16_t pwrInrushCb(stTimerStruct_t* myTimer)
+{
+    bPwrInrushBusy = false;
+    return 0;
+}
+
+
+void pwrSetLoadMa(uint8_t ubyLoad, uint16_t u16LoadMa)
+{
+    gu16PwrTotalMa = gu16PwrTotalMa - gau16PwrLoadMa[ubyLoad] + u16LoadMa;
+    gau16PwrLoadMa[ubyLoad] = u16LoadMa;
+}
+
+
+// current drawn from the supply; the measurement when newer and larger
+uint16_t pwrGetUsedMa()
+{
+#if PWR_USE_INA219
+    if(bPwrMeasuredValid && (u16PwrMeasuredMa > gu16PwrTotalMa))
+    {
+        return u16PwrMeasuredMa;
+    }
+#endif
+    return gu16PwrTotalMa;
+}
+
+
+/*
+ * pwrGetRoomMa(): current a group of loads (ubyLoadCnt loads from
+ *  ubyLoadFirst) may draw in total; budget less what the others draw.
+ */
+uint16_t pwrGetRoomMa(uint8_t ubyLoadFirst, uint8_t ubyLoadCnt)
+{
+    uint16_t u16GroupMa = 0;
+    uint16_t u16OthersMa;
+    uint8_t  ubyLoad;
+
+    for(ubyLoad=ubyLoadFirst; ubyLoad<(ubyLoadFirst + ubyLoadCnt); ubyLoad++)
+    {
+        u16GroupMa += gau16PwrLoadMa[ubyLoad];
+    }
+
+    u16OthersMa = pwrGetUsedMa() - u16GroupMa;
+    if(pwrGetUsedMa() < u16GroupMa)
+    {   // measured below the model
+        u16OthersMa = 0;
+    }
+
+    return (u16OthersMa < PWR_BUDGET_MA) ? (PWR_BUDGET_MA - u16OthersMa) : 0;
+}
+
+
+/*
+ * pwrAdmit(): a load asks to draw u16LoadMa. admitted when the inrush
+ *  window is free and the budget has room; the load is then accounted
+ *  at u16LoadMa and the inrush window closes.
+ */
+bool pwrAdmit(uint8_t ubyLoad, uint16_t u16LoadMa)
+{
+    uint32_t u32NewMa = (uint32_t)pwrGetUsedMa() - gau16PwrLoadMa[ubyLoad] + u16LoadMa;
+
+    if(bPwrInrushBusy || (u32NewMa > PWR_BUDGET_MA))
+    {
+        return false;
+    }
+
+    pwrSetLoadMa(ubyLoad, u16LoadMa);
+    pwrInrushRequest();
+
+    return true;
+}
+
+
+// fan current at a duty; power goes with the cube of the speed
+uint16_t pwrFanMa(uint16_t u16PerMille)
+{
+    uint32_t u32Cube;
+
+    if(u16PerMille == 0)
+    {
+        return 0;
+    }
+
+    // duty^3 in 0.1%
+    u32Cube = ((uint32_t)u16PerMille * u16PerMille) / TMR_PWM_MAX_PER_MILLE;
+    u32Cube = (u32Cube * u16PerMille) / TMR_PWM_MAX_PER_MILLE;
+
+    return PWR_FAN_MIN_MA + (uint16_t)(((PWR_FAN_MAX_MA - PWR_FAN_MIN_MA) * u32Cube) / TMR_PWM_MAX_PER_MILLE);
+}
+
+
+#if PWR_USE_INA219
+/*
+ * pwrSetMeasuredMa(): supply current read from the INA219; to be called
+ *  by the reader at least every PWR_MEASURED_MAX_AGE_MS.
+ */
+void pwrSetMeasuredMa(uint16_t u16MeasuredMa)
+{
+    u16PwrMeasuredMa  = u16MeasuredMa;
+    bPwrMeasuredValid = true;
+
+    // restart the age timer
+    enableDisableTimer(&stPwrMeasuredAgeTmr, TMR_DISABLE);
+    enableDisableTimer(&stPwrMeasuredAgeTmr, TMR_ENABLE);
+}
+
+
+uint16_t pwrMeasuredAgeCb(stTimerStruct_t* myTimer)
+{
+    bPwrMeasuredValid = false;
+    return 0;
+}
+#endif
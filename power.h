@@ -0,0 +1,38 @@
+/*
+ * power.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "timer_utilities.h"
+#include "thermalcontrol.h"
+
+// loads known to the power budget
+#define PWR_LOAD_HTR0           (0)
+#define PWR_LOAD_FAN0           (PWR_LOAD_HTR0 + NUM_HEATERS)
+#define NUM_PWR_LOADS           (PWR_LOAD_FAN0 + NUM_FANS)
+
+extern stTimerStruct_t stPwrInrushTmr;
+extern uint16_t gau16PwrLoadMa[NUM_PWR_LOADS];
+extern uint16_t gu16PwrTotalMa;
+
+void initPower();
+bool pwrInrushRequest();
+bool pwrAdmit(uint8_t ubyLoad, uint16_t u16LoadMa);
+void pwrSetLoadMa(uint8_t ubyLoad, uint16_t u16LoadMa);
+uint16_t pwrFanMa(uint16_t u16PerMille);
+uint16_t pwrGetUsedMa();
+uint16_t pwrGetRoomMa(uint8_t ubyLoadFirst, uint8_t ubyLoadCnt);
+uint16_t pwrInrushCb(stTimerStruct_t* myTimer);
+#if PWR_USE_INA219
+void pwrSetMeasuredMa(uint16_t u16MeasuredMa);
+uint16_t pwrMeasuredAgeCb(stTimerStruct_t* myTimer);
+#endif
+
+#endif /* POWER_H_ */
@@ -9,7 +9,10 @@
 #include "adc.h"
 #include "main.h"
 #include "config.h"
+#include "timer.h"
 #include "thermalcontrol.h"
+#include "selftest.h"
+
 
 float gfRtdTempAvg = -1;    // since this is a float, float '0' not eq to Int '0'
 
@@ -111,7 +114,11 @@ void transformRtdAdcToTmp()
     float fXformVal;
 
     gstMainEvts.bits.svcRtdAdc = false;
-    if(pgstAdcChActive->ubyChNum == ADC_ON_CHIP_TMP_SNSR)
+    if(selfTestOwnsSnsr(SNSR_ADC_FIRST + gubyAdcChActiveIndx))
+    {
+        // the self test plays into this sensor; sample dropped
+    }
+    else if(pgstAdcChActive->ubyChNum == ADC_ON_CHIP_TMP_SNSR)
     {
         transformOnChipAdcToTmp();
     }
@@ -125,28 +132,22 @@ void transformRtdAdcToTmp()
         fRtdOhms    = fRtdVolt/fRtdCurrent;
         fXformVal   = RTD_ONE_OVER_ALPHA * ((fRtdOhms/RTD_REF_RESISTOR_OHMS) - 1);
 
-        // do not update temperature data if pwm is under test
-        // be careful here. if the first sensor is the internal sensor, want to skip test
-        // => valid gubyPwmInTest values will be [1 - NUM_FANS]
-        if(!(gbEnableTempCycleTest && (pgstAdcChActive->ubyFanIndex ==  gubyPwmInTest-1)))
+        /*
+         * if transformed temperature data is NOT within defined range or damaged
+         *  unrealistic temperature value will be computed.
+         * mitigate this by replacing data with internal temperature reading.
+         */
+        if((fXformVal > gbyTmpRangeMax) || (fXformVal < gbyTmpRangeMin))
+        {
+            pgstAdcChActive->fAdcXformVal   = stAdcChA12.fAdcXformVal;
+//                    pgstAdcChActive->fAdcXformVal   = pgstAdcChActive->ubyPwmNum;   // for debug push pwm #
+            pgstAdcChActive->bSelfTemp                         = false; // indicate that this is Int Temp
+        }
+        else
         {
-            /*
-             * if transformed temperature data is NOT within defined range or damaged
-             *  unrealistic temperature value will be computed.
-             * mitigate this by replacing data with internal temperature reading.
-             */
-            if((fXformVal > gbyTmpRangeMax) || (fXformVal < gbyTmpRangeMin))
-            {
-                pgstAdcChActive->fAdcXformVal   = stAdcChA12.fAdcXformVal;
-    //                    pgstAdcChActive->fAdcXformVal   = pgstAdcChActive->ubyPwmNum;   // for debug push pwm #
-                pgstAdcChActive->bSelfTemp                         = false; // indicate that this is Int Temp
-            }
-            else
-            {
-                pgstAdcChActive->fAdcXformVal   = fXformVal;
-    //                    pgstAdcChActive->fAdcXformVal   = pgstAdcChActive->ubyChNum;    // for debug push ch #
-                pgstAdcChActive->bSelfTemp                         = true;  // indicate that this is measured temp
-            }
+            pgstAdcChActive->fAdcXformVal   = fXformVal;
+//                    pgstAdcChActive->fAdcXformVal   = pgstAdcChActive->ubyChNum;    // for debug push ch #
+            pgstAdcChActive->bSelfTemp                         = true;  // indicate that this is measured temp
         }
     }
 
@@ -164,8 +165,16 @@ void transformRtdAdcToTmp()
         ubyTrackNumSnsrs = 0;   // reset track indicator
     }
 
+    CYCLE_BENCH_START(BENCH_CTRL_PATH);
     if(pgstAdcChActive->ubyChNum != ADC_ON_CHIP_TMP_SNSR)
     {
-        processThermalControl();
+        processThermalControl(SNSR_ADC_FIRST + gubyAdcChActiveIndx);
     }
+    else
+    {
+        // internal sensor; only re-evaluate the fans that have it mapped
+        updateFanDemand(SNSR_ADC_FIRST + gubyAdcChActiveIndx);
+    }
+    CYCLE_BENCH_STOP(BENCH_CTRL_PATH);
+
 }
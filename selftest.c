@@ -0,0 +1,366 @@
+/*
+ * selftest.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <string.h>
+#include "config.h"
+#include "main.h"
+#include "timer.h"
+#include "uart.h"
+#include "fmt.h"
+#include "adc.h"
+#include "tmp1075.h"
+#include "fans.h"
+#include "fanhealth.h"
+#include "thermalcontrol.h"
+#include "selftest.h"
+
+/*
+ * thermal control self test; replaces the temperature cycling test
+ *  (set tempcycle).
+ *  - a profile is a list of segments (step, ramp, noise, dropout) played
+ *    into a set of sensors every playback step, stSelfTestTmr
+ *  - the sensors played into are not updated by their reads (rtd.c,
+ *    tmp1075.c) until the test ends
+ *  - each step re-evaluates the fans mapped to the sensors; a zone moves
+ *    one zone per evaluation, so a segment needs as many steps as zones
+ *    it crosses
+ *  - at each segment end the zone, target duty and rpm of the checked
+ *    fans are recorded to gastSelfTestRec[] and checked against the
+ *    segment bounds
+ * the playback rate is not tied to the sensor reads; a profile takes
+ *  seconds. the host simulator runs the same profiles (sim/, -p).
+ */
+
+#define SELFTEST_SNSR_RTDS      (SNSR_MASK(SNSR_RTD_CH5_CPU) | SNSR_MASK(SNSR_RTD_CH4_GPU))
+#define SELFTEST_NOISE_SEED     (0xACE1)
+#define SELFTEST_RPM_SHIFT      (5)     // stSelfTestRec_t.ubyRpmDiv32
+
+/*
+ * built in profiles; the expected zones and duties are for the default
+ *  zone table, zone pwms and hysteresis (set defaults).
+ */
+static const stSelfTestSeg_t astSelfTestSweep[] =
+{
+    // type          sensors             from  to noise steps  checks                                 tz     duty %
+    {SELFTEST_RAMP,  SELFTEST_SNSR_RTDS,    0, 70,  0,  140, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY,    7, 7, 100, 100},
+    {SELFTEST_RAMP,  SELFTEST_SNSR_RTDS,   70,  0,  0,  140, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY,    0, 0,  20,  20}
+};
+
+static const stSelfTestSeg_t astSelfTestSteps[] =
+{
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS,    0, 20,  0,   20, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY,    1, 1,  30,  30},
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS,    0, 28,  0,   20, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY,    2, 2,  35,  35},
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS,    0, 33,  0,   20, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY,    3, 3,  45,  45},
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS,    0, 38,  0,   20, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY,    4, 4,  50,  50},
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS,    0, 43,  0,   20, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY,    5, 5,  55,  55},
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS,    0, 48,  0,   20, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY,    6, 6,  60,  60},
+    // held past the fan spin up grace; fans must reach the expected rpm
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS,    0, 60,  0,  250, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY |
+                                                             SELFTEST_CHK_RPM,                       7, 7, 100, 100},
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS,    0, 20,  0,   20, SELFTEST_CHK_TZ | SELFTEST_CHK_DUTY,    1, 1,  30,  30}
+};
+
+static const stSelfTestSeg_t astSelfTestSnsr[] =
+{
+    // internal sensor at 20C; what a lost RTD is replaced with
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS |
+                     SNSR_MASK(SNSR_ON_CHIP_CH12),  0, 20,  0,   10, 0,                              0, 0,   0,   0},
+    {SELFTEST_STEP,  SELFTEST_SNSR_RTDS,    0, 33,  0,   20, SELFTEST_CHK_TZ,                        3, 3,   0,   0},
+    // noise within the hysteresis does not move the zone
+    {SELFTEST_NOISE, SELFTEST_SNSR_RTDS,    0, 33,  3,  100, SELFTEST_CHK_TZ,                        3, 3,   0,   0},
+    {SELFTEST_DROPOUT, SNSR_MASK(SNSR_RTD_CH5_CPU), 0, 0, 0, 20, SELFTEST_CHK_TZ,                     1, 1,   0,   0},
+    {SELFTEST_STEP,  SNSR_MASK(SNSR_RTD_CH5_CPU),   0, 33, 0, 20, SELFTEST_CHK_TZ,                    3, 3,   0,   0}
+};
+
+#define SELFTEST_NUM_SEGS(seg)  (sizeof(seg) / sizeof(stSelfTestSeg_t))
+
+const stSelfTestProfile_t gastSelfTestProfile[] =
+{
+    // name      segments           # of segments                         step ms  record every
+    {"sweep",    astSelfTestSweep,  SELFTEST_NUM_SEGS(astSelfTestSweep),  50,      20},
+    {"steps",    astSelfTestSteps,  SELFTEST_NUM_SEGS(astSelfTestSteps),  20,      0},
+    {"sensor",   astSelfTestSnsr,   SELFTEST_NUM_SEGS(astSelfTestSnsr),   20,      0}
+};
+
+const uint8_t gubyNumSelfTestProfiles = sizeof(gastSelfTestProfile) / sizeof(stSelfTestProfile_t);
+
+const char* const gapchSelfTestStateName[NUM_SELFTEST_STATES] =
+{
+    "idle", "running", "PASS", "FAIL", "aborted"
+};
+
+stTimerStruct_t stSelfTestTmr =
+{
+    .prevTimer      = NULL,
+    .timeoutTickCnt = 50,
+    .counter        = 0,
+    .recurrence     = TIMER_RECURRING,
+    .status         = TIMER_DISABLED,
+    .callback       = selfTestCb,
+    .nextTimer      = NULL
+};
+
+stSelfTestStatus_t gstSelfTest = {.ubyState = SELFTEST_IDLE, .ubyProfile = SELFTEST_NO_PROFILE};
+stSelfTestRec_t    gastSelfTestRec[SELFTEST_REC_MAX];
+static uint16_t    u16SelfTestLfsr;
+
+
+// uniform in [-ubyNoiseC, ubyNoiseC] at 0.1C; 16 bit galois lfsr
+static float selfTestNoise(uint8_t ubyNoiseC)
+{
+    u16SelfTestLfsr = (u16SelfTestLfsr >> 1) ^ ((u16SelfTestLfsr & 1) ? 0xB400 : 0);
+
+    return ((int16_t)(u16SelfTestLfsr % (20 * ubyNoiseC + 1)) - 10 * ubyNoiseC) / 10.0f;
+}
+
+
+// what a sensor read would have stored
+static void selfTestSetSnsr(uint8_t ubySnsrIndx, float fTemp, bool bValid)
+{
+    stAdcSnsrData_t* pstAdcCh;
+
+    if(ubySnsrIndx < SNSR_TMP1075_FIRST)
+    {
+        pstAdcCh = gastAdcChServiceTbl[ubySnsrIndx - SNSR_ADC_FIRST];
+        // the internal sensor is what a lost sensor is replaced with
+        if(bValid || (pstAdcCh->ubyChNum != ADC_ON_CHIP_TMP_SNSR))
+        {
+            pstAdcCh->fAdcXformVal = fTemp;
+            pstAdcCh->bSelfTemp    = bValid;
+        }
+    }
+    else if(pastTmp1075I2cMsgTable[ubySnsrIndx - SNSR_TMP1075_FIRST] != NULL)
+    {
+        pastTmp1075I2cMsgTable[ubySnsrIndx - SNSR_TMP1075_FIRST]->fI2cRead1stValueSave = fTemp;
+    }
+}
+
+
+static void selfTestPlay(const stSelfTestSeg_t* pstSeg)
+{
+    uint8_t ubySnsrIndx;
+    bool    bValid = true;
+    float   fTemp;
+
+    switch(pstSeg->ubyType)
+    {
+    case SELFTEST_RAMP:
+        fTemp = pstSeg->byFromC +
+                (float)(pstSeg->byToC - pstSeg->byFromC) * gstSelfTest.u16Step / pstSeg->u16Steps;
+        break;
+
+    case SELFTEST_NOISE:
+        fTemp = pstSeg->byToC + selfTestNoise(pstSeg->ubyNoiseC);
+        break;
+
+    case SELFTEST_DROPOUT:
+        // as an out of range RTD read (rtd.c)
+        fTemp  = stAdcChA12.fAdcXformVal;
+        bValid = false;
+        break;
+
+    default:
+    case SELFTEST_STEP:
+        fTemp = pstSeg->byToC;
+        break;
+    }
+
+    // all sensors first; a fan mapped to several sees them at once
+    for(ubySnsrIndx=0; ubySnsrIndx<NUM_TEMP_SNSRS; ubySnsrIndx++)
+    {
+        if(pstSeg->ubySnsrMask & SNSR_MASK(ubySnsrIndx))
+        {
+            selfTestSetSnsr(ubySnsrIndx, fTemp, bValid);
+        }
+    }
+
+    for(ubySnsrIndx=0; ubySnsrIndx<NUM_TEMP_SNSRS; ubySnsrIndx++)
+    {
+        if(pstSeg->ubySnsrMask & SNSR_MASK(ubySnsrIndx))
+        {
+            updateFanDemand(ubySnsrIndx);
+        }
+    }
+}
+
+
+// records (and checks at the segment end) the fans mapped to the segment sensors
+static void selfTestRecord(const stSelfTestSeg_t* pstSeg, bool bCheck)
+{
+    stSelfTestRec_t* pstRec;
+    uint8_t  ubyFanIndx;
+    uint8_t  ubyTz;
+    uint8_t  ubyDutyPct;
+    uint16_t u16Rpm;
+    bool     bFail;
+
+    for(ubyFanIndx=0; ubyFanIndx<NUM_FANS; ubyFanIndx++)
+    {
+        if(!(astFanSnsrMap[ubyFanIndx].ubySnsrMask & pstSeg->ubySnsrMask))
+        {
+            continue;
+        }
+
+        ubyTz      = gubyCurrentTz[ubyFanIndx];
+        ubyDutyPct = (gastFanPwm[ubyFanIndx].u16TargetPm + 5) / 10;
+        u16Rpm     = stFanTach[ubyFanIndx].u16Rpm;
+        bFail      = false;
+
+        if(bCheck)
+        {
+            if((pstSeg->ubyChk & SELFTEST_CHK_TZ) &&
+               ((ubyTz < pstSeg->ubyTzMin) || (ubyTz > pstSeg->ubyTzMax)))
+            {
+                bFail = true;
+            }
+            if((pstSeg->ubyChk & SELFTEST_CHK_DUTY) &&
+               ((ubyDutyPct < pstSeg->ubyDutyMinPct) || (ubyDutyPct > pstSeg->ubyDutyMaxPct)))
+            {
+                bFail = true;
+            }
+            if((pstSeg->ubyChk & SELFTEST_CHK_RPM) &&
+               (u16Rpm < (uint32_t)fanHealthExpectedRpm(ubyFanIndx, gastFanPwm[ubyFanIndx].u16TargetPm) *
+                         FAN_UNDERSPEED_PM / 1000))
+            {
+                bFail = true;
+            }
+        }
+
+        if(bFail && (gstSelfTest.ubyFailCnt < 0xFF))
+        {
+            gstSelfTest.ubyFailCnt++;
+        }
+
+        if(gstSelfTest.ubyRecCnt >= SELFTEST_REC_MAX)
+        {
+            if(gstSelfTest.ubyRecLost < 0xFF)
+            {
+                gstSelfTest.ubyRecLost++;
+            }
+            continue;
+        }
+
+        pstRec = &gastSelfTestRec[gstSelfTest.ubyRecCnt++];
+        pstRec->ubySeg      = gstSelfTest.ubySeg | (bFail ? SELFTEST_REC_FAIL : 0);
+        pstRec->ubyFanTz    = (ubyFanIndx << 4) | ubyTz;
+        pstRec->ubyDutyPct  = ubyDutyPct;
+        pstRec->ubyRpmDiv32 = ((u16Rpm >> SELFTEST_RPM_SHIFT) > 0xFF) ? 0xFF : (u16Rpm >> SELFTEST_RPM_SHIFT);
+    }
+}
+
+
+/*
+ * selfTestStart(): plays profile ubyProfile every u16StepMs;
+ *  0 => the profile rate. a running test is restarted.
+ *  fails when thermal control is not running yet (no sensor read so far).
+ */
+bool selfTestStart(uint8_t ubyProfile, uint16_t u16StepMs)
+{
+    const stSelfTestProfile_t* pstProf;
+    uint8_t ubySegIndx;
+
+    if((ubyProfile >= gubyNumSelfTestProfiles) || !bIsThermalControlled)
+    {
+        return false;
+    }
+
+    pstProf = &gastSelfTestProfile[ubyProfile];
+
+    memset(&gstSelfTest, 0, sizeof(gstSelfTest));
+    gstSelfTest.ubyProfile = ubyProfile;
+    gstSelfTest.u16StepMs  = u16StepMs ? u16StepMs : pstProf->u16StepMs;
+    for(ubySegIndx=0; ubySegIndx<pstProf->ubyNumSegs; ubySegIndx++)
+    {
+        gstSelfTest.ubySnsrMask |= pstProf->pastSeg[ubySegIndx].ubySnsrMask;
+    }
+    u16SelfTestLfsr = SELFTEST_NOISE_SEED;
+
+    registerTimer(&stSelfTestTmr);
+    enableDisableTimer(&stSelfTestTmr, TMR_DISABLE);
+    stSelfTestTmr.timeoutTickCnt = gstSelfTest.u16StepMs;
+    stSelfTestTmr.recurrence     = TIMER_RECURRING;
+    gstSelfTest.ubyState         = SELFTEST_RUNNING;
+    enableDisableTimer(&stSelfTestTmr, TMR_ENABLE);
+
+    return true;
+}
+
+
+// the sensor reads take over again from their next sample
+void selfTestStop()
+{
+    if(gstSelfTest.ubyState == SELFTEST_RUNNING)
+    {
+        enableDisableTimer(&stSelfTestTmr, TMR_DISABLE);
+        gstSelfTest.ubyState    = SELFTEST_ABORTED;
+        gstSelfTest.ubySnsrMask = 0;
+    }
+}
+
+
+// a sensor played into by the self test; its reads are dropped
+bool selfTestOwnsSnsr(uint8_t ubySnsrIndx)
+{
+    return (gstSelfTest.ubySnsrMask & SNSR_MASK(ubySnsrIndx)) != 0;
+}
+
+
+uint16_t selfTestCb(stTimerStruct_t* myTimer)
+{
+    const stSelfTestProfile_t* pstProf;
+    const stSelfTestSeg_t*     pstSeg;
+
+    if(gstSelfTest.ubyState != SELFTEST_RUNNING)
+    {
+        myTimer->recurrence = TIMER_SINGLE;
+        return 0;
+    }
+
+    pstProf = &gastSelfTestProfile[gstSelfTest.ubyProfile];
+    pstSeg  = &pstProf->pastSeg[gstSelfTest.ubySeg];
+
+    gstSelfTest.u16Step++;
+    selfTestPlay(pstSeg);
+
+    if(gstSelfTest.u16Step >= pstSeg->u16Steps)
+    {
+        selfTestRecord(pstSeg, true);
+        gstSelfTest.u16Step = 0;
+
+        if(++gstSelfTest.ubySeg >= pstProf->ubyNumSegs)
+        {
+            gstSelfTest.ubyState    = gstSelfTest.ubyFailCnt ? SELFTEST_FAIL : SELFTEST_PASS;
+            gstSelfTest.ubySnsrMask = 0;
+            // single shot => disabled once this call back returns
+            myTimer->recurrence     = TIMER_SINGLE;
+            gstMainEvts.bits.svcSelfTest = true;
+        }
+    }
+    else if(pstProf->ubyRecEvery && ((gstSelfTest.u16Step % pstProf->ubyRecEvery) == 0))
+    {
+        selfTestRecord(pstSeg, false);
+    }
+
+    return 0;
+}
+
+
+void selfTestReport()
+{
+    gstMainEvts.bits.svcSelfTest = false;
+
+    fmtBegin(UART_CLI);
+    fmtStr("\r\nSelfTest ");
+    fmtStr(gastSelfTestProfile[gstSelfTest.ubyProfile].pchName);
+    fmtChar(' ');
+    fmtStr(gapchSelfTestStateName[gstSelfTest.ubyState]);
+    fmtStr(" Fails=");
+    fmtUint(gstSelfTest.ubyFailCnt, 0);
+    fmtStr(" Recs=");
+    fmtUint(gstSelfTest.ubyRecCnt, 0);
+    fmtEnd(UART_STREAM_CLI, false);
+    UART_printNewLineAndPrompt();
+}
@@ -0,0 +1,107 @@
+/*
+ * selftest.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef SELFTEST_H_
+#define SELFTEST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "timer_utilities.h"
+#include "thermalcontrol.h"
+
+// segment checks at the segment end; SELFTEST_CHK_xxx bits
+#define SELFTEST_CHK_TZ         (0x01)  // zone in [ubyTzMin, ubyTzMax]
+#define SELFTEST_CHK_DUTY       (0x02)  // target duty in [ubyDutyMinPct, ubyDutyMaxPct]
+#define SELFTEST_CHK_RPM        (0x04)  // rpm FAN_UNDERSPEED_PM of the expected rpm at least
+
+#define SELFTEST_REC_FAIL       (0x80)  // stSelfTestRec_t.ubySeg; a check failed
+#define SELFTEST_NO_PROFILE     (0xFF)
+
+typedef enum SELFTEST_SEG_TYPE
+{
+    SELFTEST_STEP,          // byToC for the whole segment
+    SELFTEST_RAMP,          // byFromC to byToC over the segment
+    SELFTEST_NOISE,         // byToC +/- ubyNoiseC, uniform
+    SELFTEST_DROPOUT,       // sensor lost; replaced as an out of range RTD
+    NUM_SELFTEST_SEG_TYPES
+}eSelfTestSegType_t;
+
+typedef enum SELFTEST_STATE
+{
+    SELFTEST_IDLE,
+    SELFTEST_RUNNING,
+    SELFTEST_PASS,
+    SELFTEST_FAIL,
+    SELFTEST_ABORTED,
+    NUM_SELFTEST_STATES
+}eSelfTestState_t;
+
+/*
+ * a profile segment; plays into the sensors of ubySnsrMask (SNSR_MASK(n))
+ *  for u16Steps playback steps. the checks apply to the fans that have
+ *  one of these sensors mapped (astFanSnsrMap[]).
+ */
+typedef struct SELFTEST_SEG
+{
+    uint8_t  ubyType;           // eSelfTestSegType_t
+    uint8_t  ubySnsrMask;
+    int8_t   byFromC;
+    int8_t   byToC;
+    uint8_t  ubyNoiseC;
+    uint16_t u16Steps;
+    uint8_t  ubyChk;            // SELFTEST_CHK_xxx
+    uint8_t  ubyTzMin;
+    uint8_t  ubyTzMax;
+    uint8_t  ubyDutyMinPct;
+    uint8_t  ubyDutyMaxPct;
+}stSelfTestSeg_t;
+
+typedef struct SELFTEST_PROFILE
+{
+    const char*             pchName;
+    const stSelfTestSeg_t*  pastSeg;
+    uint8_t                 ubyNumSegs;
+    uint16_t                u16StepMs;      // default playback rate
+    uint8_t                 ubyRecEvery;    // record every n steps too; 0 => segment ends only
+}stSelfTestProfile_t;
+
+// 4 bytes per fan and record point
+typedef struct SELFTEST_REC
+{
+    uint8_t  ubySeg;            // segment; SELFTEST_REC_FAIL if a check failed
+    uint8_t  ubyFanTz;          // fan << 4 | zone
+    uint8_t  ubyDutyPct;        // target duty
+    uint8_t  ubyRpmDiv32;       // saturated
+}stSelfTestRec_t;
+
+typedef struct SELFTEST_STATUS
+{
+    uint8_t  ubyState;          // eSelfTestState_t
+    uint8_t  ubyProfile;
+    uint8_t  ubySeg;
+    uint16_t u16Step;           // step in the segment
+    uint16_t u16StepMs;
+    uint8_t  ubySnsrMask;       // sensors played into; not updated by the sensor reads
+    uint8_t  ubyRecCnt;
+    uint8_t  ubyRecLost;        // records not kept; buffer full
+    uint8_t  ubyFailCnt;
+}stSelfTestStatus_t;
+
+extern const stSelfTestProfile_t gastSelfTestProfile[];
+extern const uint8_t             gubyNumSelfTestProfiles;
+extern const char* const         gapchSelfTestStateName[NUM_SELFTEST_STATES];
+extern stSelfTestStatus_t        gstSelfTest;
+extern stSelfTestRec_t           gastSelfTestRec[SELFTEST_REC_MAX];
+extern stTimerStruct_t           stSelfTestTmr;
+
+bool selfTestStart(uint8_t ubyProfile, uint16_t u16StepMs);
+void selfTestStop();
+bool selfTestOwnsSnsr(uint8_t ubySnsrIndx);
+uint16_t selfTestCb(stTimerStruct_t* myTimer);
+void selfTestReport();
+
+#endif /* SELFTEST_H_ */
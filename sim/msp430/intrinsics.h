@@ -0,0 +1 @@
+#include "msp430.h"
@@ -0,0 +1,214 @@
+/*
+ * msp430.h (host simulator)
+ *
+ *  stands in for the TI device header when the firmware sources are built
+ *  for the host (see sim/Makefile). only what thermal control, fans, adc,
+ *  rtd and the timers use is here. bit values follow msp430fr2355.h.
+ *
+ *  registers are plain memory (sim_hw.c); timer registers are laid out
+ *  like the device so the CCRx pointer arithmetic of timer.c holds.
+ *  interrupt vector registers (PxIV, TBxIV, ADCIV) are read through
+ *  sim_hw.c so a read clears the flag it reports, as on the device.
+ */
+
+#ifndef SIM_MSP430_H_
+#define SIM_MSP430_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ---------------------------------------------------------------- intrinsics
+#define __even_in_range(a,b)            (a)
+#define __bic_SR_register_on_exit(x)
+#define __bis_SR_register(x)
+#define __no_operation()
+#define _no_operation()
+#define __disable_interrupt()
+#define __enable_interrupt()
+#define _disable_interrupts()
+#define _enable_interrupts()
+#define __get_SR_register()             (0)
+#define __get_interrupt_state()         (0)
+#define __set_interrupt_state(x)        ((void)(x))
+#define __delay_cycles(x)
+// ISRs are plain functions on the host; sim_hw.c calls them
+#define interrupt(x)                    used
+
+#define LPM0_bits                       (0x0010)
+#define GIE                             (0x0008)
+
+// ---------------------------------------------------------------- bits
+#define BIT0                            (0x0001)
+#define BIT1                            (0x0002)
+#define BIT2                            (0x0004)
+#define BIT3                            (0x0008)
+#define BIT4                            (0x0010)
+#define BIT5                            (0x0020)
+#define BIT6                            (0x0040)
+#define BIT7                            (0x0080)
+
+// ---------------------------------------------------------------- ports
+extern volatile uint8_t gaubySimPort[6][8];     // DIR, OUT, IN, SEL0, SEL1, REN, IES, IE
+extern volatile uint8_t gaubySimPortIfg[6];
+
+#define SIM_PORT_REG(p, r)              (gaubySimPort[(p) - 1][r])
+#define P1DIR                           SIM_PORT_REG(1, 0)
+#define P1OUT                           SIM_PORT_REG(1, 1)
+#define P1SEL0                          SIM_PORT_REG(1, 3)
+#define P1SEL1                          SIM_PORT_REG(1, 4)
+#define P2DIR                           SIM_PORT_REG(2, 0)
+#define P2OUT                           SIM_PORT_REG(2, 1)
+#define P2SEL0                          SIM_PORT_REG(2, 3)
+#define P2SEL1                          SIM_PORT_REG(2, 4)
+#define P3DIR                           SIM_PORT_REG(3, 0)
+#define P3OUT                           SIM_PORT_REG(3, 1)
+#define P3SEL0                          SIM_PORT_REG(3, 3)
+#define P3SEL1                          SIM_PORT_REG(3, 4)
+#define P4DIR                           SIM_PORT_REG(4, 0)
+#define P4OUT                           SIM_PORT_REG(4, 1)
+#define P4IN                            SIM_PORT_REG(4, 2)
+#define P4SEL0                          SIM_PORT_REG(4, 3)
+#define P4SEL1                          SIM_PORT_REG(4, 4)
+#define P4REN                           SIM_PORT_REG(4, 5)
+#define P4IES                           SIM_PORT_REG(4, 6)
+#define P4IE                            SIM_PORT_REG(4, 7)
+#define P4IFG                           (gaubySimPortIfg[3])
+#define P5DIR                           SIM_PORT_REG(5, 0)
+#define P5SEL0                          SIM_PORT_REG(5, 3)
+#define P5SEL1                          SIM_PORT_REG(5, 4)
+#define P6DIR                           SIM_PORT_REG(6, 0)
+#define P6SEL0                          SIM_PORT_REG(6, 3)
+#define P6SEL1                          SIM_PORT_REG(6, 4)
+
+uint16_t simReadP4Iv(void);
+#define P4IV                            (simReadP4Iv())
+#define P4IV__NONE                      (0x0000)
+
+// ---------------------------------------------------------------- timer_b
+// TBxCTL, TBxCCTL0-6, TBxR, TBxCCR0-6, TBxEX0, ..., TBxIV; as the device
+#define SIM_TB_WORDS                    (24)
+extern volatile uint16_t gau16SimTb[4][SIM_TB_WORDS];
+
+#define SIM_TB_CTL(t)                   (gau16SimTb[t][0])
+#define SIM_TB_CCTL(t, n)               (gau16SimTb[t][1 + (n)])
+#define SIM_TB_R(t)                     (gau16SimTb[t][8])
+#define SIM_TB_CCR(t, n)                (gau16SimTb[t][9 + (n)])
+#define SIM_TB_EX0(t)                   (gau16SimTb[t][16])
+
+#define TB0CTL                          SIM_TB_CTL(0)
+#define TB0CCTL0                        SIM_TB_CCTL(0, 0)
+#define TB0R                            SIM_TB_R(0)
+#define TB0CCR0                         SIM_TB_CCR(0, 0)
+#define TB1CTL                          SIM_TB_CTL(1)
+#define TB1CCTL0                        SIM_TB_CCTL(1, 0)
+#define TB1R                            SIM_TB_R(1)
+#define TB1CCR0                         SIM_TB_CCR(1, 0)
+#define TB1EX0                          SIM_TB_EX0(1)
+#define TB2CTL                          SIM_TB_CTL(2)
+#define TB2CCTL0                        SIM_TB_CCTL(2, 0)
+#define TB2R                            SIM_TB_R(2)
+#define TB2CCR0                         SIM_TB_CCR(2, 0)
+#define TB3CTL                          SIM_TB_CTL(3)
+#define TB3CCTL0                        SIM_TB_CCTL(3, 0)
+#define TB3R                            SIM_TB_R(3)
+#define TB3CCR0                         SIM_TB_CCR(3, 0)
+
+uint16_t simReadTbIv(uint8_t ubyTmr);
+#define TB0IV                           (simReadTbIv(0))
+#define TB1IV                           (simReadTbIv(1))
+#define TB2IV                           (simReadTbIv(2))
+#define TB3IV                           (simReadTbIv(3))
+#define TB0IV_NONE                      (0x0000)
+#define TB0IV_TBCCR1                    (0x0002)
+#define TB0IV_TBCCR2                    (0x0004)
+#define TB0IV_TBIFG                     (0x000E)
+#define TB1IV_TBIFG                     (0x000E)
+
+#define TBIFG                           (0x0001)
+#define TBIE                            (0x0002)
+#define TBCLR                           (0x0004)
+#define MC                              (0x0030)
+#define MC__STOP                        (0x0000)
+#define MC__UP                          (0x0010)
+#define MC__CONTINUOUS                  (0x0020)
+#define MC__UPDOWN                      (0x0030)
+#define ID                              (0x00C0)
+#define ID__1                           (0x0000)
+#define ID__8                           (0x00C0)
+#define TBSSEL                          (0x0300)
+#define TBSSEL_0                        (0x0000)
+#define TBSSEL__SMCLK                   (0x0200)
+#define CNTL                            (0x1800)
+#define CNTL__16                        (0x0000)
+#define TBCLGRP                         (0x6000)
+#define TBCLGRP_1                       (0x2000)
+#define TBCLGRP_2                       (0x4000)
+#define TBIDEX__8                       (0x0007)
+#define CCIE                            (0x0010)
+#define OUTMOD_7                        (0x00E0)
+#define CLLD                            (0x0600)
+#define CLLD_1                          (0x0200)
+
+// ---------------------------------------------------------------- adc
+extern volatile uint16_t gau16SimAdc[8];
+
+#define ADCCTL0                         (gau16SimAdc[0])
+#define ADCCTL1                         (gau16SimAdc[1])
+#define ADCCTL2                         (gau16SimAdc[2])
+#define ADCMCTL0                        (gau16SimAdc[3])
+#define ADCMEM0                         (gau16SimAdc[4])
+#define ADCIE                           (gau16SimAdc[5])
+#define ADCIFG                          (gau16SimAdc[6])
+
+uint16_t simReadAdcIv(void);
+#define ADCIV                           (simReadAdcIv())
+#define ADCIV_NONE                      (0x0000)
+#define ADCIV_ADCOVIFG                  (0x0002)
+#define ADCIV_ADCTOVIFG                 (0x0004)
+#define ADCIV_ADCHIIFG                  (0x0006)
+#define ADCIV_ADCLOIFG                  (0x0008)
+#define ADCIV_ADCINIFG                  (0x000A)
+#define ADCIV_ADCIFG                    (0x000C)
+
+#define ADCSC                           (0x0001)
+#define ADCENC                          (0x0002)
+#define ADCON                           (0x0010)
+#define ADCSHT                          (0x0F00)
+#define ADCSHT_12                       (0x0C00)
+#define ADCBUSY                         (0x0001)
+#define ADCCONSEQ                       (0x0006)
+#define ADCSSEL                         (0x0018)
+#define ADCDIV                          (0x00E0)
+#define ADCSHP                          (0x0200)
+#define ADCSHS                          (0x0C00)
+#define ADCRES                          (0x0030)
+#define ADCRES_2                        (0x0020)
+#define ADCPDIV                         (0x0300)
+#define ADCPDIV_0                       (0x0000)
+#define ADCINCH                         (0x000F)
+#define ADCSREF                         (0x0070)
+#define ADCSREF_0                       (0x0000)
+#define ADCSREF_1                       (0x0010)
+#define ADCIE0                          (0x0001)
+#define ADCIFG0                         (0x0001)
+
+// on-chip temperature sensor calibration (device descriptors, TLV)
+extern uint16_t gu16SimTlvAdc30C;
+extern uint16_t gu16SimTlvAdc105C;
+#define ADC_30C_AT_1_5V_REF             (gu16SimTlvAdc30C)
+#define ADC_105C_AT_1_5V_REF            (gu16SimTlvAdc105C)
+
+// ---------------------------------------------------------------- pmm
+extern volatile uint16_t gau16SimPmm[3];
+
+#define PMMCTL0                         (gau16SimPmm[0])
+#define PMMCTL2                         (gau16SimPmm[2])
+#define PMMPW                           (0xA500)
+#define INTREFEN                        (0x0001)
+#define TSENSOREN                       (0x0008)
+
+// ---------------------------------------------------------------- eusci
+#define UCSSEL__UCLK                    (0x0000)
+#define UCSSEL__SMCLK                   (0x0080)
+
+#endif /* SIM_MSP430_H_ */
@@ -0,0 +1,234 @@
+/*
+ * sim_hw.c (host simulator)
+ *
+ *  device registers as memory, interrupt vector reads, and the few
+ *  firmware modules not built for the host (clock, uart, i2c sensors).
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <msp430.h>
+#include "clocks.h"
+#include "i2c.h"
+#include "tmp1075.h"
+#include "uart.h"
+#include "sim_hw.h"
+
+volatile uint8_t  gaubySimPort[6][8];
+volatile uint8_t  gaubySimPortIfg[6];
+volatile uint16_t gau16SimTb[4][SIM_TB_WORDS];
+volatile uint16_t gau16SimAdc[8];
+volatile uint16_t gau16SimPmm[3];
+
+// typical FR2355 device descriptors
+uint16_t gu16SimTlvAdc30C  = 2152;
+uint16_t gu16SimTlvAdc105C = 2838;
+
+static bool bSimAdcIfg;
+
+// i2c sensors are not in use (main.c); no TMP1075 messages
+stI2cTrasaction_t* pastTmp1075I2cMsgTable[MAX_I2C_TMP1075_MESSAGES + 1];
+
+bool     gbSimUartEcho = false;
+bool     gbSimTlmCliText = false;
+uint32_t gu32SimUartLines;
+FILE*    gpSimTlmFile;
+
+
+// reading P4IV clears the highest priority (lowest pin) pending flag
+uint16_t simReadP4Iv(void)
+{
+    uint8_t ubyPending = P4IFG & P4IE;
+    uint8_t ubyPin;
+
+    for (ubyPin=0; ubyPin<8; ubyPin++)
+    {
+        if (ubyPending & (1 << ubyPin))
+        {
+            P4IFG &= ~(1 << ubyPin);
+            return 2 * (ubyPin + 1);
+        }
+    }
+
+    return P4IV__NONE;
+}
+
+
+// only the overflow (TBIFG) is modelled
+uint16_t simReadTbIv(uint8_t ubyTmr)
+{
+    if (SIM_TB_CTL(ubyTmr) & TBIFG)
+    {
+        SIM_TB_CTL(ubyTmr) &= ~TBIFG;
+        return TB1IV_TBIFG;
+    }
+
+    return 0;
+}
+
+
+uint16_t simReadAdcIv(void)
+{
+    if (bSimAdcIfg)
+    {
+        bSimAdcIfg = false;
+        return ADCIV_ADCIFG;
+    }
+
+    return ADCIV_NONE;
+}
+
+
+// a conversion was started by the firmware (ADCSC)
+bool simHwAdcPending()
+{
+    return (ADCCTL0 & ADCSC) != 0;
+}
+
+
+// completes the conversion with u16Sample; ADC interrupt
+void simHwAdcComplete(uint16_t u16Sample)
+{
+    ADCCTL0   &= ~ADCSC;
+    ADCMEM0    = u16Sample;
+    bSimAdcIfg = true;
+    ADC_ISR();
+}
+
+
+// tach edge on a P4 pin at TB1 count u16FreeRunCnt
+void simHwTachEdge(uint8_t ubyPin, uint16_t u16FreeRunCnt)
+{
+    TB1R   = u16FreeRunCnt;
+    P4IFG |= (1 << ubyPin);
+    if (P4IE & (1 << ubyPin))
+    {
+        Port_4();
+    }
+}
+
+
+// free running timer (TB1) advanced u16Cnt counts; overflow interrupt on wrap
+void simHwFreeRunAdvance(uint16_t u16Cnt)
+{
+    uint16_t u16Prev = TB1R;
+
+    TB1R = u16Prev + u16Cnt;
+    if (TB1R < u16Prev)
+    {
+        TB1CTL |= TBIFG;
+        if (TB1CTL & TBIE)
+        {
+            TIMERB1_B3_TB1IV_ISR();
+        }
+    }
+}
+
+
+void simHwTick()
+{
+    // serviceTimers() stops the ticker while it runs
+    if ((TB0CTL & MC) != MC__STOP)
+    {
+        TimerB0_3_ISR1();
+    }
+}
+
+
+stDevClks_t getClockFreq()
+{
+    stDevClks_t stClks =
+    {
+        .ui32MclkHz   = 8000000,
+        .ui32SmclkHz  = 8000000,
+        .ui32AclkHz   = 32768,
+        .ui32RefClkHz = 32768
+    };
+
+    return stClks;
+}
+
+
+void UART_putStringSerial(char *string)
+{
+    if (gbSimUartEcho)
+    {
+        fputs(string, stdout);
+    }
+}
+
+
+// every uart is taken as configured
+bool UART_isCfg(eUartNum_t eUartNum)
+{
+    return eUartNum < NUM_UARTS;
+}
+
+
+/*
+ * telemetry frames to gpSimTlmFile; the output buffer never fills.
+ *  gbSimTlmCliText puts a cli prompt ahead of each frame, as on a uart
+ *  shared with the cli.
+ */
+uint16_t UART_write(eUartNum_t eUartNum, eUartStream_t eStream, const char* pchData, uint16_t u16Len, bool bWhole)
+{
+    if ((eStream == UART_STREAM_TLM) && (gpSimTlmFile != NULL))
+    {
+        if (gbSimTlmCliText)
+        {
+            fputs("\r\n>>", gpSimTlmFile);
+        }
+        fwrite(pchData, 1, u16Len, gpSimTlmFile);
+    }
+    else if (gbSimUartEcho)
+    {
+        fwrite(pchData, 1, u16Len, stdout);
+    }
+
+    return u16Len;
+}
+
+
+// staged output (fmt.c); sent as one UART_write() on commit
+static char     achSimTxStage[512];
+static uint16_t u16SimTxStageLen;
+
+void UART_txStageBegin(eUartNum_t eUartNum)
+{
+    u16SimTxStageLen = 0;
+}
+
+
+uint16_t UART_txStage(eUartNum_t eUartNum, const char* pchData, uint16_t u16Len)
+{
+    if (u16Len > sizeof(achSimTxStage) - u16SimTxStageLen)
+    {
+        u16Len = sizeof(achSimTxStage) - u16SimTxStageLen;
+    }
+    memcpy(&achSimTxStage[u16SimTxStageLen], pchData, u16Len);
+    u16SimTxStageLen += u16Len;
+
+    return u16Len;
+}
+
+
+uint16_t UART_txCommit(eUartNum_t eUartNum, eUartStream_t eStream, bool bWhole)
+{
+    uint16_t u16Len = u16SimTxStageLen;
+
+    u16SimTxStageLen = 0;
+
+    return UART_write(eUartNum, eStream, achSimTxStage, u16Len, bWhole);
+}
+
+
+void UART_printNewLineAndPrompt(void)
+{
+    gu32SimUartLines++;
+    if (gbSimUartEcho)
+    {
+        fputs("\n", stdout);
+    }
+}
@@ -0,0 +1,32 @@
+/*
+ * sim_hw.h (host simulator)
+ */
+
+#ifndef SIM_HW_H_
+#define SIM_HW_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// free running timer (TB1) counts per ms; SMCLK 8MHz / 64
+#define SIM_FREE_RUN_CNT_PER_MS     (125)
+
+extern bool     gbSimUartEcho;
+extern bool     gbSimTlmCliText;
+extern uint32_t gu32SimUartLines;
+extern FILE*    gpSimTlmFile;
+
+bool simHwAdcPending();
+void simHwAdcComplete(uint16_t u16Sample);
+void simHwTachEdge(uint8_t ubyPin, uint16_t u16FreeRunCnt);
+void simHwFreeRunAdvance(uint16_t u16Cnt);
+void simHwTick();
+
+// firmware ISRs; plain functions on the host
+void TimerB0_3_ISR1(void);
+void TIMERB1_B3_TB1IV_ISR(void);
+void Port_4(void);
+void ADC_ISR(void);
+
+#endif /* SIM_HW_H_ */
@@ -0,0 +1,450 @@
+/*
+ * sim_main.c (host simulator)
+ *
+ *  closed loop run of the thermal control firmware (thermalcontrol.c,
+ *  fans.c, fanhealth.c, power.c, rtd.c, adc.c, timers) against the plant
+ *  of sim_plant.c. the firmware runs unmodified off a simulated 1 ms
+ *  ticker; its pwm registers drive the plant, the plant drives the tach
+ *  edges and the ADC samples. every simulated ms runs the ticker and the
+ *  tach isrs, so a run goes at about 17000x real time: a week in ~36 s,
+ *  a month in ~2.5 min.
+ *
+ *  reports, for tuning and regression checks of controller changes:
+ *   - time the heat sinks spend in a temperature band and in each of the
+ *     firmware thermal zones
+ *   - peak temperature and overshoot above the band
+ *   - average fan duty and duty^3 (fan power proxy), heater on time
+ *   - # of pwm register updates
+ *
+ *  -p plays a firmware self test profile (selftest.c) once thermal control
+ *   runs, at its own rate or every -r ms; the run ends with the test and
+ *   prints its records. exit status 0 => pass.
+ *
+ *  -T streams the firmware telemetry frames (telemetry.c) to a file every
+ *   -P ms; tools/tlmdecode turns them into csv. -X puts cli text between
+ *   the frames, as on a uart shared with the cli.
+ *
+ *  usage: thermsim [-d days] [-s seed] [-a ambient C] [-w swing C]
+ *                  [-n adc noise lsb] [-l band low C] [-u band high C]
+ *                  [-H 0|1 heaters] [-t trace period s] [-v]
+ *                  [-p self test profile] [-r self test step ms]
+ *                  [-T telemetry file] [-P telemetry period ms] [-X]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "config.h"
+#include "main.h"
+#include "timer.h"
+#include "adc.h"
+#include "rtd.h"
+#include "fans.h"
+#include "fanhealth.h"
+#include "power.h"
+#include "thermalcontrol.h"
+#include "selftest.h"
+#include "telemetry.h"
+#include "sim_hw.h"
+#include "sim_plant.h"
+
+#define SIM_PLANT_STEP_MS       (10)
+#define SIM_MAX_EDGES_PER_MS    (4 * NUM_FANS)
+#define SIM_MS_PER_DAY          (86400000ULL)
+
+volatile stMainEvts_t gstMainEvts;
+
+typedef struct SIM_METRICS
+{
+    uint64_t u64Samples;
+    uint64_t au64InBand[SIM_NUM_NODES];
+    double   adPeakC[SIM_NUM_NODES];
+    double   adMinC[SIM_NUM_NODES];
+    double   adDutySum[NUM_FANS];
+    double   adDutyCubeSum[NUM_FANS];
+    uint64_t au64TzSamples[NUM_FANS][NUM_TZONES];
+    uint64_t u64HtrOnSum;
+    uint32_t au32PwmUpdates[NUM_FANS];
+}stSimMetrics_t;
+
+static stSimMetrics_t stSimMetrics;
+static double dSimBandLoC = 15.0;
+static double dSimBandHiC = 45.0;
+
+
+// duty (0.1%) on the pwm of a fan; TB3 CCRn holds period - duty
+static double simFanDuty(uint8_t ubyFanIndx)
+{
+    uint16_t u16Prd = SIM_TB_CCR(3, 0);
+    uint16_t u16Ccr = SIM_TB_CCR(3, gastFanDesc[ubyFanIndx].ubyCcrNum);
+
+    if ((u16Prd == 0) || (u16Ccr >= u16Prd))
+    {
+        return 0;
+    }
+
+    return 1000.0 * (u16Prd - u16Ccr) / u16Prd;
+}
+
+
+// main_events() for the modules built for the host
+static void simMainEvents()
+{
+    while (gstMainEvts.wAll)
+    {
+        if (gstMainEvts.bits.svcTicker)
+        {
+            serviceTimers();
+        }
+
+        if (simHwAdcPending())
+        {
+            simHwAdcComplete(simPlantAdcSample(ADCMCTL0 & ADCINCH));
+        }
+
+        if (gstMainEvts.bits.svcRtdAdc == true)
+        {
+            transformRtdAdcToTmp();
+        }
+
+        if (gstMainEvts.bits.svcFanHealth == true)
+        {
+            fanHealthReport();
+        }
+
+        if (gstMainEvts.bits.svcSelfTest == true)
+        {
+            selfTestReport();
+        }
+
+        // nothing else runs on the host
+        gstMainEvts.wAll &= (1 << 0) | (1 << 12) | (1 << 13) | (1 << 14);
+    }
+}
+
+
+/*
+ * simTachEdges(): tach edges of this ms, in time order; the free running
+ *  timer is moved to each edge before the edge interrupt.
+ */
+static void simTachEdges()
+{
+    uint16_t au16EdgeCnt[SIM_MAX_EDGES_PER_MS];
+    uint8_t  aubyEdgePin[SIM_MAX_EDGES_PER_MS];
+    uint8_t  ubyEdges = 0;
+    uint16_t u16At    = 0;
+    double   dPerMs;
+    uint8_t  ubyFanIndx;
+    uint8_t  ubyIndx;
+    uint8_t  ubyPos;
+
+    for (ubyFanIndx=0; ubyFanIndx<NUM_FANS; ubyFanIndx++)
+    {
+        dPerMs = gstSimPlant.adFanPulsesPerMs[ubyFanIndx];
+        gstSimPlant.adFanPhase[ubyFanIndx] += dPerMs;
+
+        while ((gstSimPlant.adFanPhase[ubyFanIndx] >= 1.0) && (ubyEdges < SIM_MAX_EDGES_PER_MS))
+        {
+            gstSimPlant.adFanPhase[ubyFanIndx] -= 1.0;
+
+            // insert by time; the edge was phase/rate ago
+            au16EdgeCnt[ubyEdges] = (uint16_t)(SIM_FREE_RUN_CNT_PER_MS *
+                                    (1.0 - gstSimPlant.adFanPhase[ubyFanIndx] / dPerMs));
+            aubyEdgePin[ubyEdges] = gastFanDesc[ubyFanIndx].ubyTachPin;
+            for (ubyPos=ubyEdges; (ubyPos > 0) && (au16EdgeCnt[ubyPos - 1] > au16EdgeCnt[ubyPos]); ubyPos--)
+            {
+                uint16_t u16Cnt = au16EdgeCnt[ubyPos];
+                uint8_t  ubyPin = aubyEdgePin[ubyPos];
+
+                au16EdgeCnt[ubyPos]     = au16EdgeCnt[ubyPos - 1];
+                aubyEdgePin[ubyPos]     = aubyEdgePin[ubyPos - 1];
+                au16EdgeCnt[ubyPos - 1] = u16Cnt;
+                aubyEdgePin[ubyPos - 1] = ubyPin;
+            }
+            ubyEdges++;
+        }
+    }
+
+    for (ubyIndx=0; ubyIndx<ubyEdges; ubyIndx++)
+    {
+        simHwFreeRunAdvance(au16EdgeCnt[ubyIndx] - u16At);
+        u16At = au16EdgeCnt[ubyIndx];
+        simHwTachEdge(aubyEdgePin[ubyIndx], TB1R);
+    }
+    simHwFreeRunAdvance(SIM_FREE_RUN_CNT_PER_MS - u16At);
+}
+
+
+static void simSample(const double* pdDuty)
+{
+    uint8_t ubyIndx;
+    double  dTemp;
+
+    stSimMetrics.u64Samples++;
+
+    for (ubyIndx=0; ubyIndx<SIM_NUM_NODES; ubyIndx++)
+    {
+        dTemp = gstSimPlant.adTempC[ubyIndx];
+        if ((dTemp >= dSimBandLoC) && (dTemp <= dSimBandHiC))
+        {
+            stSimMetrics.au64InBand[ubyIndx]++;
+        }
+        if (dTemp > stSimMetrics.adPeakC[ubyIndx])
+        {
+            stSimMetrics.adPeakC[ubyIndx] = dTemp;
+        }
+        if (dTemp < stSimMetrics.adMinC[ubyIndx])
+        {
+            stSimMetrics.adMinC[ubyIndx] = dTemp;
+        }
+    }
+
+    for (ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        stSimMetrics.adDutySum[ubyIndx]     += pdDuty[ubyIndx] / 1000.0;
+        stSimMetrics.adDutyCubeSum[ubyIndx] += (pdDuty[ubyIndx] / 1000.0) * (pdDuty[ubyIndx] / 1000.0) * (pdDuty[ubyIndx] / 1000.0);
+        if (gubyCurrentTz[ubyIndx] < NUM_TZONES)
+        {
+            stSimMetrics.au64TzSamples[ubyIndx][gubyCurrentTz[ubyIndx]]++;
+        }
+    }
+
+    stSimMetrics.u64HtrOnSum += __builtin_popcount(gubyHtrOnMask);
+}
+
+
+static void simReport(double dDays, double dWallS)
+{
+    double  dN = (double)stSimMetrics.u64Samples;
+    uint8_t ubyIndx;
+    uint8_t ubyTz;
+
+    printf("simulated %.2f days in %.1f s (%.0fx real time)\n", dDays, dWallS,
+           (dWallS > 0) ? dDays * 86400.0 / dWallS : 0.0);
+    printf("ambient %.1f +/- %.1f C, band %.1f to %.1f C\n\n",
+           gstSimPlantCfg.dAmbMeanC, gstSimPlantCfg.dAmbSwingC, dSimBandLoC, dSimBandHiC);
+
+    printf("node  in band  peak C  overshoot C  min C\n");
+    for (ubyIndx=0; ubyIndx<SIM_NUM_NODES; ubyIndx++)
+    {
+        printf("%-4s  %6.2f%%  %6.2f  %11.2f  %5.2f\n", ubyIndx ? "GPU" : "CPU",
+               100.0 * stSimMetrics.au64InBand[ubyIndx] / dN,
+               stSimMetrics.adPeakC[ubyIndx],
+               (stSimMetrics.adPeakC[ubyIndx] > dSimBandHiC) ? stSimMetrics.adPeakC[ubyIndx] - dSimBandHiC : 0.0,
+               stSimMetrics.adMinC[ubyIndx]);
+    }
+
+    printf("\nfan  avg duty  avg duty^3  pwm updates  updates/h  time in zone 0..%d (%%)\n", NUM_TZONES - 1);
+    for (ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        printf("%-3u  %7.2f%%  %9.4f  %11u  %9.1f ", ubyIndx,
+               100.0 * stSimMetrics.adDutySum[ubyIndx] / dN,
+               stSimMetrics.adDutyCubeSum[ubyIndx] / dN,
+               stSimMetrics.au32PwmUpdates[ubyIndx],
+               stSimMetrics.au32PwmUpdates[ubyIndx] / (dDays * 24.0));
+        for (ubyTz=0; ubyTz<NUM_TZONES; ubyTz++)
+        {
+            printf(" %.1f", 100.0 * stSimMetrics.au64TzSamples[ubyIndx][ubyTz] / dN);
+        }
+        printf("\n");
+    }
+
+    printf("\nheaters on (avg of %d): %.3f\n", NUM_HEATERS, stSimMetrics.u64HtrOnSum / dN);
+    printf("fan health reports: %u\n", gu32SimUartLines);
+}
+
+
+// self test result and records; as 'get selftest'
+static int simSelfTestReport(double dRunS)
+{
+    stSelfTestRec_t* pstRec;
+    uint8_t ubyIndx;
+
+    printf("self test %s: %s in %.2f s, step %u ms, %u fails, %u records (%u lost)\n",
+           gastSelfTestProfile[gstSelfTest.ubyProfile].pchName, gapchSelfTestStateName[gstSelfTest.ubyState],
+           dRunS, gstSelfTest.u16StepMs, gstSelfTest.ubyFailCnt, gstSelfTest.ubyRecCnt, gstSelfTest.ubyRecLost);
+    printf("seg  fan  tz  duty%%  rpm\n");
+    for (ubyIndx=0; ubyIndx<gstSelfTest.ubyRecCnt; ubyIndx++)
+    {
+        pstRec = &gastSelfTestRec[ubyIndx];
+        printf("%2u%c  %3u  %2u  %5u  %4u\n", pstRec->ubySeg & ~SELFTEST_REC_FAIL,
+               (pstRec->ubySeg & SELFTEST_REC_FAIL) ? '*' : ' ',
+               pstRec->ubyFanTz >> 4, pstRec->ubyFanTz & 0x0F, pstRec->ubyDutyPct, pstRec->ubyRpmDiv32 << 5);
+    }
+
+    return (gstSelfTest.ubyState == SELFTEST_PASS) ? 0 : 1;
+}
+
+
+int main(int argc, char* argv[])
+{
+    double   dDays    = 7.0;
+    double   dTraceS  = 0;
+    double   adDuty[NUM_FANS];
+    uint16_t au16CcrPrev[NUM_FANS];
+    uint64_t u64Ms;
+    uint64_t u64EndMs;
+    uint64_t u64TraceMs;
+    uint8_t  ubyIndx;
+    uint16_t u16Ccr;
+    int      iHeaters = -1;
+    int      iSelfTest = -1;
+    uint16_t u16SelfTestStepMs = 0;
+    uint64_t u64SelfTestStartMs = 0;
+    char*    pchTlmFile = NULL;
+    uint16_t u16TlmPeriodMs = 100;
+    int      iOpt;
+    struct timespec stStart;
+    struct timespec stEnd;
+
+    while ((iOpt = getopt(argc, argv, "d:s:a:w:n:l:u:H:t:p:r:T:P:Xv")) != -1)
+    {
+        switch (iOpt)
+        {
+        case 'd': dDays                       = atof(optarg);               break;
+        case 's': gstSimPlantCfg.u64Seed      = strtoull(optarg, NULL, 0);  break;
+        case 'a': gstSimPlantCfg.dAmbMeanC    = atof(optarg);               break;
+        case 'w': gstSimPlantCfg.dAmbSwingC   = atof(optarg);               break;
+        case 'n': gstSimPlantCfg.dAdcNoiseLsb = atof(optarg);               break;
+        case 'l': dSimBandLoC                 = atof(optarg);               break;
+        case 'u': dSimBandHiC                 = atof(optarg);               break;
+        case 'H': iHeaters                    = atoi(optarg);               break;
+        case 't': dTraceS                     = atof(optarg);               break;
+        case 'p': iSelfTest                   = atoi(optarg);               break;
+        case 'r': u16SelfTestStepMs           = atoi(optarg);               break;
+        case 'T': pchTlmFile                  = optarg;                     break;
+        case 'P': u16TlmPeriodMs              = atoi(optarg);               break;
+        case 'X': gbSimTlmCliText             = true;                       break;
+        case 'v': gbSimUartEcho               = true;                       break;
+        default:
+            fprintf(stderr, "usage: %s [-d days] [-s seed] [-a ambient C] [-w swing C] [-n adc noise lsb]\n"
+                            "       [-l band low C] [-u band high C] [-H 0|1 heaters] [-t trace period s] [-v]\n"
+                            "       [-p self test profile] [-r self test step ms]\n"
+                            "       [-T telemetry file] [-P telemetry period ms] [-X]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    simPlantInit();
+
+    // firmware start up; as main.c
+    TMR_CfgTimerBxTick(TMR_TICKER_TIMER, TMR_TICKER_PERIOD);
+    initPower();
+    initThermalControl();
+    initFans();
+    initFanHealth();
+    initRtd();
+
+    // what an operator sets on the cli
+    gbyTmpRangeMax = 120;
+    gbyTmpRangeMin = -40;
+    if (iHeaters >= 0)
+    {
+        gbIsHtrOn = (iHeaters != 0);
+    }
+    if (pchTlmFile != NULL)
+    {
+        if ((gpSimTlmFile = fopen(pchTlmFile, "wb")) == NULL)
+        {
+            perror(pchTlmFile);
+            return 1;
+        }
+        if (!tlmStart(UART_TLM, u16TlmPeriodMs))
+        {
+            fprintf(stderr, "telemetry period %u ms below %u ms\n", u16TlmPeriodMs, TLM_PERIOD_MIN_MS);
+            return 1;
+        }
+    }
+
+    memset(&stSimMetrics, 0, sizeof(stSimMetrics));
+    for (ubyIndx=0; ubyIndx<SIM_NUM_NODES; ubyIndx++)
+    {
+        stSimMetrics.adPeakC[ubyIndx] = -1e9;
+        stSimMetrics.adMinC[ubyIndx]  = 1e9;
+    }
+    for (ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        adDuty[ubyIndx]      = simFanDuty(ubyIndx);
+        au16CcrPrev[ubyIndx] = SIM_TB_CCR(3, gastFanDesc[ubyIndx].ubyCcrNum);
+    }
+
+    if (dTraceS > 0)
+    {
+        printf("t_h,amb_c,cpu_c,gpu_c,rtd_avg_c");
+        for (ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+        {
+            printf(",duty%u_pct,rpm%u,tach%u", ubyIndx, ubyIndx, ubyIndx);
+        }
+        printf(",htr_mask\n");
+    }
+
+    u64EndMs   = (uint64_t)(dDays * SIM_MS_PER_DAY);
+    u64TraceMs = (uint64_t)(dTraceS * 1000.0);
+    clock_gettime(CLOCK_MONOTONIC, &stStart);
+
+    for (u64Ms=0; u64Ms<u64EndMs; u64Ms++)
+    {
+        simTachEdges();
+        simHwTick();
+        simMainEvents();
+
+        if (iSelfTest >= 0)
+        {
+            // started once the first sensor read has started thermal control
+            if ((u64SelfTestStartMs == 0) && bIsThermalControlled)
+            {
+                if (!selfTestStart(iSelfTest, u16SelfTestStepMs))
+                {
+                    fprintf(stderr, "no self test profile %d\n", iSelfTest);
+                    return 1;
+                }
+                u64SelfTestStartMs = u64Ms + 1;
+            }
+            else if (u64SelfTestStartMs && (gstSelfTest.ubyState != SELFTEST_RUNNING))
+            {
+                return simSelfTestReport((u64Ms + 1 - u64SelfTestStartMs) / 1000.0);
+            }
+        }
+
+        for (ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+        {
+            u16Ccr = SIM_TB_CCR(3, gastFanDesc[ubyIndx].ubyCcrNum);
+            if (u16Ccr != au16CcrPrev[ubyIndx])
+            {
+                au16CcrPrev[ubyIndx] = u16Ccr;
+                adDuty[ubyIndx]      = simFanDuty(ubyIndx);
+                stSimMetrics.au32PwmUpdates[ubyIndx]++;
+            }
+        }
+
+        if ((u64Ms % SIM_PLANT_STEP_MS) == 0)
+        {
+            simPlantStep(u64Ms / 1000.0, SIM_PLANT_STEP_MS / 1000.0, adDuty, gubyHtrOnMask);
+            simSample(adDuty);
+        }
+
+        if (u64TraceMs && ((u64Ms % u64TraceMs) == 0))
+        {
+            printf("%.4f,%.2f,%.2f,%.2f,%.2f", u64Ms / 3600000.0, gstSimPlant.dAmbC,
+                   gstSimPlant.adTempC[0], gstSimPlant.adTempC[1], gfRtdTempAvg);
+            for (ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+            {
+                printf(",%.1f,%.0f,%u", adDuty[ubyIndx] / 10.0, gstSimPlant.adFanRpm[ubyIndx],
+                       stFanTach[ubyIndx].u16Rpm);
+            }
+            printf(",0x%02X\n", gubyHtrOnMask);
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stEnd);
+    if (gpSimTlmFile != NULL)
+    {
+        fclose(gpSimTlmFile);
+    }
+    simReport(dDays, (stEnd.tv_sec - stStart.tv_sec) + (stEnd.tv_nsec - stStart.tv_nsec) / 1e9);
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * sim_plant.c (host simulator)
+ *
+ *  per node:  C dT/dt = Pload + Pheaters/2 - (G0 + Gfan * airflow) * (T - Tamb)
+ *   stepped exactly for a constant input over the step.
+ *  fan n cools node n; fans past the 2nd blow over both nodes at half rate.
+ *  fan speed follows the firmware's default rpm map (FAN_RPM_MAP_DEFAULT)
+ *   with a first order lag; airflow is proportional to rpm.
+ *  RTD: PT1000 under a 1000 ohm reference from 3.3V into a 12 bit ADC, as
+ *   rtd.c assumes; the on-chip sensor reads the board, ambient + 5C.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "adc.h"
+#include "rtd.h"
+#include "sim_plant.h"
+
+#define SIM_FAN_MAP_PTS         (5)
+#define SIM_BOARD_OVER_AMB_C    (5.0)
+#define SIM_DAY_S               (86400.0)
+#define SIM_PI                  (3.14159265358979)
+
+stSimPlantCfg_t gstSimPlantCfg =
+{
+    .adCapJPerK     = {200.0, 300.0},
+    .adG0WPerK      = {0.5, 0.6},
+    .adGFanWPerK    = {4.0, 5.0},
+    .adLoadMinW     = {10.0, 5.0},
+    .adLoadMaxW     = {65.0, 90.0},
+    .dLoadHoldS     = 600.0,
+    .dHtrW          = 10.0,
+    .dAmbMeanC      = 25.0,
+    .dAmbSwingC     = 8.0,
+    .dFanStartPm    = 200.0,
+    .dFanStopPm     = 100.0,
+    .dFanTauS       = 1.0,
+    .dAdcNoiseLsb   = 1.0,
+    .u64Seed        = 1
+};
+
+stSimPlant_t gstSimPlant;
+
+static const uint16_t au16SimFanMap[SIM_FAN_MAP_PTS] = FAN_RPM_MAP_DEFAULT;
+
+
+// xorshift64*; uniform in [0, 1)
+double simPlantRandUniform()
+{
+    gstSimPlant.u64Rng ^= gstSimPlant.u64Rng >> 12;
+    gstSimPlant.u64Rng ^= gstSimPlant.u64Rng << 25;
+    gstSimPlant.u64Rng ^= gstSimPlant.u64Rng >> 27;
+
+    return (double)((gstSimPlant.u64Rng * 2685821657736338717ULL) >> 11) / 9007199254740992.0;
+}
+
+
+static double simPlantRandGauss()
+{
+    double dU1 = simPlantRandUniform() + 1e-12;
+    double dU2 = simPlantRandUniform();
+
+    return sqrt(-2.0 * log(dU1)) * cos(2.0 * SIM_PI * dU2);
+}
+
+
+static void simPlantNewLoad(uint8_t ubyNode)
+{
+    stSimPlantCfg_t* pstCfg = &gstSimPlantCfg;
+
+    gstSimPlant.adLoadW[ubyNode]     = pstCfg->adLoadMinW[ubyNode] +
+                                       (pstCfg->adLoadMaxW[ubyNode] - pstCfg->adLoadMinW[ubyNode]) * simPlantRandUniform();
+    gstSimPlant.adLoadLeftS[ubyNode] = -pstCfg->dLoadHoldS * log(1.0 - simPlantRandUniform());
+}
+
+
+// rpm a running fan settles at for a duty (0.1%)
+static double simPlantFanRpm(double dDutyPm)
+{
+    double  dPos  = dDutyPm / 250.0;
+    uint8_t ubyPt = (uint8_t)dPos;
+
+    if (ubyPt >= SIM_FAN_MAP_PTS - 1)
+    {
+        return au16SimFanMap[SIM_FAN_MAP_PTS - 1];
+    }
+
+    return au16SimFanMap[ubyPt] + (au16SimFanMap[ubyPt + 1] - au16SimFanMap[ubyPt]) * (dPos - ubyPt);
+}
+
+
+void simPlantInit()
+{
+    uint8_t ubyNode;
+
+    memset(&gstSimPlant, 0, sizeof(gstSimPlant));
+    gstSimPlant.u64Rng = gstSimPlantCfg.u64Seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    gstSimPlant.dAmbC = gstSimPlantCfg.dAmbMeanC;
+    for (ubyNode=0; ubyNode<SIM_NUM_NODES; ubyNode++)
+    {
+        gstSimPlant.adTempC[ubyNode] = gstSimPlant.dAmbC;
+        simPlantNewLoad(ubyNode);
+    }
+}
+
+
+/*
+ * simPlantStep(): advance the plant dDtS seconds; pdFanDuty[] is the duty
+ *  (0.1%) on each fan pwm, ubyHtrOnMask the heaters on (bit n = heater n).
+ */
+void simPlantStep(double dTimeS, double dDtS, const double* pdFanDuty, uint8_t ubyHtrOnMask)
+{
+    stSimPlantCfg_t* pstCfg = &gstSimPlantCfg;
+    double  adAirflow[SIM_NUM_NODES] = {0};
+    double  dFanMax = au16SimFanMap[SIM_FAN_MAP_PTS - 1];
+    double  dHtrW   = 0;
+    double  dTarget;
+    double  dG;
+    double  dTInf;
+    uint8_t ubyIndx;
+
+    gstSimPlant.dAmbC = pstCfg->dAmbMeanC + pstCfg->dAmbSwingC * sin(2.0 * SIM_PI * dTimeS / SIM_DAY_S);
+
+    for (ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        // a stopped fan needs the start duty; a running one stops below the stop duty
+        if ((pdFanDuty[ubyIndx] < pstCfg->dFanStopPm) ||
+            ((gstSimPlant.adFanRpm[ubyIndx] < 1.0) && (pdFanDuty[ubyIndx] < pstCfg->dFanStartPm)))
+        {
+            dTarget = 0;
+        }
+        else
+        {
+            dTarget = simPlantFanRpm(pdFanDuty[ubyIndx]);
+        }
+        gstSimPlant.adFanRpm[ubyIndx] += (dTarget - gstSimPlant.adFanRpm[ubyIndx]) * (1.0 - exp(-dDtS / pstCfg->dFanTauS));
+        if ((dTarget == 0) && (gstSimPlant.adFanRpm[ubyIndx] < 1.0))
+        {
+            gstSimPlant.adFanRpm[ubyIndx] = 0;
+        }
+        gstSimPlant.adFanPulsesPerMs[ubyIndx] = gstSimPlant.adFanRpm[ubyIndx] * FAN_TACH_PULSES_PER_REV / 60000.0;
+
+        if (ubyIndx < SIM_NUM_NODES)
+        {
+            adAirflow[ubyIndx] += gstSimPlant.adFanRpm[ubyIndx] / dFanMax;
+        }
+        else
+        {
+            adAirflow[0] += 0.5 * gstSimPlant.adFanRpm[ubyIndx] / dFanMax;
+            adAirflow[1] += 0.5 * gstSimPlant.adFanRpm[ubyIndx] / dFanMax;
+        }
+    }
+
+    for (ubyIndx=0; ubyIndx<NUM_HEATERS; ubyIndx++)
+    {
+        if (ubyHtrOnMask & (1 << ubyIndx))
+        {
+            dHtrW += pstCfg->dHtrW;
+        }
+    }
+
+    for (ubyIndx=0; ubyIndx<SIM_NUM_NODES; ubyIndx++)
+    {
+        gstSimPlant.adLoadLeftS[ubyIndx] -= dDtS;
+        if (gstSimPlant.adLoadLeftS[ubyIndx] <= 0)
+        {
+            simPlantNewLoad(ubyIndx);
+        }
+
+        dG    = pstCfg->adG0WPerK[ubyIndx] + pstCfg->adGFanWPerK[ubyIndx] * adAirflow[ubyIndx];
+        dTInf = gstSimPlant.dAmbC + (gstSimPlant.adLoadW[ubyIndx] + dHtrW / SIM_NUM_NODES) / dG;
+        gstSimPlant.adTempC[ubyIndx] += (dTInf - gstSimPlant.adTempC[ubyIndx]) *
+                                        (1.0 - exp(-dDtS * dG / pstCfg->adCapJPerK[ubyIndx]));
+    }
+}
+
+
+// ADC count of a channel at present; quantized, with noise
+uint16_t simPlantAdcSample(uint8_t ubyAdcCh)
+{
+    double dCnt;
+    double dOhms;
+
+    if (ubyAdcCh == ADC_ON_CHIP_TMP_SNSR)
+    {
+        dCnt = ADC_30C_AT_1_5V_REF + (gstSimPlant.dAmbC + SIM_BOARD_OVER_AMB_C - 30.0) *
+                                     (ADC_105C_AT_1_5V_REF - ADC_30C_AT_1_5V_REF) / (105.0 - 30.0);
+    }
+    else
+    {
+        // RTD4 => GPU, RTD5 => CPU
+        dOhms = RTD_REF_RESISTOR_OHMS * (1.0 + gstSimPlant.adTempC[(ubyAdcCh == ADC_CHA5) ? 0 : 1] / RTD_ONE_OVER_ALPHA);
+        dCnt  = 4096.0 * dOhms / (dOhms + RTD_REF_RESISTOR_OHMS);
+    }
+
+    dCnt += gstSimPlantCfg.dAdcNoiseLsb * simPlantRandGauss();
+    dCnt  = floor(dCnt + 0.5);
+
+    if (dCnt < 0)
+    {
+        dCnt = 0;
+    }
+    else if (dCnt > 4095)
+    {
+        dCnt = 4095;
+    }
+
+    return (uint16_t)dCnt;
+}
@@ -0,0 +1,57 @@
+/*
+ * sim_plant.h (host simulator)
+ *
+ *  thermal plant seen by the firmware: two heat sinks (CPU, GPU) as first
+ *  order RC nodes to ambient, fan airflow vs rpm, fan spin up, heaters,
+ *  and the RTD/ADC path with quantization and noise.
+ */
+
+#ifndef SIM_PLANT_H_
+#define SIM_PLANT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#define SIM_NUM_NODES           (2)     // 0: CPU (RTD5), 1: GPU (RTD4)
+
+typedef struct SIM_PLANT_CFG
+{
+    double  adCapJPerK[SIM_NUM_NODES];      // heat sink thermal capacity
+    double  adG0WPerK[SIM_NUM_NODES];       // conductance to ambient, fans stopped
+    double  adGFanWPerK[SIM_NUM_NODES];     // conductance added at full airflow
+    double  adLoadMinW[SIM_NUM_NODES];      // work load power; random steps in
+    double  adLoadMaxW[SIM_NUM_NODES];      //  [min, max] ...
+    double  dLoadHoldS;                     //  held for an exponential time of this mean
+    double  dHtrW;                          // power of one heater; split over the nodes
+    double  dAmbMeanC;                      // ambient: mean + daily sine swing
+    double  dAmbSwingC;
+    double  dFanMaxRpm;                     // rpm at 100% duty
+    double  dFanStartPm;                    // duty (0.1%) a stopped fan needs to start
+    double  dFanStopPm;                     // duty (0.1%) below which a fan stops
+    double  dFanTauS;                       // fan speed time constant
+    double  dAdcNoiseLsb;                   // rms noise of an ADC sample
+    uint64_t u64Seed;
+}stSimPlantCfg_t;
+
+typedef struct SIM_PLANT
+{
+    double  adTempC[SIM_NUM_NODES];         // heat sink temperature (true)
+    double  adLoadW[SIM_NUM_NODES];
+    double  adLoadLeftS[SIM_NUM_NODES];     // time left at the present load
+    double  dAmbC;
+    double  adFanRpm[NUM_FANS];
+    double  adFanPhase[NUM_FANS];           // tach pulses owed, fraction
+    double  adFanPulsesPerMs[NUM_FANS];     // tach rate; set with the rpm
+    uint64_t u64Rng;
+}stSimPlant_t;
+
+extern stSimPlantCfg_t gstSimPlantCfg;
+extern stSimPlant_t    gstSimPlant;
+
+void     simPlantInit();
+void     simPlantStep(double dTimeS, double dDtS, const double* pdFanDuty, uint8_t ubyHtrOnMask);
+uint16_t simPlantAdcSample(uint8_t ubyAdcCh);
+double   simPlantRandUniform();
+
+#endif /* SIM_PLANT_H_ */
@@ -0,0 +1,267 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <msp430.h>
+#include <string.h>
+#include "config.h"
+#include "main.h"
+#include "timer.h"
+#include "uart.h"
+#include "adc.h"
+#include "fans.h"
+#include "fanhealth.h"
+#include "thermalcontrol.h"
+#include "telemetry.h"
+
+/*
+ * binary telemetry; a status frame every gstTlm.u16PeriodMs on gstTlm.eUart
+ *  (UART_TLM). the frame is ~1/4 of a text diag line and takes no
+ *  sprintf; the values are raw or fixed point. a frame is queued whole or
+ *  dropped and counted; the sequence number shows the host what was lost.
+ *  layout: telemetry.h
+ */
+
+#define TLM_CRC_SEED        (0xFFFF)
+#define TLM_CRC_POLY        (0x1021)
+
+stTlmStatus_t gstTlm =
+{
+    .u16PeriodMs = 0,
+#if UART_TLM_ENABLED
+    .eUart       = UART_TLM
+#else
+    .eUart       = UART_CLI
+#endif
+};
+
+stTimerStruct_t stTlmTmr =
+{
+    .prevTimer      = NULL,
+    .timeoutTickCnt = 100,
+    .counter        = 0,
+    .recurrence     = TIMER_RECURRING,
+    .status         = TIMER_DISABLED,
+    .callback       = tlmCb,
+    .nextTimer      = NULL
+};
+
+
+static inline uint8_t* tlmPutU16(uint8_t* pubyPos, uint16_t u16Val)
+{
+    *pubyPos++ = (uint8_t)u16Val;
+    *pubyPos++ = (uint8_t)(u16Val >> 8);
+    return pubyPos;
+}
+
+
+static inline uint8_t* tlmPutU32(uint8_t* pubyPos, uint32_t u32Val)
+{
+    pubyPos = tlmPutU16(pubyPos, (uint16_t)u32Val);
+    return tlmPutU16(pubyPos, (uint16_t)(u32Val >> 16));
+}
+
+
+/*
+ * tlmCrc16(): CRC-16/CCITT-FALSE. the CRC module takes the bytes bit
+ *  reversed (CRCDIRB) for the msb first result in CRCINIRES.
+ */
+uint16_t tlmCrc16(const uint8_t* pubyData, uint16_t u16Len)
+{
+#if TLM_CRC_HW
+    CRCINIRES = TLM_CRC_SEED;
+    while (u16Len--)
+    {
+        CRCDIRB_L = *pubyData++;
+    }
+
+    return CRCINIRES;
+#else
+    uint16_t u16Crc = TLM_CRC_SEED;
+    uint8_t  ubyBit;
+
+    while (u16Len--)
+    {
+        u16Crc ^= (uint16_t)(*pubyData++) << 8;
+        for (ubyBit=0; ubyBit<8; ubyBit++)
+        {
+            u16Crc = (u16Crc & 0x8000) ? ((u16Crc << 1) ^ TLM_CRC_POLY) : (u16Crc << 1);
+        }
+    }
+
+    return u16Crc;
+#endif
+}
+
+
+/*
+ * tlmCobsEncode(): consistent overhead byte stuffing; pubyOut has no 0x00
+ *  and takes up to u16Len + u16Len / 254 + 1 bytes. the delimiter is not
+ *  added. returns the bytes written.
+ */
+uint16_t tlmCobsEncode(const uint8_t* pubyIn, uint16_t u16Len, uint8_t* pubyOut)
+{
+    uint16_t u16CodeIndx = 0;
+    uint16_t u16OutIndx  = 1;
+    uint8_t  ubyCode     = 1;
+
+    while (u16Len--)
+    {
+        if (*pubyIn == 0)
+        {
+            pubyOut[u16CodeIndx] = ubyCode;
+            u16CodeIndx = u16OutIndx++;
+            ubyCode     = 1;
+        }
+        else
+        {
+            pubyOut[u16OutIndx++] = *pubyIn;
+            if (++ubyCode == 0xFF)
+            {
+                pubyOut[u16CodeIndx] = ubyCode;
+                u16CodeIndx = u16OutIndx++;
+                ubyCode     = 1;
+            }
+        }
+        pubyIn++;
+    }
+    pubyOut[u16CodeIndx] = ubyCode;
+
+    return u16OutIndx;
+}
+
+
+static uint16_t tlmBuildStatus(uint8_t* pubyFrame)
+{
+    uint8_t* pubyPos = pubyFrame;
+    uint8_t  ubyValidMask = 0;
+    uint8_t  ubySelfMask  = 0;
+    uint8_t  ubyIndx;
+    float    fTemp;
+    int16_t  i16Temp;
+
+    *pubyPos++ = TLM_FRAME_STATUS;
+    *pubyPos++ = TLM_STATUS_VER;
+    *pubyPos++ = NUM_FANS;
+    *pubyPos++ = NUM_TEMP_SNSRS;
+    *pubyPos++ = ADC_NUM_OF_CHS_ENABLED;
+    pubyPos = tlmPutU16(pubyPos, gstTlm.u16Seq++);
+    pubyPos = tlmPutU32(pubyPos, TMR_GetUptimeMs());
+
+    for (ubyIndx=0; ubyIndx<NUM_FANS; ubyIndx++)
+    {
+        pubyPos = tlmPutU16(pubyPos, gastFanPwm[ubyIndx].u16TargetPm);
+        pubyPos = tlmPutU16(pubyPos, gastFanPwm[ubyIndx].u16OutPm);
+        pubyPos = tlmPutU16(pubyPos, stFanTach[ubyIndx].u16Rpm);
+        *pubyPos++ = gubyCurrentTz[ubyIndx];
+        *pubyPos++ = gastFanHealth[ubyIndx].ubyState;
+    }
+
+    for (ubyIndx=0; ubyIndx<NUM_TEMP_SNSRS; ubyIndx++)
+    {
+        // 0.01C, saturated; 0 for a TMP1075 without a message (i2c not running)
+        i16Temp = 0;
+        if (isSnsrValid(ubyIndx))
+        {
+            ubyValidMask |= SNSR_MASK(ubyIndx);
+        }
+        if ((ubyIndx < SNSR_TMP1075_FIRST) || (ubyValidMask & SNSR_MASK(ubyIndx)))
+        {
+            fTemp   = getSnsrTemp(ubyIndx) * 100.0f;
+            i16Temp = (fTemp > 32767.0f) ? 32767 : ((fTemp < -32768.0f) ? -32768 : (int16_t)fTemp);
+        }
+        pubyPos = tlmPutU16(pubyPos, (uint16_t)i16Temp);
+    }
+
+    for (ubyIndx=0; ubyIndx<ADC_NUM_OF_CHS_ENABLED; ubyIndx++)
+    {
+        if (gastAdcChServiceTbl[ubyIndx]->bSelfTemp)
+        {
+            ubySelfMask |= SNSR_MASK(SNSR_ADC_FIRST + ubyIndx);
+        }
+    }
+    *pubyPos++ = ubyValidMask;
+    *pubyPos++ = ubySelfMask;
+
+    for (ubyIndx=0; ubyIndx<ADC_NUM_OF_CHS_ENABLED; ubyIndx++)
+    {
+        pubyPos = tlmPutU16(pubyPos, gastAdcChServiceTbl[ubyIndx]->u16AdcChVal);
+    }
+
+    pubyPos = tlmPutU16(pubyPos, gu16HtrDutyPm);
+    *pubyPos++ = gubyHtrOnMask;
+
+    return (uint16_t)(pubyPos - pubyFrame);
+}
+
+
+/*
+ * frame, crc, COBS and a delimiter each side; queued whole or dropped. the
+ *  leading 0x00 ends any cli text sent ahead of the frame, so the text is
+ *  not taken as the start of it.
+ */
+static void tlmSend(uint8_t* pubyFrame, uint16_t u16Len)
+{
+    uint8_t  aubyWire[TLM_WIRE_MAX(TLM_STATUS_LEN)];
+    uint16_t u16Crc = tlmCrc16(pubyFrame, u16Len);
+    uint16_t u16WireLen;
+
+    tlmPutU16(&pubyFrame[u16Len], u16Crc);
+    aubyWire[0] = 0x00;
+    u16WireLen  = 1 + tlmCobsEncode(pubyFrame, u16Len + TLM_CRC_LEN, &aubyWire[1]);
+    aubyWire[u16WireLen++] = 0x00;
+
+    if (UART_write(gstTlm.eUart, UART_STREAM_TLM, (const char*)aubyWire, u16WireLen, true) == u16WireLen)
+    {
+        gstTlm.u32Frames++;
+    }
+    else
+    {
+        gstTlm.u32Dropped++;
+    }
+}
+
+
+uint16_t tlmCb(stTimerStruct_t* myTimer)
+{
+    uint8_t aubyFrame[TLM_STATUS_LEN + TLM_CRC_LEN];
+
+    tlmSend(aubyFrame, tlmBuildStatus(aubyFrame));
+
+    return 0;
+}
+
+
+/*
+ * tlmStart(): status frames every u16PeriodMs on eUart; restarts if on.
+ *  binary frames on the cli uart are for boards without UART_TLM pins;
+ *  each frame is delimited both sides and the decoder skips the text
+ *  between them.
+ */
+bool tlmStart(eUartNum_t eUart, uint16_t u16PeriodMs)
+{
+    if ((u16PeriodMs < TLM_PERIOD_MIN_MS) || !UART_isCfg(eUart))
+    {
+        return false;
+    }
+
+    gstTlm.eUart       = eUart;
+    gstTlm.u16PeriodMs = u16PeriodMs;
+
+    registerTimer(&stTlmTmr);
+    enableDisableTimer(&stTlmTmr, TMR_DISABLE);
+    stTlmTmr.timeoutTickCnt = u16PeriodMs;
+    stTlmTmr.recurrence     = TIMER_RECURRING;
+    enableDisableTimer(&stTlmTmr, TMR_ENABLE);
+
+    return true;
+}
+
+
+void tlmStop(void)
+{
+    enableDisableTimer(&stTlmTmr, TMR_DISABLE);
+    gstTlm.u16PeriodMs = 0;
+}
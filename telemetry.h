@@ -0,0 +1,59 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "timer_utilities.h"
+#include "uart.h"
+#include "thermalcontrol.h"
+
+/*
+ * binary telemetry frame; little endian, fixed layout for a build.
+ *  on the wire: 0x00 COBS(frame | crc16) 0x00
+ *   crc16: CRC-16/CCITT-FALSE (0x1021, seed 0xFFFF) over the frame
+ *
+ *  TLM_FRAME_STATUS, version TLM_STATUS_VER:
+ *   u8  type; u8 ver; u8 fans; u8 snsrs; u8 adc chs
+ *   u16 seq; u32 uptime ms
+ *   per fan:    u16 target duty pm; u16 output duty pm; u16 rpm; u8 zone; u8 health
+ *   per sensor: i16 temp 0.01C
+ *   u8  valid sensor mask; u8 self heated sensor mask (ADC)
+ *   per adc ch: u16 raw
+ *   u16 heater duty pm; u8 heater on mask
+ *  tools/tlmdecode decodes it.
+ */
+#define TLM_FRAME_STATUS        (0x01)
+#define TLM_STATUS_VER          (1)
+
+#define TLM_STATUS_LEN          (5 + 2 + 4 + (8 * NUM_FANS) + (2 * NUM_TEMP_SNSRS) + 2 + \
+                                 (2 * ADC_NUM_OF_CHS_ENABLED) + 3)
+#define TLM_CRC_LEN             (2)
+// COBS adds a byte per 254 and the code byte; a 0x00 delimiter each side
+#define TLM_WIRE_MAX(len)       ((len) + TLM_CRC_LEN + (((len) + TLM_CRC_LEN) / 254) + 3)
+
+typedef struct TLM_STATUS
+{
+    uint16_t   u16PeriodMs;     // 0 => off
+    eUartNum_t eUart;
+    uint16_t   u16Seq;
+    uint32_t   u32Frames;       // queued whole
+    uint32_t   u32Dropped;      // did not fit the output buffer
+}stTlmStatus_t;
+
+extern stTlmStatus_t   gstTlm;
+extern stTimerStruct_t stTlmTmr;
+
+bool tlmStart(eUartNum_t eUart, uint16_t u16PeriodMs);
+void tlmStop(void);
+uint16_t tlmCb(stTimerStruct_t* myTimer);
+uint16_t tlmCrc16(const uint8_t* pubyData, uint16_t u16Len);
+uint16_t tlmCobsEncode(const uint8_t* pubyIn, uint16_t u16Len, uint8_t* pubyOut);
+
+#endif /* TELEMETRY_H_ */
@@ -14,6 +14,8 @@
 #include "timer.h"
 #include "adc.h"
 #include "rtd.h"
+#include "fanhealth.h"
+#include "power.h"
 
 /*
  * Since DEMEC7040SYS-02 only has cooling capability ONLY, no heat,
@@ -37,10 +39,21 @@
                                   45.0, 50.0,
                                   50.0, 999.9};
 
+/*
+ * fan rows depend on NUM_FANS; both are loaded with their defaults in
+ *  initThermalControl() when the persistent memory is initialized.
+ */
 #pragma PERSISTENT(fFanPwm)
-     uint8_t fFanPwm[NUM_FANS][NUM_TZONES] =
-                                 {20, 30, 35, 45, 50, 55, 60, 100,  // CPU fan
-                                  20, 30, 35, 45, 50, 55, 60, 100}; // GPU fan
+     uint8_t fFanPwm[NUM_FANS][NUM_TZONES] = {0};
+
+/*
+ * sensor to fan mapping; each fan demand is computed from a set of sensors.
+ * defaults from gastFanDesc[] keep the DEMEC7040SYS-02 wiring:
+ *   Fan0 (PWM5/CCR1) <= RTD5 (CPU)
+ *   Fan1 (PWM4/CCR2) <= RTD4 (GPU)
+ */
+#pragma PERSISTENT(astFanSnsrMap)
+     stFanSnsrMap_t astFanSnsrMap[NUM_FANS] = {0};
 
 #pragma PERSISTENT(ubyTempHysteresis)
      uint8_t ubyTempHysteresis = FAN_HYSTERISIS_TEMP;
@@ -53,44 +66,77 @@
 
 // ---------------------- end of vars in flash
 
-bool   gbEnableTempCycleTest = false;
-bool   bTempSetAsscending    = true;
-int8_t gbyTestTemperatureVal;          // this is for debugging PWM Cycling
-static uint8_t ubyHeaterNum  = 0;
-
-// ---------------------- Heater On Timer
+// ---------------------- Heater Drive Timer
 /*
- * this timer is used to stagger or sequence heater turning on action.
- * idea is to minimize in rush current.
+ * time proportional heater drive; see htrTpCb().
+ * replaces the heater on sequencing; interleaving the heater on times
+ *  keeps the in rush current and the total heater current bounded.
  */
-stTimerStruct_t stHeaterOntTmr =
+#if (HTR_TP_SLOTS % NUM_HEATERS)
+#error HTR_TP_SLOTS must be a multiple of NUM_HEATERS
+#endif
+#define HTR_TP_PHASE_SLOTS      (HTR_TP_SLOTS / NUM_HEATERS)    // heater n starts n phases in
+#define HTR_PI_SCALE            (100)                           // error in 0.01C
+
+stTimerStruct_t stHeaterTpTmr =
 {
     .prevTimer        = NULL,
-    .timeoutTickCnt   = HEATER_ON_INTERVAL_MS,
+    .timeoutTickCnt   = HTR_TP_TICK_MS,
     .counter          = 0,
     .recurrence       = TIMER_RECURRING,
     .status           = TIMER_DISABLED,
-    .callback         = htrOnCb,
+    .callback         = htrTpCb,
     .nextTimer        = NULL
 };
 
+uint16_t gu16HtrDutyPm;                 // heater duty (0.1%), PI output
+uint8_t gubyHtrOnMask;                  // heaters on; bit n => heater n
+static int32_t i32HtrPiInteg;           // PI integral; duty scaled by HTR_PI_SCALE
+static uint8_t ubyHtrSlot;              // slot of the window
+
+// P2.5 to P2.0
+const stHeaterDesc_t gastHeaterDesc[NUM_HEATERS] =
+{
+    {&P2OUT, &P2DIR, &P2SEL0, &P2SEL1, BIT5},       // HTR_CTRL0
+    {&P2OUT, &P2DIR, &P2SEL0, &P2SEL1, BIT4},       // HTR_CTRL1
+    {&P2OUT, &P2DIR, &P2SEL0, &P2SEL1, BIT3},       // HTR_CTRL2
+    {&P2OUT, &P2DIR, &P2SEL0, &P2SEL1, BIT2},       // HTR_CTRL3
+    {&P2OUT, &P2DIR, &P2SEL0, &P2SEL1, BIT1},       // HTR_CTRL4
+    {&P2OUT, &P2DIR, &P2SEL0, &P2SEL1, BIT0}        // HTR_CTRL5
+};
+
 
 bool    bAllHeatersOn = false;
-bool    bHeaterTmrOnStatus = false;
 bool    bIsThermalControlled;
 // gubyCurrentTz[Fan0-TZ, Fan1-Tz, Fan2-Tz, Fan3-Tz, Fan4-Tz, Fan5-Tz]
 uint8_t gubyCurrentTz[NUM_FANS];
+// demand temperature of each fan, computed from astFanSnsrMap[]
+float   gafFanDemandTemp[NUM_FANS];
 //uint8_t ubyPreviousTz[NUM_FANS];
-uint8_t gubyPwmInTest;           // used for selecting PWM under test when testing
 
 
 void initThermalControl()
 {
+    uint8_t ubyFanIndx;
+#if HTR_ENABLED
+    uint8_t ubyHtrIndx;
+#endif
     bIsThermalControlled = false;
 
+#if HTR_ENABLED
+    // heater pins; gpio, low (off), output
+    for(ubyHtrIndx=0; ubyHtrIndx<NUM_HEATERS; ubyHtrIndx++)
+    {
+        *gastHeaterDesc[ubyHtrIndx].pubyPortSel0 &= ~gastHeaterDesc[ubyHtrIndx].ubyPin;
+        *gastHeaterDesc[ubyHtrIndx].pubyPortSel1 &= ~gastHeaterDesc[ubyHtrIndx].ubyPin;
+        *gastHeaterDesc[ubyHtrIndx].pubyPortOut  &= ~gastHeaterDesc[ubyHtrIndx].ubyPin;
+        *gastHeaterDesc[ubyHtrIndx].pubyPortDir  |=  gastHeaterDesc[ubyHtrIndx].ubyPin;
+    }
+#else
     // heater is not used by DEMEC7040SYS so need of configuring the port
     // however, the voltage divider used for simulation requires port 2.1
     P2DIR |= BIT1;
+#endif
 
     if (persistentMemoryInitialized != 0xBEEF)
     {
@@ -108,17 +154,25 @@ void initThermalControl()
         /*
          * ROW 0 <=> Fan5(PWM5) <=> ACH5 <=> CPU (Tandem two fans): PWM5 - CCR1, TACH5 - P4.0
          * ROW 1 <=> Fan4(PWM4) <=> ACH4 <=> GPU (single fan)     : PWM4 - CCR2, TACH4 - P4.1
+         * ROW n <=> see gastFanDesc[n]
          */
-        // fan pwm allocations
-        uint8_t fFanPwmInit[NUM_FANS][NUM_TZONES] =
-                                    {20, 30, 35, 45, 50, 55, 60, 100,  // CPU fan
-                                     20, 30, 35, 45, 50, 55, 60, 100}; // GPU fan
+        // fan pwm allocations; same zone pwms for each fan
+        uint8_t fFanPwmInit[NUM_TZONES] = {20, 30, 35, 45, 50, 55, 60, 100};
 
         ubyTempHysteresis = FAN_HYSTERISIS_TEMP;
         gbyTmpRangeMax    = MAX_TMP_VALUE_EXPECTED;
         gbyTmpRangeMin    = MIN_TMP_VALUE_EXPECTED;
-        memcpy (&fFanPwm, &fFanPwmInit, sizeof(fFanPwm));
         memcpy (&fTz,     &fTzInit,     sizeof(fTz));
+        for(ubyFanIndx=0; ubyFanIndx<NUM_FANS; ubyFanIndx++)
+        {
+            memcpy (&fFanPwm[ubyFanIndx], &fFanPwmInit, sizeof(fFanPwmInit));
+
+            // sensor to fan allocations
+            memset (&astFanSnsrMap[ubyFanIndx], 0, sizeof(stFanSnsrMap_t));
+            astFanSnsrMap[ubyFanIndx].ubySnsrMask = gastFanDesc[ubyFanIndx].ubyDefSnsrMask;
+            astFanSnsrMap[ubyFanIndx].ubyMethod   = FAN_DEMAND_MAX;
+        }
+        fanHealthLoadDefaults();
     }
 }
 
@@ -128,27 +182,27 @@ void startThermalControl()
     findTz();
     setPwmFromTz();
 
+#if HTR_ENABLED
+    if (stHeaterTpTmr.status == TIMER_DISABLED)
+    {
+        registerTimer(&stHeaterTpTmr);
+        enableDisableTimer(&stHeaterTpTmr, TMR_ENABLE);
+    }
+#endif
+
     bIsThermalControlled = true;
 }
 
 
-void processThermalControl()
+/*
+ * ubySnsrIndx is the sensor (see SNSR_xxx) whose sample has just been
+ *  transformed. only the fans mapped to that sensor are re-evaluated.
+ */
+void processThermalControl(uint8_t ubySnsrIndx)
 {
-    /*
-     * gbEnableTempCycleTest is controlled from command line interface.
-     * setting this flag to 'true' will cycle through temperatures
-     *  between -40 and 90 affecting fan, power control, atx enable
-     *  control, ...
-     */
-    if(gbEnableTempCycleTest)
-    {
-        forceTempVal();
-    }
-
-
     if(bIsThermalControlled)
     {
-        updateTz();
+        updateFanDemand(ubySnsrIndx);
         __no_operation();
     }
     else
@@ -158,278 +212,289 @@ void processThermalControl()
 }
 
 
-void forceTempVal()
+void findTz()
 {
-    static bool bAssendOnce = false;
-    static bool bDesendOnce = false;
-    static uint8_t ubyDelayCnt;
-
-
-    /*
-     * cycle temp values from MIN_TEST_TEMPERATURE to MIN_TEST_TEMPERATURE
-     *  used for debugging/testing
-     */
+    unsigned char ubyFanIndex;
+    unsigned char ubyZoneIndex;
 
-    // since this is a post increment, it will be true every other cycle
-    if(ubyDelayCnt++)       // delay force temperature update
+    for(ubyFanIndex=0; ubyFanIndex<NUM_FANS; ubyFanIndex++)
     {
-        if (bTempSetAsscending)
-        {
-            gbyTestTemperatureVal++;
-        }
-        else
+        gafFanDemandTemp[ubyFanIndex] = computeFanDemand(ubyFanIndex);
+
+        for(ubyZoneIndex=0; ubyZoneIndex<NUM_TZONES; ubyZoneIndex++)
         {
-            gbyTestTemperatureVal--;
+            if((gafFanDemandTemp[ubyFanIndex] > fTz[ubyZoneIndex][0] && (gafFanDemandTemp[ubyFanIndex] <= fTz[ubyZoneIndex][1])))
+            {
+                gubyCurrentTz[ubyFanIndex] = ubyZoneIndex;
+                break;
+            }
         }
-        ubyDelayCnt = 0;
-    }
+     }
+}
+
 
+/*
+ * getSnsrTemp(): latest temperature of a sensor
+ *  ADC sources are read from gastAdcChServiceTbl[],
+ *  TMP1075 sources from pastTmp1075I2cMsgTable[]; the internal
+ *  temperature while the message is not loaded (I2C not running).
+ */
+float getSnsrTemp(uint8_t ubySnsrIndx)
+{
+    stI2cTrasaction_t* pstMsg;
 
-    // clip temperature when outside range
-    if(gbyTestTemperatureVal > MAX_TEST_TEMPERATURE)
+    if(ubySnsrIndx < SNSR_TMP1075_FIRST)
     {
-        gbyTestTemperatureVal = MAX_TEST_TEMPERATURE;
+        return gastAdcChServiceTbl[ubySnsrIndx - SNSR_ADC_FIRST]->fAdcXformVal;
     }
-    else if(gbyTestTemperatureVal < MIN_TEST_TEMPERATURE)
+
+    pstMsg = pastTmp1075I2cMsgTable[ubySnsrIndx - SNSR_TMP1075_FIRST];
+    if(pstMsg == NULL)
     {
-        gbyTestTemperatureVal = MIN_TEST_TEMPERATURE;
+        return stAdcChA12.fAdcXformVal;
     }
 
-    gfRtdTempAvg                                     = gbyTestTemperatureVal;
-    gastAdcChServiceTbl[gubyPwmInTest]->fAdcXformVal = gbyTestTemperatureVal;
+    return pstMsg->fI2cRead1stValueSave;
+}
 
-    if((gbyTestTemperatureVal >= MAX_TEST_TEMPERATURE) && (bTempSetAsscending == true))      // increment temp until reaching Max temp
-    {
-        bTempSetAsscending = false;     // reverse direction
-        bAssendOnce        = true;
-    }
-    // caution, bDescendOnce will be set to true at the start of test if '<=' comparison is used
-    else if((gbyTestTemperatureVal  <= MIN_TEST_TEMPERATURE) && (bTempSetAsscending == false)) // decrement temp until reaching Min temp
-    {
-        bTempSetAsscending = true;      // reverse direction; start counting up
-        bDesendOnce        = true;
-    }
 
-    if (bAssendOnce && bDesendOnce)     // check if need to test next PWM
+/*
+ * isSnsrValid(): tells if a sensor holds a measured temperature.
+ *  - an RTD out of range is replaced with the internal temperature
+ *    (bSelfTemp = false), so it is not considered valid.
+ *  - a TMP1075 sensor is valid once its message is loaded, i.e. I2C is running.
+ */
+bool isSnsrValid(uint8_t ubySnsrIndx)
+{
+    stAdcSnsrData_t* pstAdcCh;
+
+    if(ubySnsrIndx < SNSR_TMP1075_FIRST)
     {
-        gubyPwmInTest++;
-        bAssendOnce = false;
-        bDesendOnce = false;
-        if (gubyPwmInTest > NUM_FANS)
-        {
-            /*
-             * for development, run test continuously.
-             * when release, in case used for production testing, halt after 1 round of test.
-             * comment/UNcomment #define ONE_ROUND_TEST to enable/DISable one time test respectively
-             * for a release version, UNcomment the #define below
-             */
-#define ONE_ROUND_TEST  // for release firmware this #define should be UNcommented
-#ifdef  ONE_ROUND_TEST
-            gbEnableTempCycleTest = false;
-            gubyPwmInTest = 1;          // re-init if test is re-invoked
-#else
-            gubyPwmInTest = 1;
-#endif
-        }
+        pstAdcCh = gastAdcChServiceTbl[ubySnsrIndx - SNSR_ADC_FIRST];
+        return (pstAdcCh->ubyChNum == ADC_ON_CHIP_TMP_SNSR) || pstAdcCh->bSelfTemp;
     }
 
-    __no_operation();
+    return (pastTmp1075I2cMsgTable[ubySnsrIndx - SNSR_TMP1075_FIRST] != NULL);
 }
 
 
-void findTz()
+/*
+ * computeFanDemand(): fan demand temperature from its mapped sensors
+ *
+ * FAN_DEMAND_MAX:           hottest valid mapped sensor
+ * FAN_DEMAND_WEIGHTED_MEAN: sum(w[n] * T[n]) / sum(w[n]) of valid mapped sensors
+ * FAN_DEMAND_PRIORITY:      valid mapped sensor with the lowest rank, w[n]
+ *
+ * invalid sensors are skipped; a fan with no valid mapped sensor demands
+ *  the internal temperature.
+ */
+float computeFanDemand(uint8_t ubyFanIndx)
 {
-    unsigned char ubyFanIndex;
-    unsigned char ubyZoneIndex;
-
-    // Fan Index pertains only to external fans
-    // if internal temperature sensor is read first, take care of the fan indexing
-    // every where gastAdcChServiceTbl is referenced, increment fan index value
-    for(ubyFanIndex=0; ubyFanIndex<NUM_FANS; ubyFanIndex++)
+    stFanSnsrMap_t* pstMap = &astFanSnsrMap[ubyFanIndx];
+    uint8_t ubySnsrIndx;
+    uint8_t ubyBestRank    = 0xFF;
+    bool    bFound         = false;
+    float   fSnsrTemp;
+    float   fDemand        = 0;
+    float   fWeightSum     = 0;
+
+    for(ubySnsrIndx=0; ubySnsrIndx<NUM_TEMP_SNSRS; ubySnsrIndx++)
     {
-        for(ubyZoneIndex=0; ubyZoneIndex<NUM_TZONES; ubyZoneIndex++)
+        if(!(pstMap->ubySnsrMask & SNSR_MASK(ubySnsrIndx)) || !isSnsrValid(ubySnsrIndx))
         {
-            if((gastAdcChServiceTbl[ubyFanIndex+1]->fAdcXformVal > fTz[ubyZoneIndex][0] && (gastAdcChServiceTbl[ubyFanIndex+1]->fAdcXformVal <= fTz[ubyZoneIndex][1])))
+            continue;
+        }
+
+        fSnsrTemp = getSnsrTemp(ubySnsrIndx);
+
+        switch(pstMap->ubyMethod)
+        {
+        default:
+        case FAN_DEMAND_MAX:
+            if(!bFound || (fSnsrTemp > fDemand))
             {
-                gubyCurrentTz[ubyFanIndex] = ubyZoneIndex;
-                break;
+                fDemand = fSnsrTemp;
             }
-        }
-     }
-}
+            break;
 
+        case FAN_DEMAND_WEIGHTED_MEAN:
+            fDemand    += fSnsrTemp * pstMap->aubyWeight[ubySnsrIndx];
+            fWeightSum += pstMap->aubyWeight[ubySnsrIndx];
+            break;
 
-#if 1
-unsigned char ubyFanIndex;
-// this version of updateTz(), updates one fan at a time
-void updateTz()
-{
+        case FAN_DEMAND_PRIORITY:
+            if(!bFound || (pstMap->aubyWeight[ubySnsrIndx] < ubyBestRank))
+            {
+                ubyBestRank = pstMap->aubyWeight[ubySnsrIndx];
+                fDemand     = fSnsrTemp;
+            }
+            break;
+        }
+        bFound = true;
+    }
 
-    ubyFanIndex = pgstAdcChActive->ubyFanIndex;
+    if(!bFound)
+    {
+        return stAdcChA12.fAdcXformVal;
+    }
 
-    if (pgstAdcChActive->fAdcXformVal > fTz[gubyCurrentTz[ubyFanIndex]][TZX_HIGH] + ubyTempHysteresis)
+    if(pstMap->ubyMethod == FAN_DEMAND_WEIGHTED_MEAN)
     {
-        if(gubyCurrentTz[ubyFanIndex] < (NUM_TZONES-1))
+        // all weights 0 => plain mean is not defined; fall back to the internal sensor
+        if(fWeightSum == 0)
         {
-            gubyCurrentTz[ubyFanIndex]++;
+            return stAdcChA12.fAdcXformVal;
         }
+        fDemand /= fWeightSum;
+    }
+
+    return fDemand;
+}
+
+
+/*
+ * updateFanDemand(): called each time a sensor sample is transformed.
+ *  only the fans that have the sensor in their set are re-evaluated.
+ */
+void updateFanDemand(uint8_t ubySnsrIndx)
+{
+    uint8_t ubyFanIndx;
+
+    if(!bIsThermalControlled)
+    {
+        return;
     }
-    else if (pgstAdcChActive->fAdcXformVal < fTz[gubyCurrentTz[ubyFanIndex]][TZX_LOW] - ubyTempHysteresis)
+
+    for(ubyFanIndx=0; ubyFanIndx<NUM_FANS; ubyFanIndx++)
     {
-        if(gubyCurrentTz[ubyFanIndex])
+        if(astFanSnsrMap[ubyFanIndx].ubySnsrMask & SNSR_MASK(ubySnsrIndx))
         {
-            gubyCurrentTz[ubyFanIndex]--;
+            gafFanDemandTemp[ubyFanIndx] = computeFanDemand(ubyFanIndx);
+            updateTz(ubyFanIndx);
         }
     }
-
-    setSinglePwmFromTz(pgstAdcChActive->ubyPwmNum);
 }
 
-#else
 
-// this version of updateTz(), updates all fans when for every sample
-void updateTz()
+// updates the zone of a single fan from its demand temperature; the pwm of
+//  the zone is the new target of the fan pwm engine (fanPwmEngineCb())
+void updateTz(uint8_t ubyFanIndex)
 {
-    unsigned char ubyFanIndex;
-
-    for(ubyFanIndex=0; ubyFanIndex<NUM_FANS; ubyFanIndex++)
+    if (gafFanDemandTemp[ubyFanIndex] > fTz[gubyCurrentTz[ubyFanIndex]][TZX_HIGH] + ubyTempHysteresis)
     {
-        if (gastAdcChServiceTbl[ubyFanIndex]->fAdcXformVal > fTz[gubyCurrentTz[ubyFanIndex]][TZX_HIGH] + ubyTempHysteresis)
+        if(gubyCurrentTz[ubyFanIndex] < (NUM_TZONES-1))
         {
-            if(gubyCurrentTz[ubyFanIndex] < (NUM_TZONES-1))
-            {
-                gubyCurrentTz[ubyFanIndex]++;
-            }
+            gubyCurrentTz[ubyFanIndex]++;
         }
-        else if (gastAdcChServiceTbl[ubyFanIndex]->fAdcXformVal < fTz[gubyCurrentTz[ubyFanIndex]][TZX_LOW] - ubyTempHysteresis)
+    }
+    else if (gafFanDemandTemp[ubyFanIndex] < fTz[gubyCurrentTz[ubyFanIndex]][TZX_LOW] - ubyTempHysteresis)
+    {
+        if(gubyCurrentTz[ubyFanIndex])
         {
-            if(gubyCurrentTz[ubyFanIndex])
-            {
-                gubyCurrentTz[ubyFanIndex]--;
-            }
+            gubyCurrentTz[ubyFanIndex]--;
         }
     }
 
-    setPwmFromTz();
+    setSinglePwmFromTz(ubyFanIndex);
 }
-#endif
 
 
 void setPwmFromTz()
 {
     unsigned char ubyFanIndx;
-    unsigned char ubyCcrIndx;
 
-    // DEMEC7040SYS uses 2 PWMs (PWM5:CCR1 and PWM4:CCR2)
-    // In this case, CCR Index = Fan Index + 1
-    // based on gastAdcChServiceTbl initialization; Ch5, Ch4 are index 1 and 2
-    // ubyFanIndex = 0, 1 => PWM5 (CCR1 and TACH5=P4.0), PWM4 (CCR2 and TACH4=P4.1)
+    // pwm ccr of each fan from gastFanDesc[]
+    // DEMEC7040SYS: ubyFanIndex = 0, 1 => PWM5 (CCR1 and TACH5=P4.0), PWM4 (CCR2 and TACH4=P4.1)
     for(ubyFanIndx=0; ubyFanIndx<NUM_FANS; ubyFanIndx++)
     {
-        ubyCcrIndx = ubyFanIndx + 1;
-        // uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint8_t ubyPercent
-        TMR_PwmSetPercentage(TMR_B3, ubyCcrIndx, fFanPwm[ubyFanIndx][gubyCurrentTz[ubyFanIndx]]);
+        setSinglePwmFromTz(ubyFanIndx);
     }
 }
 
 
-void setSinglePwmFromTz(uint8_t ubyPwmNum)
+// sets the pwm target of a fan; fan pwm engine ramps the fan to it
+void setSinglePwmFromTz(uint8_t ubyFanIndx)
 {
-    uint8_t ubyCcrNum = 6 - ubyPwmNum;
-    uint8_t ubyFanIndex = pgstAdcChActive->ubyFanIndex;
-
-    //                   (TmrNum,   CcrNum,          Percent)
-    TMR_PwmSetPercentage(TMR_B3, ubyCcrNum, fFanPwm[ubyFanIndex][gubyCurrentTz[ubyFanIndex]]);
+    // zone pwm, unless fan health overrides it (boost)
+    fanPwmSetTarget(ubyFanIndx,
+                    fanHealthDutyOverride(ubyFanIndx, fFanPwm[ubyFanIndx][gubyCurrentTz[ubyFanIndx]] * 10));
 }
 
 
-uint16_t htrOnCb(stTimerStruct_t* myTimer)
-{
-    if (gbIsHtrOn)
-    {
-        turnHeaterOnOff(ubyHeaterNum, ON);
 
-        if (++ubyHeaterNum > 5)
-        {
-             ubyHeaterNum = 0;
-             gstMainEvts.bits.svcHtrTmr = true;
-        }
-    }
-    return 0;
-}
-
-
-void turnHeaterOnOff(uint8_t ubyHtrNum, bool bOnOff)
+/*
+ * htrWriteMask(): switches the heaters in ubyHtrMask to the state of their
+ *  bit in ubyHtrOn; the others are left as they are. one port write per
+ *  port of the set.
+ */
+void htrWriteMask(uint8_t ubyHtrMask, uint8_t ubyHtrOn)
 {
-    switch(ubyHtrNum)
-    {
-    case 0:
-        HTR_CTRL0(bOnOff);
-        break;
-
-    case 1:
-        HTR_CTRL1(bOnOff);
-        break;
-
-    case 2:
-        HTR_CTRL2(bOnOff);
-        break;
+    volatile uint8_t*   pubyPortOut = NULL;
+    uint8_t             ubySetPins  = 0;
+    uint8_t             ubyClrPins  = 0;
+    uint8_t             ubyHtrIndx;
 
-    case 3:
-        HTR_CTRL3(bOnOff);
-        break;
+    ubyHtrMask &= HTR_MASK_ALL;
 
-    case 4:
-        HTR_CTRL4(bOnOff);
-        break;
-
-    case 5:
-        HTR_CTRL5(bOnOff);
-        if(bOnOff)
+    for(ubyHtrIndx=0; ubyHtrIndx<NUM_HEATERS; ubyHtrIndx++)
+    {
+        if((ubyHtrMask & HTR_MASK(ubyHtrIndx)) == 0)
         {
-            bAllHeatersOn = true;
+            continue;
         }
-        else
+
+        if(gastHeaterDesc[ubyHtrIndx].pubyPortOut != pubyPortOut)
         {
-            bAllHeatersOn = false;
+            if(pubyPortOut != NULL)
+            {
+                *pubyPortOut = (*pubyPortOut & ~ubyClrPins) | ubySetPins;
+            }
+            pubyPortOut = gastHeaterDesc[ubyHtrIndx].pubyPortOut;
+            ubySetPins  = 0;
+            ubyClrPins  = 0;
         }
-        break;
 
-    case HTR_ALL_ON_OFF:
-        HTR_CTRLALL(bOnOff);
-        if(bOnOff)
+        if(ubyHtrOn & HTR_MASK(ubyHtrIndx))
         {
-            bAllHeatersOn = true;
+            ubySetPins |= gastHeaterDesc[ubyHtrIndx].ubyPin;
         }
         else
         {
-            ubyHeaterNum  = 0;      // reset heater on index
-            bAllHeatersOn = false;
+            ubyClrPins |= gastHeaterDesc[ubyHtrIndx].ubyPin;
         }
-        break;
 
-    default:
-        break;
+        // heater current seen by the power budget
+        pwrSetLoadMa(PWR_LOAD_HTR0 + ubyHtrIndx, (ubyHtrOn & HTR_MASK(ubyHtrIndx)) ? PWR_HTR_MA : 0);
     }
-}
 
-void disableHtrTmr()
-{
-    gstMainEvts.bits.svcHtrTmr = false;
-    enableDisableTimer(&stHeaterOntTmr, TMR_DISABLE);
-    deregisterTimer(&stHeaterOntTmr);
-    bHeaterTmrOnStatus         = false;
+    if(pubyPortOut != NULL)
+    {
+        *pubyPortOut = (*pubyPortOut & ~ubyClrPins) | ubySetPins;
+    }
+
+    gubyHtrOnMask = (gubyHtrOnMask & ~ubyHtrMask) | (ubyHtrOn & ubyHtrMask);
+    bAllHeatersOn = (gubyHtrOnMask == HTR_MASK_ALL);
 }
 
-void turnOnHeater()
+
+void turnHeaterOnOff(uint8_t ubyHtrNum, bool bOnOff)
 {
-    if (gbIsHtrOn && (bHeaterTmrOnStatus==false))
+    uint8_t ubyHtrMask;
+
+    if(ubyHtrNum == HTR_ALL_ON_OFF)
+    {
+        ubyHtrMask = HTR_MASK_ALL;
+    }
+    else if(ubyHtrNum < NUM_HEATERS)
     {
-        // enable heater turn-on timer (to insert delay in between heater on actions)
-        registerTimer(&stHeaterOntTmr);
-        enableDisableTimer(&stHeaterOntTmr, TMR_ENABLE);
-        bHeaterTmrOnStatus = true;
+        ubyHtrMask = HTR_MASK(ubyHtrNum);
     }
+    else
+    {
+        return;
+    }
+
+    htrWriteMask(ubyHtrMask, bOnOff ? ubyHtrMask : 0);
 }
 
 void turnOffHeater()
@@ -437,22 +502,116 @@ void turnOffHeater()
     turnHeaterOnOff(HTR_ALL_ON_OFF, OFF);
 }
 
+
+/*
+ * updateHeater(): heater PI loop, once per time proportional window.
+ *  fixed point; error in 0.01C, duty in 0.1%.
+ *  duty = Kp * err + Ki * sum(err); integral held within 0-100% duty
+ */
 void updateHeater()
 {
-    if (gfRtdTempAvg < gbyHtrOnSetPt - ubyTempHysteresis)
+    int32_t i32ErrCentiC;
+    int32_t i32Duty;
+
+    if (!gbIsHtrOn)
+    {
+        gu16HtrDutyPm = 0;
+        i32HtrPiInteg = 0;
+        return;
+    }
+
+    // > 0 => colder than the set point
+    i32ErrCentiC  = (int32_t)gbyHtrOnSetPt * HTR_PI_SCALE - (int32_t)(gfRtdTempAvg * HTR_PI_SCALE);
+
+    i32HtrPiInteg += (int32_t)HTR_PI_KI_PM * i32ErrCentiC;
+    if (i32HtrPiInteg > (int32_t)TMR_PWM_MAX_PER_MILLE * HTR_PI_SCALE)
+    {
+        i32HtrPiInteg = (int32_t)TMR_PWM_MAX_PER_MILLE * HTR_PI_SCALE;
+    }
+    else if (i32HtrPiInteg < 0)
+    {
+        i32HtrPiInteg = 0;
+    }
+
+    i32Duty = ((int32_t)HTR_PI_KP_PM * i32ErrCentiC + i32HtrPiInteg) / HTR_PI_SCALE;
+    if (i32Duty > TMR_PWM_MAX_PER_MILLE)
+    {
+        i32Duty = TMR_PWM_MAX_PER_MILLE;
+    }
+    else if (i32Duty < 0)
+    {
+        i32Duty = 0;
+    }
+    gu16HtrDutyPm = (uint16_t)i32Duty;
+}
+
+
+/*
+ * htrTpCb(): time proportional heater drive, every HTR_TP_TICK_MS.
+ *  each heater is on for u16OnSlots of the HTR_TP_SLOTS window, heater n
+ *  starting n * HTR_TP_PHASE_SLOTS into it. with the on slots capped at
+ *  ubyMaxOn * HTR_TP_PHASE_SLOTS, no more than ubyMaxOn heaters overlap
+ *  in any slot; with the phases apart, heaters start one at a time.
+ */
+uint16_t htrTpCb(stTimerStruct_t* myTimer)
+{
+    uint8_t  ubyHtrIndx;
+    uint8_t  ubyMaxOn;
+    uint16_t u16OnSlots;
+    uint16_t u16Room;
+    uint8_t  ubyPos;
+    uint8_t  ubyHtrWant;                // heaters the window has on
+    uint8_t  ubyHtrGoOn;
+
+    if (ubyHtrSlot == 0)
+    {
+        updateHeater();
+    }
+
+    // heaters allowed on at once: current limit and power budget left
+    ubyMaxOn = HTR_CURRENT_LIMIT_MA / PWR_HTR_MA;
+    u16Room  = pwrGetRoomMa(PWR_LOAD_HTR0, NUM_HEATERS) / PWR_HTR_MA;
+    if (u16Room < ubyMaxOn)
     {
-        if((bAllHeatersOn==false) && (bHeaterTmrOnStatus == false))
+        ubyMaxOn = (uint8_t)u16Room;
+    }
+
+    u16OnSlots = (uint16_t)(((uint32_t)gu16HtrDutyPm * HTR_TP_SLOTS + TMR_PWM_MAX_PER_MILLE/2) / TMR_PWM_MAX_PER_MILLE);
+    if (u16OnSlots > (uint16_t)ubyMaxOn * HTR_TP_PHASE_SLOTS)
+    {
+        u16OnSlots = (uint16_t)ubyMaxOn * HTR_TP_PHASE_SLOTS;
+    }
+
+    ubyHtrWant = 0;
+    for (ubyHtrIndx=0; ubyHtrIndx<NUM_HEATERS; ubyHtrIndx++)
+    {
+        // slot position relative to the heater start
+        ubyPos = (ubyHtrSlot + HTR_TP_SLOTS - ubyHtrIndx * HTR_TP_PHASE_SLOTS) % HTR_TP_SLOTS;
+        if (ubyPos < u16OnSlots)
         {
-            turnOnHeater();
+            ubyHtrWant |= HTR_MASK(ubyHtrIndx);
         }
     }
-    else if (gfRtdTempAvg > gbyHtrOnSetPt + ubyTempHysteresis)
+
+    // heaters going off first; the limit holds in between
+    htrWriteMask(gubyHtrOnMask & ~ubyHtrWant, 0);
+
+    // a heater going on waits for the inrush window; starts late if refused
+    ubyHtrGoOn = 0;
+    for (ubyHtrIndx=0; ubyHtrIndx<NUM_HEATERS; ubyHtrIndx++)
     {
-        if (bAllHeatersOn)
+        if ((ubyHtrWant & ~gubyHtrOnMask & HTR_MASK(ubyHtrIndx)) &&
+            pwrAdmit(PWR_LOAD_HTR0 + ubyHtrIndx, PWR_HTR_MA))
         {
-            turnOffHeater();
+            ubyHtrGoOn |= HTR_MASK(ubyHtrIndx);
         }
     }
+    htrWriteMask(ubyHtrGoOn, ubyHtrGoOn);
 
-}
+    if (++ubyHtrSlot >= HTR_TP_SLOTS)
+    {
+        ubyHtrSlot = 0;
+    }
 
+    return 0;
+}
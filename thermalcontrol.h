@@ -10,7 +10,9 @@
 
 #include <stdint.h>
 #include <msp430.h>
+#include "config.h"
 #include "fans.h"
+#include "tmp1075.h"
 
 #define ON          true
 #define OFF         false
@@ -20,28 +22,61 @@
 #define CLRBIT(p,b) p##OUT &= ~b
 
 #define NUM_TZONES              (8)
-#define NUM_FANS                (2)     // Only PWM4 and PWM5 are to be used to control GPU & CPU Cooling
-
-#define MAX_TEST_TEMPERATURE    70      // to be used when testing fan pwm and temp association
-#define MIN_TEST_TEMPERATURE    0       // to be used when testing fan pwm and temp association
 
 #define LOW_HIGH_LIMIT      (2)
 #define HTR_ALL_ON_OFF      (63)    // 0x3F
+#define HTR_MASK(htr)       (1 << (htr))
+#define HTR_MASK_ALL        (HTR_MASK(NUM_HEATERS) - 1)
+
+/*
+ * heater outputs (HTR_CTRL0 to HTR_CTRL5); a heater set is a bitmap of
+ *  heater numbers. heaters of one port are switched in a single masked
+ *  write; keep heaters of a port next to each other in the table.
+ */
+typedef struct HEATER_DESC
+{
+    volatile uint8_t*   pubyPortOut;    // PxOUT
+    volatile uint8_t*   pubyPortDir;    // PxDIR
+    volatile uint8_t*   pubyPortSel0;   // PxSEL0
+    volatile uint8_t*   pubyPortSel1;   // PxSEL1
+    uint8_t             ubyPin;         // BITn
+}stHeaterDesc_t;
+
+/*
+ * temperature sources a fan demand can be computed from.
+ * ADC sources are indexed the same way as gastAdcChServiceTbl[] and the
+ *  TMP1075 sources follow the pastTmp1075I2cMsgTable[] message order.
+ *
+ * DEMEC7040SYS-02 ADC service table: {Int Snsr, RTD5 (CPU), RTD4 (GPU)}
+ */
+#define SNSR_ADC_FIRST          (0)
+#define SNSR_ON_CHIP_CH12       (SNSR_ADC_FIRST + 0)
+#define SNSR_RTD_CH5_CPU        (SNSR_ADC_FIRST + 1)
+#define SNSR_RTD_CH4_GPU        (SNSR_ADC_FIRST + 2)
+#define SNSR_TMP1075_FIRST      (ADC_NUM_OF_CHS_ENABLED)
+#define NUM_TEMP_SNSRS          (ADC_NUM_OF_CHS_ENABLED + MAX_I2C_TMP1075_MESSAGES)
+#define SNSR_MASK(snsr)         (1 << (snsr))
+
+typedef enum FAN_DEMAND_METHOD
+{
+    FAN_DEMAND_MAX,             // hottest sensor of the set
+    FAN_DEMAND_WEIGHTED_MEAN,   // weighted mean of the set
+    FAN_DEMAND_PRIORITY,        // valid sensor with the lowest rank wins
+    NUM_FAN_DEMAND_METHODS
+}eFanDemandMethod_t;
 
-#define HTR_CTRL0(arg)      if(arg) {SETBIT(P2,BIT5);}  else    {CLRBIT(P2,BIT5);}
-#define HTR_CTRL1(arg)      if(arg) {SETBIT(P2,BIT4);}  else    {CLRBIT(P2,BIT4);}
-#define HTR_CTRL2(arg)      if(arg) {SETBIT(P2,BIT3);}  else    {CLRBIT(P2,BIT3);}
-#define HTR_CTRL3(arg)      if(arg) {SETBIT(P2,BIT2);}  else    {CLRBIT(P2,BIT2);}
-#define HTR_CTRL4(arg)      if(arg) {SETBIT(P2,BIT1);}  else    {CLRBIT(P2,BIT1);}
-#define HTR_CTRL5(arg)      if(arg) {SETBIT(P2,BIT0);}  else    {CLRBIT(P2,BIT0);}
-#define HTR_CTRLALL(arg)    if(arg)                                                 \
-                            {                                                       \
-                                P2OUT |= (BIT5 | BIT4 | BIT3 | BIT2 | BIT1 | BIT0); \
-                            }                                                       \
-                            else                                                    \
-                            {                                                       \
-                                P2OUT &= ~(BIT5 | BIT4 | BIT3 | BIT2 | BIT1 | BIT0);\
-                            }
+/*
+ * a fan's demand temperature is computed from any subset of the sensors.
+ * aubyWeight[] holds the weight of a sensor for the weighted mean and the
+ *  rank (0 = highest priority) of a sensor for the priority method.
+ * it is unused by the max method.
+ */
+typedef struct FAN_SNSR_MAP
+{
+    uint8_t ubySnsrMask;                    // bit n set => sensor n used
+    uint8_t ubyMethod;                      // eFanDemandMethod_t
+    uint8_t aubyWeight[NUM_TEMP_SNSRS];
+}stFanSnsrMap_t;
 
 enum TZ_CONSTS
 {
@@ -59,31 +94,36 @@ enum TZ_CONSTS
 
 extern bool gbIsHtrOn;
 extern bool bAllHeatersOn;
-extern bool bHeaterTmrOnStatus;
-extern stTimerStruct_t stHeaterOntTmr;
+extern bool bIsThermalControlled;
+extern stTimerStruct_t stHeaterTpTmr;
+extern uint16_t gu16HtrDutyPm;
+extern uint8_t gubyHtrOnMask;
+extern const stHeaterDesc_t gastHeaterDesc[NUM_HEATERS];
 
 extern uint8_t  ubyTempHysteresis;
 extern float    fTz[NUM_TZONES][LOW_HIGH_LIMIT];
 extern int8_t   gbyHtrOnSetPt;
-extern bool     gbEnableTempCycleTest;
 extern uint16_t persistentMemoryInitialized;
 extern uint8_t  gubyCurrentTz[];
-extern uint8_t  gubyPwmInTest;
-extern int8_t   gbyTestTemperatureVal;
 extern uint8_t  fFanPwm[NUM_FANS][NUM_TZONES];
+extern stFanSnsrMap_t astFanSnsrMap[NUM_FANS];
+extern float    gafFanDemandTemp[NUM_FANS];
 
 void initThermalControl();
 void findTz();
-void updateTz();
+void updateTz(uint8_t ubyFanIndex);
 void setPwmFromTz();
-void setSinglePwmFromTz(uint8_t ubyPwmNum);
-void processThermalControl();
+void setSinglePwmFromTz(uint8_t ubyFanIndx);
+void processThermalControl(uint8_t ubySnsrIndx);
+void updateFanDemand(uint8_t ubySnsrIndx);
+float getSnsrTemp(uint8_t ubySnsrIndx);
+bool isSnsrValid(uint8_t ubySnsrIndx);
+float computeFanDemand(uint8_t ubyFanIndx);
 
-void turnOnHeater();
-void disableHtrTmr();
 void updateHeater();
 void turnHeaterOnOff(uint8_t ubyHtrNum, bool bOnOff);
-uint16_t htrOnCb(stTimerStruct_t* myTimer);
-void forceTempVal();
+void htrWriteMask(uint8_t ubyHtrMask, uint8_t ubyHtrOn);
+void turnOffHeater();
+uint16_t htrTpCb(stTimerStruct_t* myTimer);
 
 #endif /* THERMALCONTROL_H_ */
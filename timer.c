@@ -10,6 +10,7 @@
 #include <msp430.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 #include <intrinsics.h>
 #include "timer_utilities.h"
@@ -29,6 +30,25 @@ TMR_GrpRegsAddress_t stTickTimerRegsAddress;  // save address; init once
 //
 stTimerXPwmParams_t  stPwmTmrsParams[4];
 
+#if TMR_PWM_NUM_PCT_TABLES
+/*
+ * percent to CCR count tables are handed out to the pwm timers in the order
+ *  they are configured. a timer re-configured for a new period keeps and
+ *  rebuilds its own table.
+ */
+static uint16_t au16PctToCcrCntTbl[TMR_PWM_NUM_PCT_TABLES][TMR_PWM_PCT_TBL_SZ];
+static uint8_t  ubyPctToCcrCntTblsInUse = 0;
+#endif
+
+stCycleBench_t gastCycleBench[NUM_CYCLE_BENCHES];
+// main loop wake ups since the bench reset and the uptime at the reset
+uint32_t gu32BenchWakeCnt;
+uint32_t gu32BenchResetMs;
+// ticks since the ticker started; TMR_TICKER_PERIOD (1 ms) each
+volatile uint32_t gu32UptimeMs = 0;
+
+static uint16_t TMR_PwmPctToCcrCnt(uint8_t ubyTmrNum, uint8_t ubyPercent);
+
 
 /*
  * this is the head timer; this is the only timer that
@@ -230,6 +250,11 @@ void TMR_PwmPrdCfgForTimerBx(uint8_t ubyTmrNum, uint16_t ui16PwmPrdFreq)
     stDevClks_t stClkFreq;
     float fTimerClkPeriod;
     float fPwmPeriod;
+    uint8_t ubyCcrNum;
+#if TMR_PWM_NUM_PCT_TABLES
+    uint8_t ubyPercent;
+#endif
+
 
     // retrieve clock structure (MCLK, SMCLK, ACLK, and REFCLK)
     stClkFreq       = getClockFreq();
@@ -256,6 +281,37 @@ void TMR_PwmPrdCfgForTimerBx(uint8_t ubyTmrNum, uint16_t ui16PwmPrdFreq)
     stPwmTmrsParams[ubyTmrNum].stPwmTimerRegsAddress      = stTimerRegsAddress;
     stPwmTmrsParams[ubyTmrNum].ui16PwmPrdCnt              = uiPeriodCounter;
     stPwmTmrsParams[ubyTmrNum].ui32InvPrdCntScaled        = (uint32_t)((1.0f/uiPeriodCounter)*10000);
+    stPwmTmrsParams[ubyTmrNum].ui32PerMilleToCntScaled    = ((((uint32_t)uiPeriodCounter << 16) + (TMR_PWM_MAX_PER_MILLE/2)) / TMR_PWM_MAX_PER_MILLE);
+    stPwmTmrsParams[ubyTmrNum].ui32CntToPerMilleScaled    = ((((uint32_t)TMR_PWM_MAX_PER_MILLE << 16) + (uiPeriodCounter/2)) / uiPeriodCounter);
+
+    stPwmTmrsParams[ubyTmrNum].ubyNumCcrs                 = (ubyTmrNum == TMR_B3) ? TMR_B3_NUM_CCRS : TMR_BX_NUM_CCRS;
+
+    // period changed; CCRs need to be re-programmed on next duty request
+    for(ubyCcrNum=0; ubyCcrNum<7; ubyCcrNum++)
+    {
+        stPwmTmrsParams[ubyTmrNum].au16LastCcrCnt[ubyCcrNum]   = TMR_CCR_CNT_UNKNOWN;
+        stPwmTmrsParams[ubyTmrNum].au16StagedCcrCnt[ubyCcrNum] = TMR_CCR_CNT_UNKNOWN;
+    }
+    stPwmTmrsParams[ubyTmrNum].ubyStagedCcrMask = 0;
+
+#if TMR_PWM_NUM_PCT_TABLES
+    if((stPwmTmrsParams[ubyTmrNum].pu16PctToCcrCnt == NULL) &&
+       (ubyPctToCcrCntTblsInUse < TMR_PWM_NUM_PCT_TABLES))
+    {
+        stPwmTmrsParams[ubyTmrNum].pu16PctToCcrCnt = au16PctToCcrCntTbl[ubyPctToCcrCntTblsInUse++];
+    }
+
+    // build the table once per period; duty changes become a look up
+    if(stPwmTmrsParams[ubyTmrNum].pu16PctToCcrCnt != NULL)
+    {
+        for(ubyPercent=0; ubyPercent<TMR_PWM_PCT_TBL_SZ; ubyPercent++)
+        {
+            // active low; see TMR_PwmSetPercentage(). rounded to nearest count
+            stPwmTmrsParams[ubyTmrNum].pu16PctToCcrCnt[ubyPercent] = uiPeriodCounter -
+                (uint16_t)((((uint32_t)ubyPercent * uiPeriodCounter) + (TMR_PWM_MAX_PERCENT/2)) / TMR_PWM_MAX_PERCENT);
+        }
+    }
+#endif
 }
 
 
@@ -292,6 +348,11 @@ void TMR_PwmOutModeAndPinMuxforTimberBxAndCcrX(uint8_t ubyTmrNum,
  * TBxCCRs is configured with a Duty Cycle count <= 80
  * calculate duty cycle using integer math since processor is fixed pt
  *  and floating pt calculation is extremely costly.
+ * the count for each percent is pre-computed into a table when the period
+ *  is configured; the formula below is only evaluated when the timer has
+ *  no table. the CCR is not written if the same percent is requested again.
+ * this is a stage + commit of a single channel; use TMR_PwmStagePercentage()
+ *  and TMR_PwmCommitStaged() to change several channels together.
  *
  * (make sure pwm is configured before calling this function)
  *   if you call without configuring, it will do nothing, returns -1
@@ -373,45 +434,353 @@ void TMR_PwmOutModeAndPinMuxforTimberBxAndCcrX(uint8_t ubyTmrNum,
  */
 int16_t TMR_PwmSetPercentage (uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint8_t ubyPercent)
 {
-    int32_t i32DutyCycleCnt;
-    uint32_t ui16PeriodMinusDutyCycle;
+    if (TMR_PwmStagePercentage(ubyTmrNum, ubyCcrNum, ubyPercent) != 0)
+    {
+        return -1;
+    }
 
-    uint32_t ui32PwmPrdInvScaled;
+    return TMR_PwmCommitStaged(ubyTmrNum);
+}
 
-    TMR_GrpRegsAddress_t stTimerAddresses;
 
-    // get stored inverted and scaled value when pwm was being configured.
-    ui32PwmPrdInvScaled = stPwmTmrsParams[ubyTmrNum].ui32InvPrdCntScaled;
+/*
+ * TMR_PwmSetPerMille()/TMR_PwmSetDutyCnt(): stage + commit of a single channel
+ *  in 0.1% steps or in timer counts; see TMR_PwmStagePerMille() and
+ *  TMR_PwmStageDutyCnt().
+ */
+int16_t TMR_PwmSetPerMille(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint16_t u16PerMille)
+{
+    if (TMR_PwmStagePerMille(ubyTmrNum, ubyCcrNum, u16PerMille) != 0)
+    {
+        return -1;
+    }
+
+    return TMR_PwmCommitStaged(ubyTmrNum);
+}
+
+
+int16_t TMR_PwmSetDutyCnt(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint16_t u16DutyCnt)
+{
+    if (TMR_PwmStageDutyCnt(ubyTmrNum, ubyCcrNum, u16DutyCnt) != 0)
+    {
+        return -1;
+    }
+
+    return TMR_PwmCommitStaged(ubyTmrNum);
+}
 
+
+/*
+ * TMR_PwmCfgLatchedUpdates(): duty changes take effect on a period boundary
+ * input: Timer
+ * output: none
+ *
+ * Prerequisite:
+ *  call after TMR_PwmPrdCfgForTimerBx(); configuring the period re-writes
+ *   TBxCTL and brings the timer back to immediate CCR loading.
+ *
+ * by default a TBxCCRn write is loaded into the compare latch TBxCLn right
+ *  away. a write landing mid-period can cut the current pulse short (runt
+ *  pulse). here every CCRn (n>0) is set to load its latch when TBxR counts
+ *  to 0 (CLLD=1), and the latches are grouped (TBCLGRP) so a group is only
+ *  loaded after all of its TBxCCRn have been written.
+ *  TimerB3_7: CL1+CL2+CL3, CL4+CL5+CL6;  TimerBx_3: CL1+CL2.
+ *  CL0 (the period) is left un-grouped and loads immediately.
+ *
+ * TMR_PwmCommitStaged() writes every CCR of the timer for this reason.
+ */
+void TMR_PwmCfgLatchedUpdates(uint8_t ubyTmrNum)
+{
+    stTimerXPwmParams_t* pstPwmParams = &stPwmTmrsParams[ubyTmrNum];
+    uint16_t uiTimerModeSave;
+    uint8_t  ubyCcrNum;
+
+    if (pstPwmParams->ui32InvPrdCntScaled == 0)
+    {   // the timer referenced is not configured for pwm function
+        return;
+    }
+
+    // TBxCTL shall only be modified while the timer is stopped
+    uiTimerModeSave = TMR_GetTimerOperatingMode(pstPwmParams->stPwmTimerRegsAddress);
+    TMR_SetOperatingMode(pstPwmParams->stPwmTimerRegsAddress, TMR_STOP_MODE);
+
+    *pstPwmParams->stPwmTimerRegsAddress.pTmrCntrl &= ~TBCLGRP;
+    if (pstPwmParams->ubyNumCcrs == TMR_B3_NUM_CCRS)
+    {
+        *pstPwmParams->stPwmTimerRegsAddress.pTmrCntrl |= CTRL_REG_CL_GRP_TRIPLES;
+    }
+    else
+    {
+        *pstPwmParams->stPwmTimerRegsAddress.pTmrCntrl |= CTRL_REG_CL_GRP_PAIRS;
+    }
+
+    for (ubyCcrNum=1; ubyCcrNum<pstPwmParams->ubyNumCcrs; ubyCcrNum++)
+    {
+        *(pstPwmParams->stPwmTimerRegsAddress.pTmrCapCompCntl+ubyCcrNum) &= ~CLLD;
+        *(pstPwmParams->stPwmTimerRegsAddress.pTmrCapCompCntl+ubyCcrNum) |= CC_CNTL_REG_CLLD_ZERO;
+    }
+
+    TMR_SetOperatingMode(pstPwmParams->stPwmTimerRegsAddress, uiTimerModeSave);
+}
+
+
+/*
+ * duty cycle resolution
+ * ^^^^^^^^^^^^^^^^^^^^^
+ * a duty can be requested in three units, all ending up as a TBxCCRn count:
+ *  - percent   (0-100)   TMR_PwmStagePercentage(); table look up
+ *  - per-mille (0-1000)  TMR_PwmStagePerMille();   multiply and shift
+ *  - raw count (0-prd)   TMR_PwmStageDutyCnt();    no conversion
+ * at 25kHz (320 counts) percent uses 101 of the 321 duty steps available;
+ *  per-mille and raw count give the control loop the full resolution.
+ * the duty count is the ON (low) time; TBxCCRn = Period - duty count.
+ *
+ * the duty is remembered in per-mille for cli/diag reporting.
+ */
+
+
+/*
+ * TMR_PwmIsCcrValid(): pwm configured on the timer and CCR is a duty CCR
+ */
+static bool TMR_PwmIsCcrValid(uint8_t ubyTmrNum, uint8_t ubyCcrNum)
+{
     // since this value is the reciprocal of the PWM period, scaled, it should be none 0
-    if (ui32PwmPrdInvScaled == 0)
+    if (stPwmTmrsParams[ubyTmrNum].ui32InvPrdCntScaled == 0)
     {   // the timer referenced is not configured for pwm function
+        return false;
+    }
+
+    // CCR0 holds the period
+    return ((ubyCcrNum != TMR_CCR0) && (ubyCcrNum < stPwmTmrsParams[ubyTmrNum].ubyNumCcrs));
+}
+
+
+/*
+ * TMR_PwmStageCcrCnt(): common end of the stage functions; CCR # is valid
+ */
+static void TMR_PwmStageCcrCnt(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint16_t u16CcrCnt, uint16_t u16PerMille)
+{
+    stTimerXPwmParams_t* pstPwmParams = &stPwmTmrsParams[ubyTmrNum];
+
+    pstPwmParams->u16PerMilleDC[ubyCcrNum] = u16PerMille;
+
+    // control loop requests the same duty on most samples; nothing to do
+    if (pstPwmParams->au16StagedCcrCnt[ubyCcrNum] == u16CcrCnt)
+    {
+        return;
+    }
+
+    pstPwmParams->au16StagedCcrCnt[ubyCcrNum] = u16CcrCnt;
+
+    if (u16CcrCnt != pstPwmParams->au16LastCcrCnt[ubyCcrNum])
+    {
+        pstPwmParams->ubyStagedCcrMask |= (1 << ubyCcrNum);
+    }
+    else
+    {   // staged back to what is programmed
+        pstPwmParams->ubyStagedCcrMask &= ~(1 << ubyCcrNum);
+    }
+}
+
+
+/*
+ * TMR_PwmStagePercentage(): stage a new Duty Cycle % without touching the timer
+ * input: Timer, CCR #, and % for DutyCycle
+ * output: -1 if error (pwm not configured or CCR # not valid)
+ *          0 if good
+ *
+ * stage all channels that need to change, then call TMR_PwmCommitStaged()
+ *  once; all changes are applied together.
+ *
+ * example of usage:
+ *  TMR_PwmStagePercentage(TMR_B3, TMR_CCR1, 75);       // P6.0
+ *  TMR_PwmStagePercentage(TMR_B3, TMR_CCR2, 25);       // P6.1
+ *  TMR_PwmCommitStaged(TMR_B3);
+ */
+int16_t TMR_PwmStagePercentage(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint8_t ubyPercent)
+{
+    uint16_t u16CcrCnt;
+
+    if (!TMR_PwmIsCcrValid(ubyTmrNum, ubyCcrNum))
+    {
         return -1;
     }
 
-    // get data for ease of reducing variable length
-    stTimerAddresses = stPwmTmrsParams[ubyTmrNum].stPwmTimerRegsAddress;
+    if (ubyPercent > TMR_PWM_MAX_PERCENT)
+    {
+        ubyPercent = TMR_PWM_MAX_PERCENT;
+    }
 
-    // compute counter value to load for the requested percentile
-    i32DutyCycleCnt = (int32_t)((ubyPercent * 100) / ui32PwmPrdInvScaled);
+    if (stPwmTmrsParams[ubyTmrNum].pu16PctToCcrCnt != NULL)
+    {
+        u16CcrCnt = stPwmTmrsParams[ubyTmrNum].pu16PctToCcrCnt[ubyPercent];
+    }
+    else
+    {
+        u16CcrCnt = TMR_PwmPctToCcrCnt(ubyTmrNum, ubyPercent);
+    }
+
+    TMR_PwmStageCcrCnt(ubyTmrNum, ubyCcrNum, u16CcrCnt, (uint16_t)ubyPercent * 10);
+
+    return 0;
+}
+
+
+/*
+ * TMR_PwmStagePerMille(): stage a new Duty Cycle in 0.1% steps
+ * input: Timer, CCR #, and DutyCycle in per-mille (0-1000)
+ * output: -1 if error (pwm not configured or CCR # not valid)
+ *          0 if good
+ *
+ * duty count = per-mille * Period/1000; Period/1000 is kept scaled by 2^16
+ *  (ui32PerMilleToCntScaled) so the conversion is a 32 bit multiply (MPY32)
+ *  and a shift, rounded to the nearest count.
+ *
+ * example of usage:
+ *  TMR_PwmStagePerMille(TMR_B3, TMR_CCR1, 455);        // 45.5% P6.0
+ *  TMR_PwmCommitStaged(TMR_B3);
+ */
+int16_t TMR_PwmStagePerMille(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint16_t u16PerMille)
+{
+    stTimerXPwmParams_t* pstPwmParams = &stPwmTmrsParams[ubyTmrNum];
+    uint16_t u16DutyCnt;
+
+    if (!TMR_PwmIsCcrValid(ubyTmrNum, ubyCcrNum))
+    {
+        return -1;
+    }
+
+    if (u16PerMille > TMR_PWM_MAX_PER_MILLE)
+    {
+        u16PerMille = TMR_PWM_MAX_PER_MILLE;
+    }
+
+    u16DutyCnt = (uint16_t)((((uint32_t)u16PerMille * pstPwmParams->ui32PerMilleToCntScaled) + 0x8000) >> 16);
 
     // due to round off, value might go a bit beyond boundaries
-    if (i32DutyCycleCnt > (int32_t)stPwmTmrsParams[ubyTmrNum].ui16PwmPrdCnt)
+    if (u16DutyCnt > pstPwmParams->ui16PwmPrdCnt)
     {
-        i32DutyCycleCnt = (int32_t)stPwmTmrsParams[ubyTmrNum].ui16PwmPrdCnt;
+        u16DutyCnt = pstPwmParams->ui16PwmPrdCnt;
     }
 
-    ui16PeriodMinusDutyCycle = (uint32_t)(stPwmTmrsParams[ubyTmrNum].ui16PwmPrdCnt - i32DutyCycleCnt);
+    TMR_PwmStageCcrCnt(ubyTmrNum, ubyCcrNum, pstPwmParams->ui16PwmPrdCnt - u16DutyCnt, u16PerMille);
 
+    return 0;
+}
 
-    *(stTimerAddresses.pTmrCapCompReg+ubyCcrNum) = ui16PeriodMinusDutyCycle;
 
-    stPwmTmrsParams[ubyTmrNum].ubyPercentageDC[ubyCcrNum] = ubyPercent;
+/*
+ * TMR_PwmStageDutyCnt(): stage a new Duty Cycle in timer counts
+ * input: Timer, CCR #, and DutyCycle ON time in counts (0-Period count)
+ * output: -1 if error (pwm not configured or CCR # not valid)
+ *          0 if good
+ *
+ * finest step available; 1 count = 1/SMCLK (125ns at 8MHz).
+ *  see TMR_PwmGetPrdCnt() for the Period count in use.
+ */
+int16_t TMR_PwmStageDutyCnt(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint16_t u16DutyCnt)
+{
+    stTimerXPwmParams_t* pstPwmParams = &stPwmTmrsParams[ubyTmrNum];
+    uint16_t u16PerMille;
+
+    if (!TMR_PwmIsCcrValid(ubyTmrNum, ubyCcrNum))
+    {
+        return -1;
+    }
+
+    if (u16DutyCnt > pstPwmParams->ui16PwmPrdCnt)
+    {
+        u16DutyCnt = pstPwmParams->ui16PwmPrdCnt;
+    }
+
+    // per-mille for reporting only; 1000/Period kept scaled by 2^16
+    u16PerMille = (uint16_t)((((uint32_t)u16DutyCnt * pstPwmParams->ui32CntToPerMilleScaled) + 0x8000) >> 16);
+
+    TMR_PwmStageCcrCnt(ubyTmrNum, ubyCcrNum, pstPwmParams->ui16PwmPrdCnt - u16DutyCnt, u16PerMille);
 
     return 0;
 }
 
 
+/*
+ * TMR_PwmCommitStaged(): apply all staged duty cycles of a timer at once
+ * input: Timer
+ * output: -1 if error (attempted to modify a pwm that's not configured)
+ *          0 if good
+ *
+ * nothing is written if no staged duty differs from the programmed one.
+ * otherwise every CCRn (n>0) of the timer is written back to back with the
+ *  interrupts held off; un-staged CCRs are written with their own value.
+ *  latched group loading (TMR_PwmCfgLatchedUpdates()) requires each CCR of
+ *  a group to be written before the group loads at the next period start.
+ *  the writes take a few dozen cycles against a 320 count period (25kHz),
+ *  so both TB3 groups normally load on the same boundary.
+ */
+int16_t TMR_PwmCommitStaged(uint8_t ubyTmrNum)
+{
+    stTimerXPwmParams_t* pstPwmParams = &stPwmTmrsParams[ubyTmrNum];
+    volatile uint16_t*   pu16CcrReg;
+    uint16_t u16IntState;
+    uint8_t  ubyCcrNum;
+
+    if (pstPwmParams->ui32InvPrdCntScaled == 0)
+    {   // the timer referenced is not configured for pwm function
+        return -1;
+    }
+
+    if (pstPwmParams->ubyStagedCcrMask == 0)
+    {
+        return 0;
+    }
+
+    pu16CcrReg = pstPwmParams->stPwmTimerRegsAddress.pTmrCapCompReg;
+
+    u16IntState = __get_interrupt_state();
+    __disable_interrupt();
+
+    for (ubyCcrNum=1; ubyCcrNum<pstPwmParams->ubyNumCcrs; ubyCcrNum++)
+    {
+        if (pstPwmParams->au16StagedCcrCnt[ubyCcrNum] != TMR_CCR_CNT_UNKNOWN)
+        {
+            pu16CcrReg[ubyCcrNum] = pstPwmParams->au16StagedCcrCnt[ubyCcrNum];
+        }
+        else
+        {
+            pu16CcrReg[ubyCcrNum] = pu16CcrReg[ubyCcrNum];
+        }
+    }
+
+    __set_interrupt_state(u16IntState);
+
+    memcpy(pstPwmParams->au16LastCcrCnt, pstPwmParams->au16StagedCcrCnt, sizeof(pstPwmParams->au16LastCcrCnt));
+    pstPwmParams->ubyStagedCcrMask = 0;
+
+    return 0;
+}
+
+
+/*
+ * TMR_PwmPctToCcrCnt(): computes the active low TBxCCRx count of a percent
+ *  using integer math (see formula above). only used when the timer has no
+ *  percent to CCR count table; see TMR_PWM_NUM_PCT_TABLES.
+ */
+static uint16_t TMR_PwmPctToCcrCnt(uint8_t ubyTmrNum, uint8_t ubyPercent)
+{
+    int32_t i32DutyCycleCnt;
+
+    // compute counter value to load for the requested percentile
+    i32DutyCycleCnt = (int32_t)((ubyPercent * 100) / stPwmTmrsParams[ubyTmrNum].ui32InvPrdCntScaled);
+
+    // due to round off, value might go a bit beyond boundaries
+    if (i32DutyCycleCnt > (int32_t)stPwmTmrsParams[ubyTmrNum].ui16PwmPrdCnt)
+    {
+        i32DutyCycleCnt = (int32_t)stPwmTmrsParams[ubyTmrNum].ui16PwmPrdCnt;
+    }
+
+    return (uint16_t)(stPwmTmrsParams[ubyTmrNum].ui16PwmPrdCnt - i32DutyCycleCnt);
+}
+
+
 /*
  * getter for cli pwm % request
  */
@@ -422,9 +791,104 @@ int8_t TMR_PwmGetDcPercenatage(uint8_t ubyTmrNum, uint8_t ubyCcrNum)
         return -1;
     }
     else
+    {   // rounded to the nearest %
+        return (int8_t)((stPwmTmrsParams[ubyTmrNum].u16PerMilleDC[ubyCcrNum] + 5) / 10);
+    }
+}
+
+
+/*
+ * getter for cli/diag pwm request in 0.1% steps
+ */
+int16_t TMR_PwmGetDcPerMille(uint8_t ubyTmrNum, uint8_t ubyCcrNum)
+{
+    if (stPwmTmrsParams[ubyTmrNum].ui32InvPrdCntScaled == 0)
+    {   // the timer referenced is not configured for pwm function
+        return -1;
+    }
+    else
+    {
+        return (int16_t)stPwmTmrsParams[ubyTmrNum].u16PerMilleDC[ubyCcrNum];
+    }
+}
+
+
+/*
+ * getter for the period count of a pwm timer; 0 if not configured
+ */
+uint16_t TMR_PwmGetPrdCnt(uint8_t ubyTmrNum)
+{
+    return stPwmTmrsParams[ubyTmrNum].ui16PwmPrdCnt;
+}
+
+
+/*
+ * TMR_BenchStart()/TMR_BenchStop(): cycle benchmark of a code section.
+ *  use CYCLE_BENCH_START(id)/CYCLE_BENCH_STOP(id) so the instrumentation
+ *  compiles out when CYCLE_BENCH_ENABLED is 0.
+ */
+void TMR_BenchStart(uint8_t ubyBenchId)
+{
+    if (ubyBenchId >= BENCH_LONG_FIRST)
+    {
+#if CYCLE_BENCH_LONG_ENABLED
+        gastCycleBench[ubyBenchId].u16Start = TB1R;
+#endif
+        return;
+    }
+    gastCycleBench[ubyBenchId].u16Start = *stTickTimerRegsAddress.pTmrCounter;
+}
+
+
+void TMR_BenchStop(uint8_t ubyBenchId)
+{
+    stCycleBench_t* pstBench = &gastCycleBench[ubyBenchId];
+    uint16_t u16Now = *stTickTimerRegsAddress.pTmrCounter;
+    uint16_t u16Cycles;
+
+    // free running timer; 16 bit differences
+    if (ubyBenchId >= BENCH_LONG_FIRST)
+    {
+#if CYCLE_BENCH_LONG_ENABLED
+        u16Cycles = TB1R - pstBench->u16Start;
+#else
+        return;
+#endif
+    }
+    // ticker runs in up mode; counter rolls over to 0 after reaching CCR0
+    else if (u16Now >= pstBench->u16Start)
+    {
+        u16Cycles = u16Now - pstBench->u16Start;
+    }
+    else
+    {
+        u16Cycles = (*stTickTimerRegsAddress.pTmrCapCompReg - pstBench->u16Start) + u16Now + 1;
+    }
+
+    if ((pstBench->u16Cnt == 0) || (u16Cycles < pstBench->u16Min))
+    {
+        pstBench->u16Min = u16Cycles;
+    }
+    if (u16Cycles > pstBench->u16Max)
+    {
+        pstBench->u16Max = u16Cycles;
+    }
+
+    // stop accumulating before the count wraps; keeps the average valid
+    if (pstBench->u16Cnt < 0xFFFF)
     {
-        return stPwmTmrsParams[ubyTmrNum].ubyPercentageDC[ubyCcrNum];
+        pstBench->u32Sum += u16Cycles;
+        pstBench->u16Cnt++;
     }
+    pstBench->u16Last = u16Cycles;
+}
+
+
+void TMR_BenchReset()
+{
+    memset(gastCycleBench, 0, sizeof(gastCycleBench));
+    gu32BenchWakeCnt = 0;
+    gu32BenchResetMs = TMR_GetUptimeMs();
 }
 
 
@@ -695,6 +1159,8 @@ bool tickTmrIsrHandler()
     stTimerStruct_t* iter = &sTimerQueueHead;
     bool bWakeProcessor = false;
 
+    gu32UptimeMs++;
+
 #ifdef ___DEBUG___
     /*
      * on launch board, port 3.4 was used to validate the tick
@@ -910,3 +1376,157 @@ void __attribute__ ((interrupt(TIMER0_B1_VECTOR))) TIMERB0_B3_TB0IV_ISR (void)
 }
 
 
+
+
+/*
+ * free running time stamp timer
+ * ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+ * TMR_FREE_RUN_TIMER (TimerB1_3) runs in continuous mode from SMCLK/64,
+ *  125kHz (8us per count) at 8MHz. its 16 bit counter is extended to 32 bits
+ *  by counting overflows (TBIFG), so a time stamp wraps after ~9.5 hours.
+ *  used to time stamp fan tach edges; see fans.c.
+ */
+volatile uint16_t gu16FreeRunOvfCnt = 0;
+
+void TMR_CfgFreeRunTimer()
+{
+    TB1EX0 = TBIDEX__8;                                 // ID /8 and IDEX /8 => /64
+    TB1CTL = (CTRL_REG_DATA16_BIT |
+              CTRL_REG_CLK_SMCLK  |
+              CTRL_REG_ID_DIV8    |
+              CTRL_REG_MODE_CONT  |
+              CTRL_REG_CLR_FIELDS |
+              CTRL_REG_INT_ENABLE);                     // TBIFG => overflow count
+}
+
+
+/*
+ * TMR_GetUptimeMs(): ticks (ms) since the ticker started; wraps after
+ *  49 days, use differences only.
+ */
+uint32_t TMR_GetUptimeMs()
+{
+    uint32_t u32Ms;
+    uint16_t u16IntState;
+
+    u16IntState = __get_interrupt_state();
+    __disable_interrupt();
+    u32Ms = gu32UptimeMs;
+    __set_interrupt_state(u16IntState);
+
+    return u32Ms;
+}
+
+
+// free running timer frequency in Hz
+uint32_t TMR_GetFreeRunHz()
+{
+    return getClockFreq().ui32SmclkHz / TMR_FREE_RUN_CLK_DIV;
+}
+
+
+/*
+ * TMR_GetFreeRunTs(): 32 bit time stamp in free running timer counts
+ *
+ * must be called with interrupts disabled (or from an ISR); an overflow
+ *  may have happened since the overflow ISR last ran. if so, TBIFG is still
+ *  pending and the counter has wrapped to a small value.
+ */
+uint32_t TMR_GetFreeRunTs()
+{
+    uint16_t u16Cnt = TB1R;
+    uint16_t u16Ovf = gu16FreeRunOvfCnt;
+
+    if ((TB1CTL & TBIFG) && (u16Cnt < 0x8000))
+    {
+        u16Ovf++;
+    }
+
+    return ((uint32_t)u16Ovf << 16) | u16Cnt;
+}
+
+
+// Timer1_B3 Interrupt Vector (TBIV) handler; free running timer overflow
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector=TIMER1_B1_VECTOR                 // Timer1_B3 @FFF2
+__interrupt void Timer1_B3_TB1IV_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__ ((interrupt(TIMER1_B1_VECTOR))) TIMERB1_B3_TB1IV_ISR (void)
+#else
+#error Compiler not supported!
+#endif
+{
+    switch(__even_in_range(TB1IV,TB1IV_TBIFG))
+    {
+        case TB1IV_TBIFG:
+            gu16FreeRunOvfCnt++;
+            break;
+        default:
+            break;
+    }
+}
+
+
+/*
+ * TMR_CfgExtClkCounter(): use a timer as a pulse counter
+ * input: Timer (TMR_B1 or TMR_B2)
+ * output: none
+ *
+ * the timer is clocked from its TBxCLK pin and runs in continuous mode;
+ *  TBxR counts the rising edges on the pin with no cpu involvement. the
+ *  counter is never cleared; users keep the previous read and take the
+ *  (16 bit, wrap safe) difference.
+ */
+void TMR_CfgExtClkCounter(uint8_t ubyTmrNum)
+{
+    switch(ubyTmrNum)
+    {
+    case TMR_B1:
+        P2DIR  &= ~TMR_B1_CLK_PIN;
+        P2SEL0 |=  TMR_B1_CLK_PIN;
+        P2SEL1 &= ~TMR_B1_CLK_PIN;
+        break;
+
+    case TMR_B2:
+        P5DIR  &= ~TMR_B2_CLK_PIN;
+        P5SEL0 |=  TMR_B2_CLK_PIN;
+        P5SEL1 &= ~TMR_B2_CLK_PIN;
+        break;
+
+    default:
+        return;
+    }
+
+    TMR_GetTmrRegsAddress(ubyTmrNum);
+    *stTimerRegsAddress.pTmrCntrl = (CTRL_REG_DATA16_BIT|
+                                     INPUT_CLK_EXT_PIN  |
+                                     CTRL_REG_ID_DIV1   |
+                                     CTRL_REG_MODE_CONT |
+                                     CTRL_REG_CLR_FIELDS);
+}
+
+
+/*
+ * TMR_ReadExtClkCounter(): pulse count of a timer set by TMR_CfgExtClkCounter()
+ *
+ * TBxR is clocked asynchronous to the cpu; a read while it counts may catch
+ *  the register changing. read until two reads in a row agree.
+ */
+uint16_t TMR_ReadExtClkCounter(uint8_t ubyTmrNum)
+{
+    volatile uint16_t* pu16Counter;
+    uint16_t u16Cnt;
+    uint16_t u16CntPrev;
+
+    TMR_GetTmrRegsAddress(ubyTmrNum);
+    pu16Counter = stTimerRegsAddress.pTmrCounter;
+
+    u16Cnt = *pu16Counter;
+    do
+    {
+        u16CntPrev = u16Cnt;
+        u16Cnt     = *pu16Counter;
+    } while(u16Cnt != u16CntPrev);
+
+    return u16Cnt;
+}
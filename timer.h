@@ -7,6 +7,7 @@
 #define TIMER_H_
 
 #include "timer_utilities.h"
+#include "config.h"
 
 #define INPUT_CLK_EXT_PIN       TBSSEL_0
 #define INPUT_CLK_ACLK          TBSSEL_1
@@ -75,6 +76,13 @@
 #define CC_CNTL_REG_INT_ENABLE  (CCIE)
 #define CC_CNTL_REG_INT_DISABLE (CCIE_0)
 #define CC_CNTL_REG_INT_FLAG    (CCIFG)
+#define CC_CNTL_REG_CLLD_NOW    (CLLD_0)        // TBxCLn loads on TBxCCRn write
+#define CC_CNTL_REG_CLLD_ZERO   (CLLD_1)        // TBxCLn loads when TBxR counts to 0
+
+// Timer Compare Latch Grouping (TBxCTL.TBCLGRP)
+#define CTRL_REG_CL_GRP_NONE    (TBCLGRP_0)     // each TBxCLn loads on its own
+#define CTRL_REG_CL_GRP_PAIRS   (TBCLGRP_1)     // CL1+CL2, CL3+CL4, CL5+CL6
+#define CTRL_REG_CL_GRP_TRIPLES (TBCLGRP_2)     // CL1+CL2+CL3, CL4+CL5+CL6
 
 // Timer B, TIMERB0_3, TIMERB1_3, TIMERB2_3, TIMERB3_7
 #define TMR_B0                  (0)
@@ -95,6 +103,10 @@
 #define TMR_CCR6                (6)
 #define PWM0_CCR6               TMR_CCR6        // fan controller 810405
 
+// # of capture compare regs (CCR0 included); TimerB0_3 to TimerB2_3 and TimerB3_7
+#define TMR_BX_NUM_CCRS         (3)
+#define TMR_B3_NUM_CCRS         (7)
+
 // uded by CLI for pwm get/set commands
 #define tb0                     (TMR_B0)
 #define tb1                     (TMR_B1)
@@ -122,6 +134,26 @@
 
 #define HEARTBEAT_TIME          1000    // delay tick cnt to service HeartBit
 
+/*
+ * Timer external clock inputs (TBxCLK) used as pulse counters; see
+ *  TMR_CfgExtClkCounter(). pin/function select per datasheet port tables;
+ *  TB0CLK (P2.7) and TB3CLK (P6.6) belong to the ticker and pwm timers.
+ */
+#define TMR_B1_CLK_PIN          (BIT2)  // P2.2 TB1CLK, P2SEL[1:0]=01b
+#define TMR_B2_CLK_PIN          (BIT2)  // P5.2 TB2CLK, P5SEL[1:0]=01b
+
+// free running time stamp timer; see TMR_CfgFreeRunTimer()
+#define TMR_FREE_RUN_TIMER      (TMR_B1)
+#define TMR_FREE_RUN_CLK_DIV    (64)    // SMCLK/64 => 125kHz at 8MHz
+
+// max duty cycle % and # of entries of the percent to CCR count table
+#define TMR_PWM_MAX_PERCENT     (100)
+#define TMR_PWM_PCT_TBL_SZ      (TMR_PWM_MAX_PERCENT + 1)
+#define TMR_PWM_MAX_PER_MILLE   (1000)
+
+// marks a CCR whose programmed count is not known (forces the next write)
+#define TMR_CCR_CNT_UNKNOWN     (0xFFFF)
+
 
 /*
  * Base timer configuration requires configuration access
@@ -164,18 +196,86 @@ typedef struct TIMERX_PWM_PARAMS
 {
     uint8_t ubyTimerNum;
 
+    uint8_t ubyNumCcrs;             // CCR0 included
+
     uint16_t ui16PwmPrdCnt;
 
-    uint8_t ubyPercentageDC[7];
+    // duty cycle last requested per CCR in 0.1% (0-1000)
+    uint16_t u16PerMilleDC[7];
+
+    // TBxCCRx count last programmed; used to skip writing an unchanged duty
+    uint16_t au16LastCcrCnt[7];
+
+    // TBxCCRx count staged by TMR_PwmStagePercentage(), waiting for commit
+    uint16_t au16StagedCcrCnt[7];
+    uint8_t  ubyStagedCcrMask;      // bit n set => CCRn staged count differs
 
     // (1.0f/ui16PwmPeriod) * 10000 - used for integer math of computing PWM %
     uint32_t ui32InvPrdCntScaled;   // scaled by 10000
 
+    // (ui16PwmPrdCnt/1000) and (1000/ui16PwmPrdCnt), both scaled by 2^16 -
+    //  used for the per-mille <=> count conversion (multiply and shift)
+    uint32_t ui32PerMilleToCntScaled;
+    uint32_t ui32CntToPerMilleScaled;
+
+    // percent (0-100) to TBxCCRx count look up table; built for the period
+    //  in use. NULL if no table is available (falls back to integer math)
+    uint16_t* pu16PctToCcrCnt;
+
     // holds the structure of the specfic timer; e.g. TimerB0_3 addresses
     TMR_GrpRegsAddress_t stPwmTimerRegsAddress;
 }stTimerXPwmParams_t;
 
+/*
+ * cycle benchmark
+ * counts SMCLK cycles spent between TMR_BenchStart() and TMR_BenchStop()
+ *  by reading the ticker timer counter. SMCLK is not divided for the ticker
+ *  so the count equals MCLK cycles. the section measured must be shorter
+ *  than a tick period and is inflated by any ISR that runs in between.
+ * from BENCH_LONG_FIRST on, the free running timer is read instead: counts
+ *  of TMR_FREE_RUN_CLK_DIV cycles, up to ~0.5s. for sections longer than a
+ *  tick or run from a timer callback (the ticker is stopped there).
+ *  main.c starts the free running timer for them if fans.c does not; with
+ *  TB1 counting a fan tach (FAN_TACH_MODE_HW_COUNT) the long benches are out.
+ */
+#define CYCLE_BENCH_LONG_ENABLED    (CYCLE_BENCH_ENABLED &&                                     \
+                                     !((FAN_TACH_MODE == FAN_TACH_MODE_HW_COUNT) &&              \
+                                       ((FAN_TACH_HW_CNT_TMR_FAN0 == TMR_FREE_RUN_TIMER) ||      \
+                                        (FAN_TACH_HW_CNT_TMR_FAN1 == TMR_FREE_RUN_TIMER))))
+
+typedef enum CYCLE_BENCH_ID
+{
+    BENCH_CTRL_PATH,    // per sample thermal control path (sensor => pwm)
+    BENCH_PWM_COMMIT,   // TMR_PwmCommitStaged() call of the control path
+    BENCH_LONG_FIRST,
+    BENCH_DIAG_FRAME = BENCH_LONG_FIRST,    // outputDiagData()
+    BENCH_CLI_CMD,      // a cli line; tokens to the reply queued
+    NUM_CYCLE_BENCHES,
+}eCycleBenchId_t;
+
+typedef struct CYCLE_BENCH
+{
+    uint16_t u16Start;
+    uint16_t u16Last;
+    uint16_t u16Min;
+    uint16_t u16Max;
+    uint32_t u32Sum;
+    uint16_t u16Cnt;
+}stCycleBench_t;
+
+#if CYCLE_BENCH_ENABLED
+    #define CYCLE_BENCH_START(id)   TMR_BenchStart(id)
+    #define CYCLE_BENCH_STOP(id)    TMR_BenchStop(id)
+#else
+    #define CYCLE_BENCH_START(id)
+    #define CYCLE_BENCH_STOP(id)
+#endif
+
+extern stCycleBench_t gastCycleBench[NUM_CYCLE_BENCHES];
+extern uint32_t gu32BenchWakeCnt;
+extern uint32_t gu32BenchResetMs;
 extern uint16_t gu16MilliSecCpuClkCycleCount;
+extern volatile uint32_t gu32UptimeMs;
 extern TMR_GrpRegsAddress_t stTimerRegsAddress;
 extern TMR_GrpRegsAddress_t stTickTimerRegsAddress;
 extern stTimerXPwmParams_t  stPwmTmrsParams[4];
@@ -188,6 +288,7 @@ uint16_t launchPadHeartBeatToggle(stTimerStruct_t* myTimer);        // p1.0
 uint16_t fanControllerHeartBeatToggle(stTimerStruct_t* myTimer);    // p1.1
 
 bool tickTmrIsrHandler();
+uint32_t TMR_GetUptimeMs();
 
 void TMR_GetTmrRegsAddress(uint8_t ubyTmrNum);
 void TMR_SectTmrCntrLength(uint8_t ubyTmrNum, uint16_t ui16CntrlLen);
@@ -204,8 +305,32 @@ void TMR_PwmPrdCfgForTimerBx(uint8_t ubyTmrNum, uint16_t ui16PwmPrdFreq);
 void TMR_PwmOutModeAndPinMuxforTimberBxAndCcrX(uint8_t ubyTmrNum,
                                                 uint8_t ubyCcrNum, uint16_t ui16OutMode);
 int16_t TMR_PwmSetPercentage (uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint8_t ubyPercentage);
+int16_t TMR_PwmSetPerMille(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint16_t u16PerMille);
+int16_t TMR_PwmSetDutyCnt(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint16_t u16DutyCnt);
+void TMR_PwmCfgLatchedUpdates(uint8_t ubyTmrNum);
+int16_t TMR_PwmStagePercentage(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint8_t ubyPercent);
+int16_t TMR_PwmStagePerMille(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint16_t u16PerMille);
+int16_t TMR_PwmStageDutyCnt(uint8_t ubyTmrNum, uint8_t ubyCcrNum, uint16_t u16DutyCnt);
+int16_t TMR_PwmCommitStaged(uint8_t ubyTmrNum);
+
 void TMR_PwmPinMuxCfg(uint8_t ubyTimer, uint8_t ubyCcrNum);
 int8_t TMR_PwmGetDcPercenatage(uint8_t ubyTmrNum, uint8_t ubyCcrNum);
+int16_t TMR_PwmGetDcPerMille(uint8_t ubyTmrNum, uint8_t ubyCcrNum);
+uint16_t TMR_PwmGetPrdCnt(uint8_t ubyTmrNum);
+
+
+void     TMR_CfgExtClkCounter(uint8_t ubyTmrNum);
+uint16_t TMR_ReadExtClkCounter(uint8_t ubyTmrNum);
+void     TMR_CfgFreeRunTimer();
+
+uint32_t TMR_GetFreeRunHz();
+uint32_t TMR_GetFreeRunTs();
+
+void TMR_BenchStart(uint8_t ubyBenchId);
+
+void TMR_BenchStop(uint8_t ubyBenchId);
+void TMR_BenchReset();
+
 
 void timer_test();
 void cfgTickClkTestPort();
@@ -17,6 +17,7 @@
 #include "main.h"
 #include "tmp1075.h"
 #include "thermalcontrol.h"
+#include "selftest.h"
 
 float gfI2cSnsrTempAvg = -1;
 
@@ -229,7 +230,11 @@ void xformTmp1075Adc2Temp()
     pastTmp1075I2cMsgTable[gbyProcessI2cTmp1075MsgNum]->fI2cRead1stValue = i16Data1st * fTempSnsrLsb;
 
     fCurrentTempValue  = pastTmp1075I2cMsgTable[gbyProcessI2cTmp1075MsgNum]->fI2cRead1stValue;
-    pastTmp1075I2cMsgTable[gbyProcessI2cTmp1075MsgNum]->fI2cRead1stValueSave = fCurrentTempValue;
+    // the self test plays into the sensor; keep its value
+    if(!selfTestOwnsSnsr(SNSR_TMP1075_FIRST + gbyProcessI2cTmp1075MsgNum))
+    {
+        pastTmp1075I2cMsgTable[gbyProcessI2cTmp1075MsgNum]->fI2cRead1stValueSave = fCurrentTempValue;
+    }
 //
 //    gfTempAvg = updateAverageTemp();
 //    processThermalControl();
@@ -240,6 +245,10 @@ void xformTmp1075Adc2Temp()
     }
     else
     {
+        // re-evaluate fans that have this TMP1075 reading mapped
+        updateFanDemand(SNSR_TMP1075_FIRST + gbyProcessI2cTmp1075MsgNum);
+
+
         if (++ubyTrackNumSnsrs == MAX_I2C_TMP1075_MESSAGES)
         {
             ubyTrackNumSnsrs = 0;   // reset track indicator
@@ -319,7 +328,7 @@ void testTzAndPwm()
     }
 
     gfI2cSnsrTempAvg = i8AvgTemp;
-    processThermalControl();
+    processThermalControl(SNSR_TMP1075_FIRST + gbyProcessI2cTmp1075MsgNum);
 }
 
 uint16_t tmp1075I2cWatchDog(stTimerStruct_t* myTimer)
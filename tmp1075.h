@@ -42,8 +42,8 @@ extern uint32_t gi32I2cTmp1075MsgSwResetCnt;
 extern stI2cTrasaction_t* pastTmp1075I2cMsgTable[];
 
 
-extern volatile uint8_t abyTmp1075I2cTxBuff[][];
-extern volatile uint8_t abyTmp1075I2cRxBuff[][];
+extern volatile uint8_t abyTmp1075I2cTxBuff[][MAX_I2C_TMP1075_MSG_BYTE_CNT];
+extern volatile uint8_t abyTmp1075I2cRxBuff[][MAX_I2C_TMP1075_MSG_BYTE_CNT];
 
 extern stI2cTrasaction_t stTmp1075I2cMessage0;
 extern stI2cTrasaction_t stTmp1075I2cMessage1;
@@ -0,0 +1,250 @@
+/*
+ * tlmdecode.c (host tool)
+ *
+ *  decodes the binary telemetry stream of the firmware (telemetry.c) to
+ *  csv on stdout: COBS frames with a 0x00 each side, CRC-16/CCITT-FALSE
+ *  over the frame. bytes that do not make a frame (cli text on a shared
+ *  uart) are skipped and counted; a text block between two frames also
+ *  counts as a bad frame. a summary goes to stderr at the end.
+ *
+ *  usage: tlmdecode [file]     stdin if no file; e.g. a serial port set
+ *                              up with stty raw 460800 < /dev/ttyUSB1
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define TLM_FRAME_STATUS        (0x01)
+#define TLM_STATUS_VER          (1)
+#define TLM_STATUS_HDR_LEN      (5)
+#define TLM_WIRE_MAX            (1024)
+
+typedef struct TLM_DECODE_STATS
+{
+    uint32_t u32Frames;
+    uint32_t u32CrcErrs;
+    uint32_t u32BadFrames;      // cobs, length or type
+    uint32_t u32SeqLost;
+    uint32_t u32Skipped;        // bytes not in a frame
+    bool     bHeader;
+    bool     bSeqValid;
+    uint16_t u16SeqNext;
+}stTlmDecodeStats_t;
+
+static stTlmDecodeStats_t stStats;
+
+
+static uint16_t crc16(const uint8_t* pubyData, size_t uLen)
+{
+    uint16_t u16Crc = 0xFFFF;
+    int      iBit;
+
+    while (uLen--)
+    {
+        u16Crc ^= (uint16_t)(*pubyData++) << 8;
+        for (iBit=0; iBit<8; iBit++)
+        {
+            u16Crc = (u16Crc & 0x8000) ? ((u16Crc << 1) ^ 0x1021) : (u16Crc << 1);
+        }
+    }
+
+    return u16Crc;
+}
+
+
+// returns the decoded length; 0 if not valid COBS
+static size_t cobsDecode(const uint8_t* pubyIn, size_t uLen, uint8_t* pubyOut)
+{
+    size_t  uIn  = 0;
+    size_t  uOut = 0;
+    uint8_t ubyCode;
+    uint8_t ubyIndx;
+
+    while (uIn < uLen)
+    {
+        ubyCode = pubyIn[uIn++];
+        if ((ubyCode == 0) || ((uIn + ubyCode - 1) > uLen))
+        {
+            return 0;
+        }
+        for (ubyIndx=1; ubyIndx<ubyCode; ubyIndx++)
+        {
+            pubyOut[uOut++] = pubyIn[uIn++];
+        }
+        if ((ubyCode != 0xFF) && (uIn < uLen))
+        {
+            pubyOut[uOut++] = 0;
+        }
+    }
+
+    return uOut;
+}
+
+
+static uint16_t getU16(const uint8_t* pubyPos)
+{
+    return (uint16_t)(pubyPos[0] | (pubyPos[1] << 8));
+}
+
+
+static uint32_t getU32(const uint8_t* pubyPos)
+{
+    return getU16(pubyPos) | ((uint32_t)getU16(pubyPos + 2) << 16);
+}
+
+
+static bool decodeStatus(const uint8_t* pubyFrame, size_t uLen)
+{
+    uint8_t  ubyFans  = pubyFrame[2];
+    uint8_t  ubySnsrs = pubyFrame[3];
+    uint8_t  ubyAdcs  = pubyFrame[4];
+    size_t   uNeed    = TLM_STATUS_HDR_LEN + 6 + 8 * ubyFans + 2 * ubySnsrs + 2 + 2 * ubyAdcs + 3;
+    const uint8_t* pubyPos;
+    uint16_t u16Seq;
+    uint8_t  ubyIndx;
+
+    if ((pubyFrame[1] != TLM_STATUS_VER) || (uLen != uNeed))
+    {
+        return false;
+    }
+
+    if (!stStats.bHeader)
+    {
+        printf("seq,ms");
+        for (ubyIndx=0; ubyIndx<ubyFans; ubyIndx++)
+        {
+            printf(",target%u_pm,out%u_pm,rpm%u,tz%u,health%u", ubyIndx, ubyIndx, ubyIndx, ubyIndx, ubyIndx);
+        }
+        for (ubyIndx=0; ubyIndx<ubySnsrs; ubyIndx++)
+        {
+            printf(",snsr%u_c", ubyIndx);
+        }
+        printf(",valid_mask,self_mask");
+        for (ubyIndx=0; ubyIndx<ubyAdcs; ubyIndx++)
+        {
+            printf(",adc%u", ubyIndx);
+        }
+        printf(",htr_pm,htr_mask\n");
+        stStats.bHeader = true;
+    }
+
+    pubyPos = pubyFrame + TLM_STATUS_HDR_LEN;
+    u16Seq  = getU16(pubyPos);
+    if (stStats.bSeqValid && (u16Seq != stStats.u16SeqNext))
+    {
+        stStats.u32SeqLost += (uint16_t)(u16Seq - stStats.u16SeqNext);
+    }
+    stStats.bSeqValid  = true;
+    stStats.u16SeqNext = u16Seq + 1;
+
+    printf("%u,%u", u16Seq, getU32(pubyPos + 2));
+    pubyPos += 6;
+    for (ubyIndx=0; ubyIndx<ubyFans; ubyIndx++, pubyPos+=8)
+    {
+        printf(",%u,%u,%u,%u,%u", getU16(pubyPos), getU16(pubyPos + 2), getU16(pubyPos + 4),
+               pubyPos[6], pubyPos[7]);
+    }
+    for (ubyIndx=0; ubyIndx<ubySnsrs; ubyIndx++, pubyPos+=2)
+    {
+        printf(",%.2f", (int16_t)getU16(pubyPos) / 100.0);
+    }
+    printf(",0x%02X,0x%02X", pubyPos[0], pubyPos[1]);
+    pubyPos += 2;
+    for (ubyIndx=0; ubyIndx<ubyAdcs; ubyIndx++, pubyPos+=2)
+    {
+        printf(",%u", getU16(pubyPos));
+    }
+    printf(",%u,0x%02X\n", getU16(pubyPos), pubyPos[2]);
+
+    return true;
+}
+
+
+static void decodeWire(const uint8_t* pubyWire, size_t uLen)
+{
+    uint8_t aubyFrame[TLM_WIRE_MAX];
+    size_t  uFrameLen = cobsDecode(pubyWire, uLen, aubyFrame);
+
+    if (uFrameLen < TLM_STATUS_HDR_LEN + 2)
+    {
+        stStats.u32BadFrames++;
+        stStats.u32Skipped += uLen;
+        return;
+    }
+
+    uFrameLen -= 2;
+    if (crc16(aubyFrame, uFrameLen) != getU16(&aubyFrame[uFrameLen]))
+    {
+        stStats.u32CrcErrs++;
+        stStats.u32Skipped += uLen;
+        return;
+    }
+
+    if ((aubyFrame[0] == TLM_FRAME_STATUS) && decodeStatus(aubyFrame, uFrameLen))
+    {
+        stStats.u32Frames++;
+    }
+    else
+    {
+        stStats.u32BadFrames++;
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    FILE*   pFile = stdin;
+    uint8_t aubyWire[TLM_WIRE_MAX];
+    size_t  uLen = 0;
+    bool    bOverflow = false;
+    int     iByte;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [file]\n", argv[0]);
+        return 1;
+    }
+    if ((argc == 2) && ((pFile = fopen(argv[1], "rb")) == NULL))
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    while ((iByte = fgetc(pFile)) != EOF)
+    {
+        if (iByte != 0)
+        {
+            if (uLen < sizeof(aubyWire))
+            {
+                aubyWire[uLen++] = (uint8_t)iByte;
+            }
+            else
+            {
+                bOverflow = true;
+                stStats.u32Skipped++;
+            }
+            continue;
+        }
+
+        if (bOverflow)
+        {
+            stStats.u32BadFrames++;
+            stStats.u32Skipped += uLen;
+        }
+        else if (uLen)
+        {
+            decodeWire(aubyWire, uLen);
+        }
+        uLen      = 0;
+        bOverflow = false;
+    }
+    stStats.u32Skipped += uLen;
+
+    fprintf(stderr, "frames %u, crc errors %u, bad frames %u, seq lost %u, bytes skipped %u\n",
+            stStats.u32Frames, stStats.u32CrcErrs, stStats.u32BadFrames,
+            stStats.u32SeqLost, stStats.u32Skipped);
+
+    return (stStats.u32Frames != 0) ? 0 : 2;
+}
@@ -1,12 +1,14 @@
 #include <msp430.h>
 #include <stdint.h>
-#include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <intrinsics.h>
+#include "config.h"
 #include "clocks.h"
 #include "main.h"
 #include "uart.h"
 #include "cli.h"
+#include "fmt.h"
 
 /*
  * uart.c
@@ -19,32 +21,146 @@
  *   eUSCI_A1   P4.2 UCA1RXD - Pin 24
  *              P4.3 UCA1TXD - Pin 23
  *
+ * each eUSCI has its own instance; registers, rings, rate and stats.
+ *  UART_CLI is the interactive one, UART_TLM carries telemetry.
  */
 
-char achUartInputBuffer[SERIAL_BUFFER_SZ];
-char achUartOutputBuffer[SERIAL_BUFFER_SZ];
-uint8_t ubyUrtInBuffLdrIndx;
-uint8_t ubyUrtInBuffUnLdIndx;
-uint8_t ubyUrtOutBuffLdrIndx;
-uint8_t ubyUrtOutBuffUnLdrIndx;
+/*
+ * rx: the rx isr is the producer of pachRxBuff[], main the consumer.
+ *  line mode (the cli): the rx isr edits and echoes the line being
+ *  received and ends it with a NULL; main is woken once per line and
+ *  takes whole lines (UART_getLine()).
+ *  raw mode: bytes are queued as received; UART_read() takes them.
+ *  nothing is overwritten: what does not fit is dropped and counted.
+ *
+ * tx: the tx isr feeds pachTxBuff[] to the transmitter itself; main is
+ *  not woken per byte. writes never block: what does not fit is dropped
+ *  and counted per stream. a producer with more to send asks for an
+ *  event once there is room (UART_notifyTxRoom()).
+ */
+#define UART_ECHO_MASK      (UART_ECHO_BUFF_SZ - 1)
 
-uint16_t ui16RcvStatus;
+typedef struct UART_INST
+{
+    UART_GrpRegsAddress_t stRegs;
+    eUartClk_t          eClk;
+    uint32_t            u32Baud;
+    bool                bCfg;               // UART_CfgUart() done; not deinit since
+
+    // tx; moved by the tx isr: u16TxUnLdrIndx, bXmitBusy
+    char*               pachTxBuff;
+    uint16_t            u16TxBuffSz;
+    uint16_t            u16TxLdrIndx;
+    volatile uint16_t   u16TxUnLdrIndx;
+    volatile bool       bXmitBusy;          // cleared by the first tx int after reset
+    volatile uint16_t   u16TxRoomReq;       // 0 => no request
+    volatile bool       bTxRoomReady;
+    void              (*pfnTxRoomCb)(void);
+    uint16_t            u16TxStageIndx;     // main; end of the staged bytes
+    uint16_t            u16TxStageLen;
+    uint16_t            u16TxStageLost;     // did not fit; nothing is staged after
+
+    // rx; moved by main: u16RxUnLdIndx
+    char*               pachRxBuff;
+    uint16_t            u16RxBuffSz;
+    volatile uint16_t   u16RxLdrIndx;
+    volatile uint16_t   u16RxUnLdIndx;
+    bool                bLineMode;
+    volatile uint8_t    ubyRxLines;         // complete lines queued
+    uint16_t            u16RxLineLen;       // rx isr; chars of the line being received
+    bool                bRxLastCr;          // rx isr; LF of a CR LF pair is not a line
+    uint16_t            u16RcvStatus;
+
+    // echo waiting for the transmitter; rx and tx isr only, sent ahead of the output buffer
+    char                achEchoBuff[UART_ECHO_BUFF_SZ];
+    uint8_t             ubyEchoLdrIndx;
+    uint8_t             ubyEchoUnLdrIndx;
+
+    stUartTxStats_t     stTxStats;
+    stUartRxStats_t     stRxStats;
+}stUartInst_t;
+
+static char achUartA0OutputBuffer[UART_A0_TX_BUFF_SZ];
+static char achUartA0InputBuffer[UART_A0_RX_BUFF_SZ];
+static char achUartA1OutputBuffer[UART_A1_TX_BUFF_SZ];
+static char achUartA1InputBuffer[UART_A1_RX_BUFF_SZ];
+
+static stUartInst_t astUart[NUM_UARTS] =
+{
+    [UART_A0] =
+    {
+        .pachTxBuff  = achUartA0OutputBuffer,
+        .u16TxBuffSz = UART_A0_TX_BUFF_SZ,
+        .bXmitBusy   = true,
+        .pachRxBuff  = achUartA0InputBuffer,
+        .u16RxBuffSz = UART_A0_RX_BUFF_SZ,
+        .bLineMode   = (UART_A0 == UART_CLI)
+    },
+    [UART_A1] =
+    {
+        .pachTxBuff  = achUartA1OutputBuffer,
+        .u16TxBuffSz = UART_A1_TX_BUFF_SZ,
+        .bXmitBusy   = true,
+        .pachRxBuff  = achUartA1InputBuffer,
+        .u16RxBuffSz = UART_A1_RX_BUFF_SZ,
+        .bLineMode   = (UART_A1 == UART_CLI)
+    }
+};
 
-bool    bUartXmitBusy = true;
+stDevClks_t stCurrentClkFreq;
 
-UART_GrpRegsAddress_t stUartRegsAddress;
+// fraction of N => UCBRSx; values, extracted from 'slau445i, Table 22-4'
+typedef struct UART_BRS_ENTRY
+{
+    uint16_t u16Frac;       // 0.0001 units
+    uint8_t  ubyBrs;
+}stUartBrsEntry_t;
 
-stDevClks_t stCurrentClkFreq;
+static const stUartBrsEntry_t astUartBrsTbl[] =
+{
+    {   0, 0x00}, { 529, 0x01}, { 715, 0x02}, { 835, 0x04}, {1001, 0x08}, {1252, 0x10},
+    {1430, 0x20}, {1670, 0x11}, {2147, 0x21}, {2224, 0x22}, {2503, 0x44}, {3000, 0x25},
+    {3335, 0x49}, {3575, 0x4A}, {3753, 0x52}, {4003, 0x92}, {4286, 0x53}, {4378, 0x55},
+    {5002, 0xAA}, {5715, 0x6B}, {6003, 0xAD}, {6254, 0xB5}, {6432, 0xB6}, {6667, 0xD6},
+    {7001, 0xB7}, {7147, 0xBB}, {7503, 0xDD}, {7861, 0xED}, {8004, 0xEE}, {8333, 0xBF},
+    {8464, 0xDF}, {8572, 0xEF}, {8751, 0xF7}, {9004, 0xFB}, {9170, 0xFD}, {9288, 0xFE}
+};
+#define NUM_UART_BRS_ENTRIES    (sizeof(astUartBrsTbl) / sizeof(astUartBrsTbl[0]))
+
+// settings tuned per clock and rate; values, extracted from 'slau445i, Table 22-5'
+typedef struct UART_BAUD_ENTRY
+{
+    uint32_t u32ClkHz;
+    uint32_t u32Baud;
+    uint16_t u16Brw;
+    uint16_t u16Mctlw;
+}stUartBaudEntry_t;
+
+static const stUartBaudEntry_t astUartBaudTbl[] =
+{
+    {8000000,   9600, 52, 0x4911},
+    {8000000,  19200, 26, 0xB601},
+    {8000000,  38400, 13, 0x8401},
+    {8000000,  57600,  8, 0xF7A1},
+    {8000000, 115200,  4, 0x5551},
+    {8000000, 230400,  2, 0xBB21},
+    {8000000, 460800,  1, 0x4A11}
+};
+#define NUM_UART_BAUD_ENTRIES   (sizeof(astUartBaudTbl) / sizeof(astUartBaudTbl[0]))
+
+// start, 8 data, stop
+#define UART_FRAME_BITS         (10)
 
 
 void deInitUart(eUartNum_t eUartNum)
 {
     // disable UART interrupt
-    UART_EnableDisableRxInt(UART_DISABLE_RXINT);
-    UART_EnableDisableRxInt(UART_DISABLE_TXINT);
+    UART_EnableDisableRxInt(eUartNum, UART_DISABLE_RXINT);
+    UART_EnableDisableTxInt(eUartNum, UART_DISABLE_TXINT);
 
     // hold UART in reset
-    UART_HoldReleaseFromRst(UART_HOLD_IN_RST);
+    UART_HoldReleaseFromRst(eUartNum, UART_HOLD_IN_RST);
+    astUart[eUartNum].bCfg = false;
 
     // reconfigure port for gpio usage
     switch(eUartNum)
@@ -64,21 +180,22 @@ void deInitUart(eUartNum_t eUartNum)
 }
 
 void UART_CfgUart(eUartNum_t eUartNum, eUartClk_t eUartClk,
-                  eUartBaud_t eBaudRate, bool bRxInt, bool bTxInt)
+                  uint32_t u32BaudRate, bool bRxInt, bool bTxInt)
 {
     // get uart regs address
     UART_GetUartRegsAddress(eUartNum);
-    UART_HoldReleaseFromRst(UART_HOLD_IN_RST);
-    UART_CfgUartCtrlWord0(eUartClk);
-    UART_CfgUartBaud(eBaudRate);
-    UART_HoldReleaseFromRst(UART_RELEASE_FROM_RST);
+    UART_HoldReleaseFromRst(eUartNum, UART_HOLD_IN_RST);
+    UART_CfgUartCtrlWord0(eUartNum, eUartClk);
+    UART_CfgUartBaud(eUartNum, u32BaudRate);
+    UART_HoldReleaseFromRst(eUartNum, UART_RELEASE_FROM_RST);
     // must release from reset prior to configuring int enable
     UART_CfgPortForUartUsage(eUartNum);
-    UART_EnableDisableRxInt(bRxInt);
-    UART_EnableDisableTxInt(bTxInt);
+    UART_EnableDisableRxInt(eUartNum, bRxInt);
+    UART_EnableDisableTxInt(eUartNum, bTxInt);
 
     // for baud rate cfg, need to know input clk freq
     stCurrentClkFreq = getClockFreq();
+    astUart[eUartNum].bCfg = true;
 }
 
 
@@ -103,99 +220,233 @@ void UART_CfgPortForUartUsage(eUartNum_t eUartNum)
 
 
 
-void UART_EnableDisableRxInt(bool bEnableDisabeRxInt)
+void UART_EnableDisableRxInt(eUartNum_t eUartNum, bool bEnableDisabeRxInt)
 {
     if(bEnableDisabeRxInt)
     {
-        *stUartRegsAddress.pUartIntEnable |= UCRXIE;
+        *astUart[eUartNum].stRegs.pUartIntEnable |= UCRXIE;
     }
     else
     {
-        *stUartRegsAddress.pUartIntEnable &= ~UART_ENABLE_RX_INT;
+        *astUart[eUartNum].stRegs.pUartIntEnable &= ~UART_ENABLE_RX_INT;
 
     }
 }
 
 
-void UART_EnableDisableTxInt(bool bEnableDisabeTxInt)
+void UART_EnableDisableTxInt(eUartNum_t eUartNum, bool bEnableDisabeTxInt)
 {
     if(bEnableDisabeTxInt)
     {
-        *stUartRegsAddress.pUartIntEnable |= UCTXIE;
+        *astUart[eUartNum].stRegs.pUartIntEnable |= UCTXIE;
     }
     else
     {
-        *stUartRegsAddress.pUartIntEnable &= ~UART_ENABLE_TX_INT;
+        *astUart[eUartNum].stRegs.pUartIntEnable &= ~UART_ENABLE_TX_INT;
 
     }
 }
 
 
 
-void UART_CfgUartCtrlWord0(eUartClk_t eUartClk)
+void UART_CfgUartCtrlWord0(eUartNum_t eUartNum, eUartClk_t eUartClk)
 {
-    *stUartRegsAddress.pUartCtrlWord0 &= ~UCSSEL;
-    *stUartRegsAddress.pUartCtrlWord0 |= eUartClk;
+    astUart[eUartNum].eClk = eUartClk;
+    *astUart[eUartNum].stRegs.pUartCtrlWord0 &= ~UCSSEL;
+    *astUart[eUartNum].stRegs.pUartCtrlWord0 |= eUartClk;
 }
 
 
-void UART_HoldReleaseFromRst(bool bRelHold)
+void UART_HoldReleaseFromRst(eUartNum_t eUartNum, bool bRelHold)
 {
     if(bRelHold)
     {
-        *stUartRegsAddress.pUartCtrlWord0 |= UART_HOLD_IN_RST;
+        *astUart[eUartNum].stRegs.pUartCtrlWord0 |= UART_HOLD_IN_RST;
     }
     else
     {
-        *stUartRegsAddress.pUartCtrlWord0 &= ~UART_HOLD_IN_RST;
+        *astUart[eUartNum].stRegs.pUartCtrlWord0 &= ~UART_HOLD_IN_RST;
     }
 }
 
 
-// values, extracted from 'slau445i, Table 22-5'
 /*
- * these values pertain to the use of 8MHz SMCLK frequency as
- *  input to the UART module.
+ * uartBitErr(): worst bit error of a frame, 0.01% of a bit; per
+ *  'slau445i, 22.3.10'. the end of bit j is sum(t_bit[0..j]) against
+ *  (j + 1) ideal bits; t_bit[i] = 16 * UCBRx + UCBRFx + m[i] (UCOS16) or
+ *  UCBRx + m[i], m[i] bit (i mod 8) of UCBRSx, the start bit takes bit 0.
+ *  late (a longer bit) is positive.
  */
-void UART_CfgUartBaud(eUartBaud_t eUartBaud)
+static int16_t uartBitErr(uint32_t u32ClkHz, uint32_t u32BaudRate, const stUartBaudCfg_t* pstBaudCfg)
 {
-    if (stCurrentClkFreq.ui32SmclkHz == 8000000)
+    uint8_t  ubyBrs   = (uint8_t)(pstBaudCfg->u16Mctlw >> 8);
+    uint32_t u32Bit   = pstBaudCfg->u16Brw;
+    uint32_t u32Cum   = 0;
+    int32_t  i32Err;
+    int32_t  i32Worst = 0;
+    uint8_t  ubyBit;
+
+    if (pstBaudCfg->u16Mctlw & UCOS16)
     {
-        switch (eUartBaud)
+        u32Bit = (u32Bit << 4) + ((pstBaudCfg->u16Mctlw >> 4) & 0x0F);
+    }
+
+    for (ubyBit=0; ubyBit<UART_FRAME_BITS; ubyBit++)
+    {
+        u32Cum += u32Bit + ((ubyBrs >> (ubyBit & 0x07)) & 0x01);
+        // in ideal bits * 10000; cycles * baud / clk
+        i32Err  = (int32_t)(u32Cum * u32BaudRate - (ubyBit + 1) * u32ClkHz);
+        i32Err  = (i32Err * 100) / (int32_t)(u32ClkHz / 100);
+        if (((i32Err < 0) ? -i32Err : i32Err) > ((i32Worst < 0) ? -i32Worst : i32Worst))
         {
-        case UART_BAUD_9600:
-            *stUartRegsAddress.pUartBaudRateWord        = 52;
-            *stUartRegsAddress.pUartModulationCntrlWord = 0x4911;
-        //            UCA0BR0 = 52;
-        //            UCA0MCTLW = 0x4911;
-            break;
-        case UART_BAUD_19200:
-            *stUartRegsAddress.pUartBaudRateWord        = 26;
-            *stUartRegsAddress.pUartModulationCntrlWord = 0xB601;
-        //            UCA0BR0 = 26;
-        //            UCA0MCTLW = 0xB601;
-            break;
-        case UART_BAUD_38400:
-            *stUartRegsAddress.pUartBaudRateWord         = 13;
-            *stUartRegsAddress.pUartModulationCntrlWord = 0x8401;
-        //            UCA0BR0 = 13;
-        //            UCA0MCTLW = 0x8401;
-            break;
-        case UART_BAUD_57600:
-            *stUartRegsAddress.pUartBaudRateWord        = 8;
-            *stUartRegsAddress.pUartModulationCntrlWord = 0xF7A1;
-        //            UCA0BR0 = 8;
-        //            UCA0MCTLW = 0xF7A1;
-            break;
-        case UART_BAUD_115200:
-            *stUartRegsAddress.pUartBaudRateWord        = 4;
-            *stUartRegsAddress.pUartModulationCntrlWord = 0x5551;
-        //            UCA0BR0 = 4;
-        //            UCA0MCTLW = 0x5551;
-            break;
+            i32Worst = i32Err;
         }
+    }
+
+    return (int16_t)i32Worst;
+}
+
+
+/*
+ * UART_CalcBaud(): baud rate generator settings for any rate, per
+ *  'slau445i, 22.3.10'. a clock and rate of Table 22-5 take its tuned
+ *  settings; others are computed from N = fBRCLK / baud:
+ *   N >= 16: oversampling; UCBRx = INT(N / 16), UCBRFx = INT(N) mod 16
+ *   N <  16: low frequency; UCBRx = INT(N)
+ *   UCBRSx from the fraction of N; the largest Table 22-4 fraction not
+ *    above it
+ *  i16ErrCentiPct is the worst bit error of a frame; see uartBitErr().
+ *  returns false if the rate can not be made from u32ClkHz.
+ */
+bool UART_CalcBaud(uint32_t u32ClkHz, uint32_t u32BaudRate, stUartBaudCfg_t* pstBaudCfg)
+{
+    uint32_t u32N;
+    uint32_t u32Frac4096;       // fraction of N; 1/4096 units
+    uint32_t u32Frac;           // 0.0001 units
+    uint8_t  ubyBrs = 0;
+    uint8_t  ubyIndx;
+
+    // << 12 of the remainder must fit 32 bits
+    if ((u32BaudRate == 0) || (u32BaudRate > UART_BAUD_MAX) || (u32BaudRate >= (1UL << 20)))
+    {
+        return false;
+    }
+
+    u32N = u32ClkHz / u32BaudRate;
+    if (u32N < 3)
+    {
+        return false;
+    }
 
+    for (ubyIndx=0; ubyIndx<NUM_UART_BAUD_ENTRIES; ubyIndx++)
+    {
+        if ((astUartBaudTbl[ubyIndx].u32ClkHz == u32ClkHz) && (astUartBaudTbl[ubyIndx].u32Baud == u32BaudRate))
+        {
+            pstBaudCfg->u16Brw         = astUartBaudTbl[ubyIndx].u16Brw;
+            pstBaudCfg->u16Mctlw       = astUartBaudTbl[ubyIndx].u16Mctlw;
+            pstBaudCfg->i16ErrCentiPct = uartBitErr(u32ClkHz, u32BaudRate, pstBaudCfg);
+            return true;
+        }
     }
+
+    u32Frac4096 = ((u32ClkHz % u32BaudRate) << 12) / u32BaudRate;
+    u32Frac     = (u32Frac4096 * 10000) >> 12;
+
+    for (ubyIndx=0; (ubyIndx<NUM_UART_BRS_ENTRIES) && (astUartBrsTbl[ubyIndx].u16Frac <= u32Frac); ubyIndx++)
+    {
+        ubyBrs = astUartBrsTbl[ubyIndx].ubyBrs;
+    }
+
+    if (u32N >= 16)
+    {
+        pstBaudCfg->u16Brw   = (uint16_t)(u32N >> 4);
+        pstBaudCfg->u16Mctlw = ((uint16_t)ubyBrs << 8) | ((uint16_t)(u32N & 0x0F) << 4) | UCOS16;
+    }
+    else
+    {
+        pstBaudCfg->u16Brw   = (uint16_t)u32N;
+        pstBaudCfg->u16Mctlw = (uint16_t)ubyBrs << 8;
+    }
+    pstBaudCfg->i16ErrCentiPct = uartBitErr(u32ClkHz, u32BaudRate, pstBaudCfg);
+
+    return true;
+}
+
+
+// UART_CalcBaud() for the clock the uart runs from; the external UCLK is not known
+bool UART_CalcBaudInUse(eUartNum_t eUartNum, uint32_t u32BaudRate, stUartBaudCfg_t* pstBaudCfg)
+{
+    if (astUart[eUartNum].eClk != UART_CLK_SMCLK)
+    {
+        return false;
+    }
+
+    return UART_CalcBaud(getClockFreq().ui32SmclkHz, u32BaudRate, pstBaudCfg);
+}
+
+
+// uart must be held in reset
+bool UART_CfgUartBaud(eUartNum_t eUartNum, uint32_t u32BaudRate)
+{
+    stUartInst_t*   pUart = &astUart[eUartNum];
+    stUartBaudCfg_t stBaudCfg;
+
+    if (!UART_CalcBaudInUse(eUartNum, u32BaudRate, &stBaudCfg))
+    {
+        return false;
+    }
+
+    *pUart->stRegs.pUartBaudRateWord        = stBaudCfg.u16Brw;
+    *pUart->stRegs.pUartModulationCntrlWord = stBaudCfg.u16Mctlw;
+    pUart->u32Baud = u32BaudRate;
+
+    return true;
+}
+
+
+/*
+ * UART_SetBaud(): changes the rate at run time. output still queued goes
+ *  out at the new rate; callers let it drain first (UART_notifyTxRoom()).
+ *  the reset clears the interrupt enables; they are set again.
+ */
+bool UART_SetBaud(eUartNum_t eUartNum, uint32_t u32BaudRate)
+{
+    stUartInst_t*   pUart = &astUart[eUartNum];
+    stUartBaudCfg_t stBaudCfg;
+
+    if (!UART_CalcBaudInUse(eUartNum, u32BaudRate, &stBaudCfg))
+    {
+        return false;
+    }
+
+    // the last byte leaves the shift register
+    while (*pUart->stRegs.pUartStatus & UCBUSY);
+
+    __disable_interrupt();
+    pUart->bXmitBusy = true;    // cleared by the first tx int after reset
+    UART_HoldReleaseFromRst(eUartNum, UART_HOLD_IN_RST);
+    *pUart->stRegs.pUartBaudRateWord        = stBaudCfg.u16Brw;
+    *pUart->stRegs.pUartModulationCntrlWord = stBaudCfg.u16Mctlw;
+    UART_HoldReleaseFromRst(eUartNum, UART_RELEASE_FROM_RST);
+    UART_EnableDisableRxInt(eUartNum, UART_ENABLE_RXINT);
+    UART_EnableDisableTxInt(eUartNum, UART_ENABLE_TXINT);
+    pUart->u32Baud = u32BaudRate;
+    __enable_interrupt();
+
+    return true;
+}
+
+
+uint32_t UART_getBaud(eUartNum_t eUartNum)
+{
+    return astUart[eUartNum].u32Baud;
+}
+
+
+// false for an instance never configured (e.g. UART_TLM_ENABLED 0) or deinit
+bool UART_isCfg(eUartNum_t eUartNum)
+{
+    return (eUartNum < NUM_UARTS) && astUart[eUartNum].bCfg;
 }
 
 
@@ -203,48 +454,226 @@ void UART_CfgUartBaud(eUartBaud_t eUartBaud)
 // Get UART Register Addresses for either eUSCI_A0 or eUSCI_A1
 void UART_GetUartRegsAddress(eUartNum_t eUartNum)
 {
+    UART_GrpRegsAddress_t* pstRegs = &astUart[eUartNum].stRegs;
+
     switch(eUartNum)
     {
         case(UART_A0):
-            stUartRegsAddress.pUartCtrlWord0           = &UCA0CTLW0;
-            stUartRegsAddress.pUartCtrlWord1           = &UCA0CTLW1;
-            stUartRegsAddress.pUartBaudRateWord        = &UCA0BRW;
-            stUartRegsAddress.pUartModulationCntrlWord = &UCA0MCTLW;
+            pstRegs->pUartCtrlWord0           = &UCA0CTLW0;
+            pstRegs->pUartCtrlWord1           = &UCA0CTLW1;
+            pstRegs->pUartBaudRateWord        = &UCA0BRW;
+            pstRegs->pUartModulationCntrlWord = &UCA0MCTLW;
 
-            stUartRegsAddress.pUartStatus              = &UCA0STATW;
-            stUartRegsAddress.pUartRxBuffReg           = &UCA0RXBUF;
-            stUartRegsAddress.pUartTxBuffReg           = &UCA0TXBUF;
+            pstRegs->pUartStatus              = &UCA0STATW;
+            pstRegs->pUartRxBuffReg           = &UCA0RXBUF;
+            pstRegs->pUartTxBuffReg           = &UCA0TXBUF;
 
-            stUartRegsAddress.pUartIntEnable           = &UCA0IE;
-            stUartRegsAddress.pUartIntFlag             = &UCA0IFG;
+            pstRegs->pUartIntEnable           = &UCA0IE;
+            pstRegs->pUartIntFlag             = &UCA0IFG;
             break;
 
         case(UART_A1):
-            stUartRegsAddress.pUartCtrlWord0           = &UCA1CTLW0;
-            stUartRegsAddress.pUartCtrlWord1           = &UCA1CTLW1;
-            stUartRegsAddress.pUartBaudRateWord        = &UCA1BRW;
-            stUartRegsAddress.pUartModulationCntrlWord = &UCA1MCTLW;
+            pstRegs->pUartCtrlWord0           = &UCA1CTLW0;
+            pstRegs->pUartCtrlWord1           = &UCA1CTLW1;
+            pstRegs->pUartBaudRateWord        = &UCA1BRW;
+            pstRegs->pUartModulationCntrlWord = &UCA1MCTLW;
 
-            stUartRegsAddress.pUartStatus              = &UCA1STATW;
-            stUartRegsAddress.pUartRxBuffReg           = &UCA1RXBUF;
-            stUartRegsAddress.pUartTxBuffReg           = &UCA1TXBUF;
+            pstRegs->pUartStatus              = &UCA1STATW;
+            pstRegs->pUartRxBuffReg           = &UCA1RXBUF;
+            pstRegs->pUartTxBuffReg           = &UCA1TXBUF;
 
-            stUartRegsAddress.pUartIntEnable           = &UCA1IE;
-            stUartRegsAddress.pUartIntFlag             = &UCA1IFG;
+            pstRegs->pUartIntEnable           = &UCA1IE;
+            pstRegs->pUartIntFlag             = &UCA1IFG;
             break;
     }
 }
 
 
+const stUartTxStats_t* UART_getTxStats(eUartNum_t eUartNum)
+{
+    return &astUart[eUartNum].stTxStats;
+}
+
+
+const stUartRxStats_t* UART_getRxStats(eUartNum_t eUartNum)
+{
+    return &astUart[eUartNum].stRxStats;
+}
+
+
+uint16_t UART_txBuffSz(eUartNum_t eUartNum)
+{
+    return astUart[eUartNum].u16TxBuffSz;
+}
+
+
+uint16_t UART_rxBuffSz(eUartNum_t eUartNum)
+{
+    return astUart[eUartNum].u16RxBuffSz;
+}
+
+
+bool UART_rxLineReady(eUartNum_t eUartNum)
+{
+    return astUart[eUartNum].ubyRxLines != 0;
+}
+
+
+/*
+ * UART_getLine(): line mode; moves the oldest complete line out of the
+ *  input ring into pchLine, NULL ended; cut to u16Max - 1 chars.
+ *  returns false if no line is complete.
+ */
+bool UART_getLine(eUartNum_t eUartNum, char* pchLine, uint16_t u16Max)
+{
+    stUartInst_t* pUart   = &astUart[eUartNum];
+    uint16_t      u16Indx = pUart->u16RxUnLdIndx;
+    uint16_t      u16Pos  = 0;
+    char          chRcvd;
+
+    if (pUart->ubyRxLines == 0)
+    {
+        return false;
+    }
+
+    while ((chRcvd = pUart->pachRxBuff[u16Indx]) != '\0')
+    {
+        if (u16Pos < u16Max - 1)
+        {
+            pchLine[u16Pos++] = chRcvd;
+        }
+        if (++u16Indx >= pUart->u16RxBuffSz)
+        {
+            u16Indx = 0;
+        }
+    }
+    pchLine[u16Pos] = '\0';
+
+    // past the NULL
+    if (++u16Indx >= pUart->u16RxBuffSz)
+    {
+        u16Indx = 0;
+    }
+
+    __disable_interrupt();
+    pUart->u16RxUnLdIndx = u16Indx;
+    pUart->ubyRxLines--;
+    __enable_interrupt();
+
+    return true;
+}
+
+
+// UART_read(): raw mode; moves up to u16Max received bytes into pubyData
+uint16_t UART_read(eUartNum_t eUartNum, uint8_t* pubyData, uint16_t u16Max)
+{
+    stUartInst_t* pUart   = &astUart[eUartNum];
+    uint16_t      u16Indx = pUart->u16RxUnLdIndx;
+    uint16_t      u16Cnt  = 0;
+
+    while ((u16Cnt < u16Max) && (u16Indx != pUart->u16RxLdrIndx))
+    {
+        pubyData[u16Cnt++] = (uint8_t)pUart->pachRxBuff[u16Indx];
+        if (++u16Indx >= pUart->u16RxBuffSz)
+        {
+            u16Indx = 0;
+        }
+    }
+    pUart->u16RxUnLdIndx = u16Indx;
+
+    return u16Cnt;
+}
+
+
+// chars queued in pachRxBuff[]
+static inline uint16_t UART_rxUsed(stUartInst_t* pUart)
+{
+    if (pUart->u16RxLdrIndx >= pUart->u16RxUnLdIndx)
+    {
+        return pUart->u16RxLdrIndx - pUart->u16RxUnLdIndx;
+    }
+
+    return pUart->u16RxBuffSz - pUart->u16RxUnLdIndx + pUart->u16RxLdrIndx;
+}
+
+
+static inline void UART_rxPut(stUartInst_t* pUart, char chRcvd)
+{
+    pUart->pachRxBuff[pUart->u16RxLdrIndx] = chRcvd;
+    if (++pUart->u16RxLdrIndx >= pUart->u16RxBuffSz)
+    {
+        pUart->u16RxLdrIndx = 0;
+    }
+}
+
+
+// isr only; the transmitter is primed here if idle, else the echo waits for the tx isr
+static void UART_rxEcho(stUartInst_t* pUart, const char* pchEcho, uint8_t ubyLen)
+{
+    for ( ; ubyLen; ubyLen--)
+    {
+        if (!pUart->bXmitBusy)
+        {
+            pUart->bXmitBusy = true;
+            *pUart->stRegs.pUartTxBuffReg = *pchEcho++;
+        }
+        else if (((pUart->ubyEchoLdrIndx + 1) & UART_ECHO_MASK) != pUart->ubyEchoUnLdrIndx)
+        {
+            pUart->achEchoBuff[pUart->ubyEchoLdrIndx] = *pchEcho++;
+            pUart->ubyEchoLdrIndx = (pUart->ubyEchoLdrIndx + 1) & UART_ECHO_MASK;
+        }
+        else
+        {
+            pUart->stTxStats.au32Drops[UART_STREAM_ECHO] += ubyLen;
+            return;
+        }
+    }
+}
+
 
-void UART_svcUartRx(void)
+/*
+ * UART_rxIsr(): a char was received; the interrupt flag was cleared by the
+ *  UCAxIV read. the error flags are taken before the UCAxRXBUF read
+ *  clears them.
+ * returns true when a line is complete; the isr wakes main then.
+ */
+static inline bool UART_rxIsr(stUartInst_t* pUart)
 {
-    char chRcvd;
+    uint16_t u16Used;
+    char     chRcvd;
 
-    gstMainEvts.bits.svcUartRx = false;
+    pUart->u16RcvStatus = *pUart->stRegs.pUartStatus;
+    chRcvd              = *pUart->stRegs.pUartRxBuffReg;
 
-    // get a copy of just received char for convenience
-    chRcvd = achUartInputBuffer[ubyUrtInBuffLdrIndx];
+    if (pUart->u16RcvStatus & UCOE)
+    {
+        pUart->stRxStats.u16Overrun++;
+    }
+    if (pUart->u16RcvStatus & UCPE)
+    {
+        pUart->stRxStats.u16Parity++;
+    }
+    if (pUart->u16RcvStatus & UCFE)
+    {
+        pUart->stRxStats.u16Framing++;
+        return false;
+    }
+
+    if (!pUart->bLineMode)
+    {
+        u16Used = UART_rxUsed(pUart);
+        if (u16Used >= pUart->u16RxBuffSz - 1)
+        {
+            pUart->stRxStats.u16Dropped++;
+            return false;
+        }
+        UART_rxPut(pUart, chRcvd);
+        if (++u16Used > pUart->stRxStats.u16HighWater)
+        {
+            pUart->stRxStats.u16HighWater = u16Used;
+        }
+        return false;
+    }
 
     /*
      * when handling backspace you will need to:
@@ -253,187 +682,365 @@ void UART_svcUartRx(void)
      *    this write would move the cursor past the 'space' written
      * 3. move back the cursor one character back, the space character.
      *
-     * now you are ready to enter a new character or
-     *  proceed on repeating the backspace action to delete more
-     *  characters and writing spaces.
+     * only chars of the line being received are taken back.
      */
-    // check for backspace
-    if(chRcvd == '\b')
+    if ((chRcvd == '\b') || (chRcvd == 0x7F))
     {
-        UART_putStringSerial("\b \b");
-        ubyUrtInBuffLdrIndx--;
-        return;
+        if (pUart->u16RxLineLen != 0)
+        {
+            pUart->u16RxLineLen--;
+            pUart->u16RxLdrIndx = (pUart->u16RxLdrIndx == 0) ? (pUart->u16RxBuffSz - 1) : (pUart->u16RxLdrIndx - 1);
+            UART_rxEcho(pUart, "\b \b", 3);
+        }
+        pUart->bRxLastCr = false;
+        return false;
     }
 
-    UART_echoCharacter();
+    // CR or LF (Enter) ends the line; NULL
+    if ((chRcvd == '\r') || (chRcvd == '\n'))
+    {
+        if ((chRcvd == '\n') && pUart->bRxLastCr)
+        {
+            pUart->bRxLastCr = false;
+            return false;
+        }
+        pUart->bRxLastCr = (chRcvd == '\r');
 
+        // a char is only taken with room left for its NULL; an empty line may not fit
+        if ((pUart->u16RxLineLen == 0) && (UART_rxUsed(pUart) >= pUart->u16RxBuffSz - 1))
+        {
+            pUart->stRxStats.u16Dropped++;
+            return false;
+        }
+        UART_rxPut(pUart, '\0');
+        pUart->u16RxLineLen = 0;
+        pUart->ubyRxLines++;
+        pUart->stRxStats.u32Lines++;
+        UART_rxEcho(pUart, "\r\n", 2);
+        gstMainEvts.bits.svcUartRx = true;
+        return true;
+    }
+    pUart->bRxLastCr = false;
 
-    // if received CR or LF (Enter) replace ch with end of string; NULL
-    if(chRcvd == '\r' || chRcvd == '\n')
+    u16Used = UART_rxUsed(pUart);
+    if ((pUart->u16RxLineLen >= UART_RX_LINE_MAX) || (u16Used >= pUart->u16RxBuffSz - 2))
     {
-        achUartInputBuffer[ubyUrtInBuffLdrIndx++] = NULL;
-        UART_EnableDisableRxInt(UART_DISABLE_RXINT);
-        enableDisableTimer(&gstCopySeralCmdToCmdBuffTmr, TMR_ENABLE);
+        pUart->stRxStats.u16Dropped++;
+        return false;
     }
-    else
+
+    UART_rxPut(pUart, chRcvd);
+    pUart->u16RxLineLen++;
+    if (++u16Used > pUart->stRxStats.u16HighWater)
     {
-        // increment loader index
-        ubyUrtInBuffLdrIndx++;
+        pUart->stRxStats.u16HighWater = u16Used;
     }
+    UART_rxEcho(pUart, &chRcvd, 1);
+
+    return false;
+}
 
-    /*
-     * Ideal case: handle received data so that over run does
-     *             not occur.
-     * Overrun:    if overrun occur, overwrite last character
-     * Overrun indicator:
-     *             if InputIndex == OutputIndex
-     */
 
-    if (ubyUrtInBuffLdrIndx >= SERIAL_BUFFER_SZ)
+// bytes queued in pachTxBuff[]
+static uint16_t UART_txUsed(stUartInst_t* pUart, uint16_t u16UnLdrIndx)
+{
+    if (pUart->u16TxLdrIndx >= u16UnLdrIndx)
     {
-        ubyUrtInBuffLdrIndx = 0;
+        return pUart->u16TxLdrIndx - u16UnLdrIndx;
     }
 
-    // handle over run case
-    if (ubyUrtInBuffLdrIndx == ubyUrtInBuffUnLdIndx)
+    return pUart->u16TxBuffSz - u16UnLdrIndx + pUart->u16TxLdrIndx;
+}
+
+
+static uint16_t UART_txRoomInst(stUartInst_t* pUart)
+{
+    return (pUart->u16TxBuffSz - 1) - UART_txUsed(pUart, pUart->u16TxUnLdrIndx);
+}
+
+
+// bytes that can be written now; one slot is kept empty
+uint16_t UART_txRoom(eUartNum_t eUartNum)
+{
+    return UART_txRoomInst(&astUart[eUartNum]);
+}
+
+
+/*
+ * UART_txPublish(): hands the bytes up to u16LdrIndx to the tx isr.
+ *  interrupts are masked for the index update and the transmitter prime.
+ */
+static void UART_txPublish(stUartInst_t* pUart, uint16_t u16LdrIndx)
+{
+    uint16_t u16Used;
+
+    __disable_interrupt();
+    pUart->u16TxLdrIndx = u16LdrIndx;
+
+    // If we aren't expecting any more TX interrupts, send the
+    // character now to prime the pump
+    if (!pUart->bXmitBusy)
     {
-        if(ubyUrtInBuffUnLdIndx == 0)
-        {
-            ubyUrtInBuffLdrIndx = SERIAL_BUFFER_SZ -1;
-        }
-        else
+        pUart->bXmitBusy = true;
+        *pUart->stRegs.pUartTxBuffReg = pUart->pachTxBuff[pUart->u16TxUnLdrIndx];
+
+        if (++pUart->u16TxUnLdrIndx >= pUart->u16TxBuffSz)
         {
-            ubyUrtInBuffLdrIndx--;
+            pUart->u16TxUnLdrIndx = 0;
         }
     }
-}
+    __enable_interrupt();
 
+    u16Used = UART_txUsed(pUart, pUart->u16TxUnLdrIndx);
+    if (u16Used > pUart->stTxStats.u16HighWater)
+    {
+        pUart->stTxStats.u16HighWater = u16Used;
+    }
+}
 
 
-void UART_echoCharacter(void)
+/*
+ * UART_write(): queues up to u16Len bytes of stream eStream; never blocks.
+ *  bWhole: all or nothing; a line or field is not cut.
+ *  returns the bytes accepted, the rest count as drops of the stream.
+ *  the copy runs with interrupts on; the tx isr only reads queued bytes.
+ */
+uint16_t UART_write(eUartNum_t eUartNum, eUartStream_t eStream, const char* pchData, uint16_t u16Len, bool bWhole)
 {
-    char chRcvd;
+    stUartInst_t* pUart   = &astUart[eUartNum];
+    uint16_t      u16Room = UART_txRoomInst(pUart);
+    uint16_t      u16Indx = pUart->u16TxLdrIndx;
+    uint16_t      u16Cnt;
+    uint16_t      u16Pos;
 
-    chRcvd = achUartInputBuffer[ubyUrtInBuffLdrIndx];
+    if ((u16Len > u16Room) && bWhole)
+    {
+        u16Room = 0;
+    }
+    u16Cnt = (u16Len > u16Room) ? u16Room : u16Len;
+    pUart->stTxStats.au32Drops[eStream] += u16Len - u16Cnt;
 
-    // load rcv'd char into output buffer (echo)
-    // if received CR or LF (Enter) replace ch with end of string; NULL
-    if(chRcvd == '\r' || chRcvd == '\n')
+    if (u16Cnt == 0)
     {
-        // schedule to output new line
-        achUartOutputBuffer[ubyUrtOutBuffLdrIndx++] = '\r';
-        achUartOutputBuffer[ubyUrtOutBuffLdrIndx++] = '\n';
+        return 0;
     }
-    else
+
+    for (u16Pos=0; u16Pos<u16Cnt; u16Pos++)
     {
-        // output received data
-        achUartOutputBuffer[ubyUrtOutBuffLdrIndx++] = chRcvd;
+        pUart->pachTxBuff[u16Indx] = pchData[u16Pos];
+        if (++u16Indx >= pUart->u16TxBuffSz)
+        {
+            u16Indx = 0;
+        }
     }
+    UART_txPublish(pUart, u16Indx);
+
+    return u16Cnt;
+}
+
 
-    // handler output index boundary
-    if (ubyUrtOutBuffLdrIndx >= SERIAL_BUFFER_SZ)
+/*
+ * staged output; main context only, one at a time. UART_txStage() copies
+ *  into the output ring past the loader index, nothing goes out before
+ *  UART_txCommit(). fmt.c formats in place with it.
+ */
+void UART_txStageBegin(eUartNum_t eUartNum)
+{
+    stUartInst_t* pUart = &astUart[eUartNum];
+
+    pUart->u16TxStageIndx = pUart->u16TxLdrIndx;
+    pUart->u16TxStageLen  = 0;
+    pUart->u16TxStageLost = 0;
+}
+
+
+// returns the bytes staged; once some did not fit nothing more is taken
+uint16_t UART_txStage(eUartNum_t eUartNum, const char* pchData, uint16_t u16Len)
+{
+    stUartInst_t* pUart   = &astUart[eUartNum];
+    uint16_t      u16Room = UART_txRoomInst(pUart) - pUart->u16TxStageLen;
+    uint16_t      u16Indx = pUart->u16TxStageIndx;
+    uint16_t      u16Cnt;
+    uint16_t      u16Pos;
+
+    if (pUart->u16TxStageLost)
     {
-        ubyUrtOutBuffLdrIndx = 0;
+        u16Room = 0;
     }
+    u16Cnt = (u16Len > u16Room) ? u16Room : u16Len;
+    pUart->u16TxStageLost += u16Len - u16Cnt;
 
-    // if transmitter is idle, start a tx transaction here
-    // else ISR will transmit it when ready
-    if (bUartXmitBusy == false)
+    for (u16Pos=0; u16Pos<u16Cnt; u16Pos++)
     {
-        bUartXmitBusy = true;
-        *stUartRegsAddress.pUartTxBuffReg = achUartOutputBuffer[ubyUrtOutBuffUnLdrIndx++];
-        if(ubyUrtOutBuffUnLdrIndx >= SERIAL_BUFFER_SZ)
+        pUart->pachTxBuff[u16Indx] = pchData[u16Pos];
+        if (++u16Indx >= pUart->u16TxBuffSz)
         {
-            ubyUrtOutBuffUnLdrIndx = 0;
+            u16Indx = 0;
         }
     }
+    pUart->u16TxStageIndx = u16Indx;
+    pUart->u16TxStageLen += u16Cnt;
+
+    return u16Cnt;
 }
 
 
-void UART_svcUartTx(void)
+/*
+ * UART_txCommit(): sends the staged bytes as stream eStream; bWhole as
+ *  UART_write(). returns the bytes sent.
+ */
+uint16_t UART_txCommit(eUartNum_t eUartNum, eUartStream_t eStream, bool bWhole)
 {
-    gstMainEvts.bits.svcUartTx = false;
+    stUartInst_t* pUart  = &astUart[eUartNum];
+    uint16_t      u16Cnt = pUart->u16TxStageLen;
 
-    // if data is in UART transmit buffer send
-    // else, if last sent data generated int, mark UART Xmiter is idle
-    if (ubyUrtOutBuffLdrIndx != ubyUrtOutBuffUnLdrIndx)
+    if (bWhole && pUart->u16TxStageLost)
     {
-        *stUartRegsAddress.pUartTxBuffReg = achUartOutputBuffer[ubyUrtOutBuffUnLdrIndx++];
-        if(ubyUrtOutBuffUnLdrIndx >= SERIAL_BUFFER_SZ)
-        {
-            ubyUrtOutBuffUnLdrIndx = 0;
-        }
+        pUart->u16TxStageLost += u16Cnt;
+        u16Cnt = 0;
     }
-    else
+    pUart->stTxStats.au32Drops[eStream] += pUart->u16TxStageLost;
+    pUart->u16TxStageLen  = 0;
+    pUart->u16TxStageLost = 0;
+
+    if (u16Cnt)
     {
-        bUartXmitBusy = false;
+        UART_txPublish(pUart, pUart->u16TxStageIndx);
     }
+
+    return u16Cnt;
+}
+
+
+uint16_t UART_putStringStream(eUartNum_t eUartNum, eUartStream_t eStream, const char *string)
+{
+    return UART_write(eUartNum, eStream, string, strlen(string), false);
+}
+
+
+void UART_putStringSerial(char *string)
+{
+    UART_write(UART_CLI, UART_STREAM_CLI, string, strlen(string), false);
 }
 
 
-void UART_putStringSerial(char *string)  // Blocking
+/*
+ * UART_notifyTxRoom(): pfnCb is called from main (svcUartTxRoom) once
+ *  u16Room bytes can be written; UART_TX_ALL_SENT => all sent.
+ *  one request per instance; false while another one is pending (its
+ *  callback may re-request from within).
+ */
+bool UART_notifyTxRoom(eUartNum_t eUartNum, uint16_t u16Room, void (*pfnCb)(void))
 {
-    // Block while we don't have room for the string
-    do
+    stUartInst_t* pUart = &astUart[eUartNum];
+
+    if (pUart->pfnTxRoomCb != NULL)
+    {
+        return false;
+    }
+    if (u16Room > pUart->u16TxBuffSz - 1)
     {
-        __no_operation();
-    } while (bUartXmitBusy && (ubyUrtOutBuffLdrIndx == ubyUrtOutBuffUnLdrIndx)) ;
+        u16Room = pUart->u16TxBuffSz - 1;
+    }
 
     __disable_interrupt();
-    while ( *string != 0 )
+    pUart->pfnTxRoomCb  = pfnCb;
+    pUart->u16TxRoomReq = u16Room;
+    pUart->bTxRoomReady = false;
+    if (UART_txRoomInst(pUart) >= u16Room)
     {
-        achUartOutputBuffer[ubyUrtOutBuffLdrIndx++] = *string++;
-        // if run out of transmit buffer, overwrite the last char
+        // there already; the isr may not run again
+        pUart->u16TxRoomReq = 0;
+        pUart->bTxRoomReady = true;
+        gstMainEvts.bits.svcUartTxRoom = true;
+    }
+    __enable_interrupt();
+
+    return true;
+}
 
-        if(ubyUrtOutBuffLdrIndx == ubyUrtOutBuffUnLdrIndx)
+
+bool UART_txRoomPending(eUartNum_t eUartNum)
+{
+    return astUart[eUartNum].pfnTxRoomCb != NULL;
+}
+
+
+void UART_svcUartTxRoom(void)
+{
+    void (*pfnCb)(void);
+    uint8_t ubyUart;
+
+    gstMainEvts.bits.svcUartTxRoom = false;
+
+    for (ubyUart=0; ubyUart<NUM_UARTS; ubyUart++)
+    {
+        if (!astUart[ubyUart].bTxRoomReady)
         {
-        // handle over run case
-            if(ubyUrtOutBuffUnLdrIndx == 0)
-            {
-                ubyUrtOutBuffLdrIndx = SERIAL_BUFFER_SZ -1;
-            }
-            else
-            {
-                ubyUrtOutBuffLdrIndx--;
-            }
+            continue;
+        }
+
+        astUart[ubyUart].bTxRoomReady = false;
+        pfnCb = astUart[ubyUart].pfnTxRoomCb;
+        astUart[ubyUart].pfnTxRoomCb = NULL;
+
+        if (pfnCb != NULL)
+        {
+            pfnCb();
         }
     }
+}
 
-    /*
-     * txIntsStopped will be set to TRUE by ISR when completed transmitting
-     *  all pending chars from OutBuff. If ISR is still in a middle of a
-     *  transfer, the content of this semaphore, txIntsStopped, remain FALSE.
-     *  this function, when reaching here need do nothing if ISR is in a
-     *  middle of a transfer.
-     * ISR will continue to transmit out all chars, including the current
-     *  payload just loaded, since the end of a transfer is identified by
-     *  the state of the indices.
-     */
 
-    // If we aren't expecting any more TX interrupts, send the
-    // character now to prime the pump
-    if (!bUartXmitBusy)
+/*
+ * UART_txIsr(): transmit buffer empty. sends the next echo byte, else the
+ *  next byte of the output buffer, or marks the transmitter idle; the
+ *  interrupt flag was cleared by the UCAxIV read.
+ * returns true when the room asked by UART_notifyTxRoom() is there; the
+ *  isr wakes main then.
+ */
+static inline bool UART_txIsr(stUartInst_t* pUart)
+{
+    if (pUart->ubyEchoLdrIndx != pUart->ubyEchoUnLdrIndx)
     {
-        bUartXmitBusy = true;
-        *stUartRegsAddress.pUartTxBuffReg = achUartOutputBuffer[ubyUrtOutBuffUnLdrIndx++];
-
-        if (ubyUrtOutBuffUnLdrIndx >= SERIAL_BUFFER_SZ)
+        *pUart->stRegs.pUartTxBuffReg = pUart->achEchoBuff[pUart->ubyEchoUnLdrIndx];
+        pUart->ubyEchoUnLdrIndx = (pUart->ubyEchoUnLdrIndx + 1) & UART_ECHO_MASK;
+    }
+    else if (pUart->u16TxLdrIndx == pUart->u16TxUnLdrIndx)
+    {
+        pUart->bXmitBusy = false;
+    }
+    else
+    {
+        *pUart->stRegs.pUartTxBuffReg = pUart->pachTxBuff[pUart->u16TxUnLdrIndx];
+        if (++pUart->u16TxUnLdrIndx >= pUart->u16TxBuffSz)
         {
-            ubyUrtOutBuffUnLdrIndx = 0;
+            pUart->u16TxUnLdrIndx = 0;
         }
     }
-    __enable_interrupt();
+
+    if (pUart->u16TxRoomReq && (UART_txRoomInst(pUart) >= pUart->u16TxRoomReq))
+    {
+        pUart->u16TxRoomReq = 0;
+        pUart->bTxRoomReady = true;
+        gstMainEvts.bits.svcUartTxRoom = true;
+        return true;
+    }
+
+    return false;
 }
 
 
 void UART_testTransmit(void)
 {
-    char     achStringBuff[128];
     uint16_t wTempVar = 1234;
 //    uint32_t lwTempVar = 98763;
     gstMainEvts.bits.svcTestUartTx = false;
-    sprintf (achStringBuff, "TemVar value is: %d.", wTempVar);
-    UART_putStringSerial(achStringBuff);
+    fmtBegin(UART_CLI);
+    fmtStr("TemVar value is: ");
+    fmtUint(wTempVar, 0);
+    fmtChar('.');
+    fmtEnd(UART_STREAM_CLI, false);
     UART_printNewLineAndPrompt();
 }
 
@@ -473,31 +1080,21 @@ void __attribute__ ((interrupt(USCI_A0_VECTOR))) USCI_A0_ISR (void)
     {
         case USCI_NONE: break;      // case 0
 
-        case USCI_UART_UCRXIFG:     // case 2 // Receive buffer empty
-            // store error condition before being cleared by reading the receive buffer
-            // currently not making use of it.
-            ui16RcvStatus = *stUartRegsAddress.pUartStatus;
-
-            // UCRXIFG is automatically reset when UCAxRXBUF is read.
-            // don't inc; might need to update ch if ch recv'd is '\r' or '\n'
-            achUartInputBuffer[ubyUrtInBuffLdrIndx] = *stUartRegsAddress.pUartRxBuffReg;
-            gstMainEvts.bits.svcUartRx = true;
-            __bic_SR_register_on_exit(LPM0_bits);
+        case USCI_UART_UCRXIFG:     // case 2 // Receive buffer full
+            // main is woken per line, not per char
+            if (UART_rxIsr(&astUart[UART_A0]))
+            {
+                __bic_SR_register_on_exit(LPM0_bits);
+            }
             break;
 
 
         case USCI_UART_UCTXIFG:     //case 4 // Transmit buffer empty
-            // handle transaction from main
-            if(ubyUrtOutBuffLdrIndx == ubyUrtOutBuffUnLdrIndx)
+            // on exit only works in the isr itself
+            if (UART_txIsr(&astUart[UART_A0]))
             {
-                bUartXmitBusy = false;
+                __bic_SR_register_on_exit(LPM0_bits);
             }
-            else
-            {
-                gstMainEvts.bits.svcUartTx = true;
-            }
-            __bic_SR_register_on_exit(LPM0_bits);
-
             break;
 
         case USCI_UART_UCSTTIFG:    // case 6
@@ -530,31 +1127,21 @@ void __attribute__ ((interrupt(USCI_A1_VECTOR))) USCI_A1_ISR (void)
         {
         case USCI_NONE: break;      // case 0
 
-        case USCI_UART_UCRXIFG:     // case 2 // Receive buffer empty
-            // store error condition before being cleared by reading the receive buffer
-            // currently not making use of it.
-            ui16RcvStatus = *stUartRegsAddress.pUartStatus;
-
-            // UCRXIFG is automatically reset when UCAxRXBUF is read.
-            // don't inc; might need to update ch if ch recv'd is '\r' or '\n'
-            achUartInputBuffer[ubyUrtInBuffLdrIndx] = *stUartRegsAddress.pUartRxBuffReg;
-            gstMainEvts.bits.svcUartRx = true;
-            __bic_SR_register_on_exit(LPM0_bits);
+        case USCI_UART_UCRXIFG:     // case 2 // Receive buffer full
+            // main is woken per line, not per char
+            if (UART_rxIsr(&astUart[UART_A1]))
+            {
+                __bic_SR_register_on_exit(LPM0_bits);
+            }
             break;
 
 
         case USCI_UART_UCTXIFG:     //case 4 // Transmit buffer empty
-            // handle transaction from main
-            if(ubyUrtOutBuffLdrIndx == ubyUrtOutBuffUnLdrIndx)
-            {
-                bUartXmitBusy = false;
-            }
-            else
+            // on exit only works in the isr itself
+            if (UART_txIsr(&astUart[UART_A1]))
             {
-                gstMainEvts.bits.svcUartTx = true;
+                __bic_SR_register_on_exit(LPM0_bits);
             }
-            __bic_SR_register_on_exit(LPM0_bits);
-
             break;
 
         case USCI_UART_UCSTTIFG:    // case 6
@@ -564,4 +1151,3 @@ void __attribute__ ((interrupt(USCI_A1_VECTOR))) USCI_A1_ISR (void)
             break;      // Transmit complete
     }
 }
-
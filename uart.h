@@ -36,6 +36,11 @@ typedef enum UART_NUMBER
     UART_A1
 }eUartNum_t;
 
+#define NUM_UARTS               (2)
+
+// UART_notifyTxRoom(); the output buffer is empty
+#define UART_TX_ALL_SENT        (0xFFFF)
+
 
 // since baud rate is used by diagnostics, in addition to
 //  configuration, need to tag the baud rate used within
@@ -46,9 +51,21 @@ typedef enum UART_BAUD
     UART_BAUD_19200  = 19200,
     UART_BAUD_38400  = 38400,
     UART_BAUD_57600  = 57600,
-    UART_BAUD_115200 = 115200
+    UART_BAUD_115200 = 115200,
+    UART_BAUD_230400 = 230400,
+    UART_BAUD_460800 = 460800,
+    UART_BAUD_921600 = 921600,
+    UART_BAUD_1M     = 1000000
 }eUartBaud_t;
 
+// baud rate generator settings for a rate; UART_CalcBaud()
+typedef struct UART_BAUD_CFG
+{
+    uint16_t u16Brw;            // UCBRx
+    uint16_t u16Mctlw;          // UCBRSx << 8 | UCBRFx << 4 | UCOS16
+    int16_t  i16ErrCentiPct;    // worst bit error of a frame; 0.01% of a bit
+}stUartBaudCfg_t;
+
 
 typedef struct UART_GRP_REGS_ADDRESS
 {
@@ -65,26 +82,70 @@ typedef struct UART_GRP_REGS_ADDRESS
     volatile uint16_t* pUartIntFlag;
 }UART_GrpRegsAddress_t;
 
-extern char achUartInputBuffer[];
-extern char achUartOutputBuffer[];
-extern uint8_t ubyUrtInBuffLdrIndx;
-extern uint8_t ubyUrtInBuffUnLdIndx;
-extern uint8_t ubyUrtOutBuffLdrIndx;
-extern uint8_t ubyUrtOutBuffUnLdrIndx;
+/*
+ * output streams; bytes a stream could not queue are counted per stream
+ */
+typedef enum UART_STREAM
+{
+    UART_STREAM_CLI,        // command replies, reports
+    UART_STREAM_ECHO,       // echo of the received chars
+    UART_STREAM_DIAG,       // periodic diag data
+    UART_STREAM_TLM,        // binary telemetry
+    NUM_UART_STREAMS
+}eUartStream_t;
+
+typedef struct UART_TX_STATS
+{
+    uint32_t au32Drops[NUM_UART_STREAMS];   // bytes not accepted
+    uint16_t u16HighWater;                  // most bytes queued
+}stUartTxStats_t;
+
+// receive errors (UCAxSTATW) and chars the input ring could not keep
+typedef struct UART_RX_STATS
+{
+    uint16_t u16Overrun;        // UCOE; a char was lost in the receiver
+    uint16_t u16Framing;        // UCFE; the char is dropped
+    uint16_t u16Parity;         // UCPE
+    uint16_t u16Dropped;        // ring full or line longer than UART_RX_LINE_MAX
+    uint16_t u16HighWater;      // most chars queued
+    uint32_t u32Lines;          // lines received
+}stUartRxStats_t;
 
 void UART_GetUartRegsAddress(eUartNum_t eUartNum);
 void UART_CfgPortForUartUsage(eUartNum_t eUartNum);
 void UART_CfgUart(eUartNum_t eUartNum, eUartClk_t eUartClk,
-                  eUartBaud_t eBaudRate, bool bRxInt, bool bTxInt);
-void UART_CfgUartCtrlWord0(eUartClk_t eUartClk);
-void UART_CfgUartBaud(uint32_t ui32BaudRate);
-void UART_EnableDisableRxInt(bool bEnableDisabeRxInt);
-void UART_EnableDisableTxInt(bool bEnableDisabeTxInt);
-void UART_HoldReleaseFromRst(bool bRelHold);
-
-void UART_svcUartRx(void);
-void UART_svcUartTx(void);
-void UART_echoCharacter(void);
+                  uint32_t u32BaudRate, bool bRxInt, bool bTxInt);
+void UART_CfgUartCtrlWord0(eUartNum_t eUartNum, eUartClk_t eUartClk);
+bool UART_CfgUartBaud(eUartNum_t eUartNum, uint32_t u32BaudRate);
+bool UART_CalcBaud(uint32_t u32ClkHz, uint32_t u32BaudRate, stUartBaudCfg_t* pstBaudCfg);
+bool UART_CalcBaudInUse(eUartNum_t eUartNum, uint32_t u32BaudRate, stUartBaudCfg_t* pstBaudCfg);
+bool UART_SetBaud(eUartNum_t eUartNum, uint32_t u32BaudRate);
+uint32_t UART_getBaud(eUartNum_t eUartNum);
+bool UART_isCfg(eUartNum_t eUartNum);
+void UART_EnableDisableRxInt(eUartNum_t eUartNum, bool bEnableDisabeRxInt);
+void UART_EnableDisableTxInt(eUartNum_t eUartNum, bool bEnableDisabeTxInt);
+void UART_HoldReleaseFromRst(eUartNum_t eUartNum, bool bRelHold);
+void deInitUart(eUartNum_t eUartNum);
+
+const stUartTxStats_t* UART_getTxStats(eUartNum_t eUartNum);
+const stUartRxStats_t* UART_getRxStats(eUartNum_t eUartNum);
+uint16_t UART_txBuffSz(eUartNum_t eUartNum);
+uint16_t UART_rxBuffSz(eUartNum_t eUartNum);
+
+bool UART_rxLineReady(eUartNum_t eUartNum);
+bool UART_getLine(eUartNum_t eUartNum, char* pchLine, uint16_t u16Max);
+uint16_t UART_read(eUartNum_t eUartNum, uint8_t* pubyData, uint16_t u16Max);
+uint16_t UART_txRoom(eUartNum_t eUartNum);
+uint16_t UART_write(eUartNum_t eUartNum, eUartStream_t eStream, const char* pchData, uint16_t u16Len, bool bWhole);
+uint16_t UART_putStringStream(eUartNum_t eUartNum, eUartStream_t eStream, const char *string);
+void UART_txStageBegin(eUartNum_t eUartNum);
+uint16_t UART_txStage(eUartNum_t eUartNum, const char* pchData, uint16_t u16Len);
+uint16_t UART_txCommit(eUartNum_t eUartNum, eUartStream_t eStream, bool bWhole);
+bool UART_notifyTxRoom(eUartNum_t eUartNum, uint16_t u16Room, void (*pfnCb)(void));
+bool UART_txRoomPending(eUartNum_t eUartNum);
+void UART_svcUartTxRoom(void);
+
+// the cli instance (UART_CLI)
 void UART_putStringSerial(char *string);
 void UART_testTransmit(void);
 void UART_printNewLineAndPrompt(void);
@@ -92,7 +153,4 @@ void UART_printNewLine(void);
 void UART_printPrompt(void);
 
 
-extern UART_GrpRegsAddress_t stUartRegsAddress;
-
-
 #endif /* UART_H_ */